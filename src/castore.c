@@ -0,0 +1,759 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       castore.c
+
+   Version:    V1.4
+   Date:       16.10.26
+   Function:   Compact C-alpha store used by the core finding code
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Description:
+   ============
+   The core definition only ever looks at the C-alphas, stepping along
+   them in sequence and comparing coordinates. Rather than duplicating
+   the PDB linked list and walking pointers into full PDB records, the
+   C-alphas are copied once into parallel arrays so the inner loops
+   scan contiguous memory.
+
+   Zones are specified by residue number, so each store also has a
+   direct-mapped table from residue number to position. PDB residue
+   numbers are at most 4 columns wide so the table is never large.
+
+   Core membership is a bitset so counting the core and looking for
+   runs of core or non-core residues can be done a word at a time.
+
+   Each fit only records the rotation and translation. The core loop
+   looks at a handful of residues around the zone ends after each fit,
+   so fitted coordinates are worked out as they are needed rather than
+   moving the whole structure every time.
+
+   A store may instead hold its coordinates as floats. That halves the
+   memory the distance checks stream through and doubles the number of
+   C-alphas each vector instruction handles. Only the coordinates and
+   the distances are single precision; the fitting sums are still
+   accumulated in double.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 Added residue number lookup table
+   V1.2  16.10.26 Core flags are held as a bitset
+   V1.3  16.10.26 Holds the current fit as a transform rather than a
+                  fitted copy of the coordinates
+   V1.4  16.10.26 Optional single precision coordinates
+
+*************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+#include "bioplib/pdb.h"
+#include "bioplib/macros.h"
+#include "castore.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+static int PopCount(unsigned long word);
+static int LowestBit(unsigned long word);
+static int HighestBit(unsigned long word);
+static unsigned long RangeMask(int word, int first, int last);
+static void SetSingleFit(CASTORE *cas);
+static void CAFittedSingle(CASTORE *cas, int i, float out[3]);
+
+
+/************************************************************************/
+/*>CASTORE *BuildCAStore(PDB *pdb, BOOL single)
+   --------------------------------------------
+   Input:   PDB      *pdb       PDB linked list
+            BOOL     single     Hold the coordinates in single
+                                precision
+   Returns: CASTORE  *          C-alpha store (NULL if no memory)
+
+   Copies the C-alphas out of a PDB linked list into a new C-alpha
+   store. The fit starts as the identity and nothing is flagged as
+   core.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Builds the residue number lookup table
+   16.10.26 Sets an identity fit instead of copying the coordinates
+   16.10.26 Added single
+*/
+CASTORE *BuildCAStore(PDB *pdb, BOOL single)
+{
+   CASTORE *cas;
+   PDB     *p;
+   int     i,
+           n      = 0,
+           maxres = 0;
+
+   for(p=pdb; p!=NULL; NEXT(p))
+   {
+      if(!strncmp(p->atnam, "CA  ", 4))
+         n++;
+   }
+
+   if((cas = (CASTORE *)malloc(sizeof(CASTORE)))==NULL)
+      return(NULL);
+
+   cas->ncas   = n;
+   cas->single = single;
+   if(n==0) n  = 1;
+   cas->x  = cas->y  = cas->z  = NULL;
+   cas->sx = cas->sy = cas->sz = NULL;
+   if(single)
+   {
+      cas->sx  = (float *)malloc(n * sizeof(float));
+      cas->sy  = (float *)malloc(n * sizeof(float));
+      cas->sz  = (float *)malloc(n * sizeof(float));
+   }
+   else
+   {
+      cas->x   = (REAL *)malloc(n * sizeof(REAL));
+      cas->y   = (REAL *)malloc(n * sizeof(REAL));
+      cas->z   = (REAL *)malloc(n * sizeof(REAL));
+   }
+   cas->resnum = (int  *)malloc(n * sizeof(int));
+   cas->insert = (char *)malloc(n * sizeof(char));
+   cas->chain  = (char *)malloc(n * CAS_CHAINLEN * sizeof(char));
+   /* One spare bit so that looking one past the end reads as 0       */
+   cas->ncorewords = (n + CAWORDBITS) / CAWORDBITS;
+   cas->core   = (unsigned long *)malloc(cas->ncorewords *
+                                         sizeof(unsigned long));
+   cas->residx = NULL;
+
+   if((single ? ((cas->sx==NULL) || (cas->sy==NULL) || (cas->sz==NULL))
+              : ((cas->x==NULL)  || (cas->y==NULL)  || (cas->z==NULL)))  ||
+      (cas->resnum==NULL) || (cas->insert==NULL) ||
+      (cas->chain==NULL)  || (cas->core==NULL))
+   {
+      FreeCAStore(cas);
+      return(NULL);
+   }
+
+   cas->CofG.x = cas->CofG.y = cas->CofG.z = (REAL)0.0;
+   for(p=pdb, i=0; p!=NULL; NEXT(p))
+   {
+      if(!strncmp(p->atnam, "CA  ", 4))
+      {
+         if(single)
+         {
+            cas->sx[i] = (float)p->x;
+            cas->sy[i] = (float)p->y;
+            cas->sz[i] = (float)p->z;
+         }
+         else
+         {
+            cas->x[i] = p->x;
+            cas->y[i] = p->y;
+            cas->z[i] = p->z;
+         }
+         cas->resnum[i] = p->resnum;
+         cas->insert[i] = p->insert[0];
+         strncpy(cas->chain + i*CAS_CHAINLEN, p->chain, CAS_CHAINLEN);
+         cas->chain[i*CAS_CHAINLEN + CAS_CHAINLEN - 1] = '\0';
+
+         cas->CofG.x += p->x;
+         cas->CofG.y += p->y;
+         cas->CofG.z += p->z;
+         i++;
+      }
+   }
+
+   ClearCACore(cas);
+   ClearCAFit(cas);
+
+   if(cas->ncas)
+   {
+      cas->CofG.x /= cas->ncas;
+      cas->CofG.y /= cas->ncas;
+      cas->CofG.z /= cas->ncas;
+   }
+
+   /* Build the residue number lookup. Where a residue number appears
+      more than once (inserts or multiple chains) we keep the first
+      occurrence
+   */
+   cas->minres = (cas->ncas ? cas->resnum[0] : 0);
+   maxres      = cas->minres;
+   for(i=1; i<cas->ncas; i++)
+   {
+      if(cas->resnum[i] < cas->minres) cas->minres = cas->resnum[i];
+      if(cas->resnum[i] > maxres)      maxres      = cas->resnum[i];
+   }
+   cas->nresidx = maxres - cas->minres + 1;
+   if((cas->residx = (int *)malloc(cas->nresidx * sizeof(int)))==NULL)
+   {
+      FreeCAStore(cas);
+      return(NULL);
+   }
+   for(i=0; i<cas->nresidx; i++)
+      cas->residx[i] = (-1);
+   for(i=cas->ncas-1; i>=0; i--)
+      cas->residx[cas->resnum[i] - cas->minres] = i;
+
+   return(cas);
+}
+
+
+/************************************************************************/
+/*>void FreeCAStore(CASTORE *cas)
+   ------------------------------
+   I/O:     CASTORE  *cas       C-alpha store
+
+   Frees a C-alpha store. May be given NULL.
+
+   16.10.26 Original   By: ACRM
+*/
+void FreeCAStore(CASTORE *cas)
+{
+   if(cas == NULL)
+      return;
+
+   FREE(cas->x);
+   FREE(cas->y);
+   FREE(cas->z);
+   FREE(cas->sx);
+   FREE(cas->sy);
+   FREE(cas->sz);
+   FREE(cas->resnum);
+   FREE(cas->insert);
+   FREE(cas->chain);
+   FREE(cas->core);
+   FREE(cas->residx);
+   free(cas);
+}
+
+
+/************************************************************************/
+/*>void ClearCACore(CASTORE *cas)
+   ------------------------------
+   I/O:     CASTORE  *cas       C-alpha store
+
+   Removes all residues from the core
+
+   16.10.26 Original   By: ACRM
+*/
+void ClearCACore(CASTORE *cas)
+{
+   memset(cas->core, 0, cas->ncorewords * sizeof(unsigned long));
+}
+
+
+/************************************************************************/
+/*>int CountCACore(CASTORE *cas)
+   -----------------------------
+   Input:   CASTORE  *cas       C-alpha store
+   Returns: int                 Number of residues in the core
+
+   Count how many residues are in the core regions
+
+   16.10.26 Original based on CountCore()   By: ACRM
+   16.10.26 Counts a word at a time
+*/
+int CountCACore(CASTORE *cas)
+{
+   int i,
+       count = 0;
+
+   for(i=0; i<cas->ncorewords; i++)
+      count += PopCount(cas->core[i]);
+
+   return(count);
+}
+
+
+/************************************************************************/
+/*>int FindCAResidue(CASTORE *cas, int resnum)
+   -------------------------------------------
+   Input:   CASTORE  *cas       C-alpha store
+            int      resnum     Residue number
+   Returns: int                 Offset of the first C-alpha with this
+                                residue number. cas->ncas if not found
+
+   Finds a residue by number. The not-found value is the same as
+   running off the end of a linear search through the store.
+
+   16.10.26 Original   By: ACRM
+*/
+int FindCAResidue(CASTORE *cas, int resnum)
+{
+   int i;
+
+   i = resnum - cas->minres;
+   if((i < 0) || (i >= cas->nresidx) || (cas->residx[i] < 0))
+      return(cas->ncas);
+
+   return(cas->residx[i]);
+}
+
+
+/************************************************************************/
+/*>int NextCACore(CASTORE *cas, int i)
+   -----------------------------------
+   Input:   CASTORE  *cas       C-alpha store
+            int      i          Where to start looking
+   Returns: int                 Offset of the first core C-alpha at or
+                                after i. cas->ncas if there are none
+
+   16.10.26 Original   By: ACRM
+*/
+int NextCACore(CASTORE *cas, int i)
+{
+   int           w;
+   unsigned long word;
+
+   if(i >= cas->ncas)
+      return(cas->ncas);
+
+   w    = i / CAWORDBITS;
+   word = cas->core[w] & (~0UL << (i % CAWORDBITS));
+   while(word == 0UL)
+   {
+      if(++w >= cas->ncorewords)
+         return(cas->ncas);
+      word = cas->core[w];
+   }
+
+   return(w * CAWORDBITS + LowestBit(word));
+}
+
+
+/************************************************************************/
+/*>int PrevCACore(CASTORE *cas, int i)
+   -----------------------------------
+   Input:   CASTORE  *cas       C-alpha store
+            int      i          Where to start looking
+   Returns: int                 Offset of the last core C-alpha at or
+                                before i. -1 if there are none
+
+   16.10.26 Original   By: ACRM
+*/
+int PrevCACore(CASTORE *cas, int i)
+{
+   int           w;
+   unsigned long word;
+
+   if(i >= cas->ncas)
+      i = cas->ncas - 1;
+   if(i < 0)
+      return(-1);
+
+   w    = i / CAWORDBITS;
+   word = cas->core[w] & (~0UL >> (CAWORDBITS - 1 - (i % CAWORDBITS)));
+   while(word == 0UL)
+   {
+      if(--w < 0)
+         return(-1);
+      word = cas->core[w];
+   }
+
+   return(w * CAWORDBITS + HighestBit(word));
+}
+
+
+/************************************************************************/
+/*>BOOL AnyCACore(CASTORE *cas, int first, int last)
+   -------------------------------------------------
+   Input:   CASTORE  *cas       C-alpha store
+            int      first      First C-alpha of the range
+            int      last       Last C-alpha of the range
+   Returns: BOOL                Any C-alpha in the range is in the core
+
+   16.10.26 Original   By: ACRM
+*/
+BOOL AnyCACore(CASTORE *cas, int first, int last)
+{
+   int w;
+
+   if(last > cas->ncas)
+      last = cas->ncas;
+
+   for(w=first/CAWORDBITS; (first<=last) && (w<=last/CAWORDBITS); w++)
+   {
+      if(cas->core[w] & RangeMask(w, first, last))
+         return(TRUE);
+   }
+
+   return(FALSE);
+}
+
+
+/************************************************************************/
+/*>BOOL AllCACore(CASTORE *cas, int first, int last)
+   -------------------------------------------------
+   Input:   CASTORE  *cas       C-alpha store
+            int      first      First C-alpha of the range
+            int      last       Last C-alpha of the range
+   Returns: BOOL                Every C-alpha in the range is in the
+                                core
+
+   16.10.26 Original   By: ACRM
+*/
+BOOL AllCACore(CASTORE *cas, int first, int last)
+{
+   int           w;
+   unsigned long mask;
+
+   if(last > cas->ncas)
+      last = cas->ncas;
+
+   for(w=first/CAWORDBITS; (first<=last) && (w<=last/CAWORDBITS); w++)
+   {
+      mask = RangeMask(w, first, last);
+      if((cas->core[w] & mask) != mask)
+         return(FALSE);
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static unsigned long RangeMask(int word, int first, int last)
+   -------------------------------------------------------------
+   Input:   int      word       Word of the bitset
+            int      first      First bit of the range
+            int      last       Last bit of the range
+   Returns: unsigned long       Bits of this word within the range
+
+   16.10.26 Original   By: ACRM
+*/
+static unsigned long RangeMask(int word, int first, int last)
+{
+   unsigned long mask = ~0UL;
+   int           lo   = word * CAWORDBITS,
+                 hi   = lo + CAWORDBITS - 1;
+
+   if(first > lo)
+      mask &= ~0UL << (first - lo);
+   if(last < hi)
+      mask &= ~0UL >> (hi - last);
+
+   return(mask);
+}
+
+
+/************************************************************************/
+/*>void SetCAFit(CASTORE *cas, REAL rot[3][3], VEC3F centre, VEC3F shift)
+   ----------------------------------------------------------------------
+   I/O:     CASTORE  *cas       C-alpha store
+   Input:   REAL     rot[3][3]  Rotation matrix: x' = rot . x
+            VEC3F    centre     Centre of rotation
+            VEC3F    shift      Where the centre ends up
+
+   Records where the structure has been fitted to. Nothing is moved;
+   a fitted C-alpha is at rot . (x - centre) + shift.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Keeps the single precision copy up to date
+*/
+void SetCAFit(CASTORE *cas, REAL rot[3][3], VEC3F centre, VEC3F shift)
+{
+   int i, j;
+
+   for(i=0; i<3; i++)
+      for(j=0; j<3; j++)
+         cas->rot[i][j] = rot[i][j];
+
+   cas->centre = centre;
+   cas->shift  = shift;
+   SetSingleFit(cas);
+}
+
+
+/************************************************************************/
+/*>void ClearCAFit(CASTORE *cas)
+   -----------------------------
+   I/O:     CASTORE  *cas       C-alpha store
+
+   Resets the fit to the identity so the fitted coordinates are the
+   ones read in
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Keeps the single precision copy up to date
+*/
+void ClearCAFit(CASTORE *cas)
+{
+   int i, j;
+
+   for(i=0; i<3; i++)
+      for(j=0; j<3; j++)
+         cas->rot[i][j] = (REAL)((i==j)?1.0:0.0);
+
+   cas->centre.x = cas->centre.y = cas->centre.z = (REAL)0.0;
+   cas->shift.x  = cas->shift.y  = cas->shift.z  = (REAL)0.0;
+   SetSingleFit(cas);
+}
+
+
+/************************************************************************/
+/*>static void SetSingleFit(CASTORE *cas)
+   --------------------------------------
+   I/O:     CASTORE  *cas       C-alpha store
+
+   Rounds the fit to single precision for a single precision store
+
+   16.10.26 Original   By: ACRM
+*/
+static void SetSingleFit(CASTORE *cas)
+{
+   int i, j;
+
+   for(i=0; i<3; i++)
+      for(j=0; j<3; j++)
+         cas->srot[i][j] = (float)cas->rot[i][j];
+
+   cas->scentre[0] = (float)cas->centre.x;
+   cas->scentre[1] = (float)cas->centre.y;
+   cas->scentre[2] = (float)cas->centre.z;
+   cas->sshift[0]  = (float)cas->shift.x;
+   cas->sshift[1]  = (float)cas->shift.y;
+   cas->sshift[2]  = (float)cas->shift.z;
+}
+
+
+/************************************************************************/
+/*>void CAFitted(CASTORE *cas, int i, VEC3F *out)
+   ----------------------------------------------
+   Input:   CASTORE  *cas       C-alpha store
+            int      i          C-alpha offset
+   Output:  VEC3F    *out       Fitted coordinates of the C-alpha
+
+   This is the same arithmetic as ApplyFitSums() so a fitted C-alpha
+   ends up exactly where moving the whole structure would put it. An
+   identity fit gives back the coordinates as read.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Handles single precision stores
+*/
+void CAFitted(CASTORE *cas, int i, VEC3F *out)
+{
+   REAL x, y, z;
+
+   if(cas->single)
+   {
+      float s[3];
+
+      CAFittedSingle(cas, i, s);
+      out->x = s[0];
+      out->y = s[1];
+      out->z = s[2];
+      return;
+   }
+
+   x = cas->x[i] - cas->centre.x;
+   y = cas->y[i] - cas->centre.y;
+   z = cas->z[i] - cas->centre.z;
+
+   out->x = cas->rot[0][0]*x + cas->rot[0][1]*y + cas->rot[0][2]*z
+            + cas->shift.x;
+   out->y = cas->rot[1][0]*x + cas->rot[1][1]*y + cas->rot[1][2]*z
+            + cas->shift.y;
+   out->z = cas->rot[2][0]*x + cas->rot[2][1]*y + cas->rot[2][2]*z
+            + cas->shift.z;
+}
+
+
+/************************************************************************/
+/*>static void CAFittedSingle(CASTORE *cas, int i, float out[3])
+   -------------------------------------------------------------
+   Input:   CASTORE  *cas       Single precision C-alpha store
+            int      i          C-alpha offset
+   Output:  float    out[3]     Fitted coordinates of the C-alpha
+
+   CAFitted() in float. The vector distance kernels do the same
+   operations in the same order so they give identical results.
+
+   16.10.26 Original   By: ACRM
+*/
+static void CAFittedSingle(CASTORE *cas, int i, float out[3])
+{
+   float x, y, z;
+   int   k;
+
+   x = cas->sx[i] - cas->scentre[0];
+   y = cas->sy[i] - cas->scentre[1];
+   z = cas->sz[i] - cas->scentre[2];
+
+   for(k=0; k<3; k++)
+   {
+      out[k] = cas->srot[k][0]*x + cas->srot[k][1]*y + cas->srot[k][2]*z
+               + cas->sshift[k];
+   }
+}
+
+
+/************************************************************************/
+/*>void ApplyCAFitPDB(CASTORE *cas, PDB *pdb)
+   ------------------------------------------
+   Input:   CASTORE  *cas       C-alpha store
+   I/O:     PDB      *pdb       PDB linked list to move
+
+   Moves every atom of a structure with the store's current fit. The
+   core is found on the C-alphas alone so this only needs doing once,
+   at the end, if the fitted structure is wanted.
+
+   16.10.26 Original   By: ACRM
+*/
+void ApplyCAFitPDB(CASTORE *cas, PDB *pdb)
+{
+   PDB  *p;
+   REAL x, y, z;
+
+   for(p=pdb; p!=NULL; NEXT(p))
+   {
+      x = p->x - cas->centre.x;
+      y = p->y - cas->centre.y;
+      z = p->z - cas->centre.z;
+
+      p->x = cas->rot[0][0]*x + cas->rot[0][1]*y + cas->rot[0][2]*z
+             + cas->shift.x;
+      p->y = cas->rot[1][0]*x + cas->rot[1][1]*y + cas->rot[1][2]*z
+             + cas->shift.y;
+      p->z = cas->rot[2][0]*x + cas->rot[2][1]*y + cas->rot[2][2]*z
+             + cas->shift.z;
+   }
+}
+
+
+/************************************************************************/
+/*>REAL CADistSq(CASTORE *cas1, int i, CASTORE *cas2, int j)
+   ---------------------------------------------------------
+   Input:   CASTORE  *cas1      First C-alpha store
+            int      i          C-alpha offset in cas1
+            CASTORE  *cas2      Second C-alpha store
+            int      j          C-alpha offset in cas2
+   Returns: REAL                Squared distance between the fitted
+                                C-alphas
+
+   If both stores are single precision so is the distance.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Handles single precision stores
+*/
+REAL CADistSq(CASTORE *cas1, int i, CASTORE *cas2, int j)
+{
+   VEC3F a, b;
+
+   if(cas1->single && cas2->single)
+   {
+      float s1[3], s2[3], d[3];
+
+      CAFittedSingle(cas1, i, s1);
+      CAFittedSingle(cas2, j, s2);
+      d[0] = s1[0] - s2[0];
+      d[1] = s1[1] - s2[1];
+      d[2] = s1[2] - s2[2];
+      return((REAL)(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]));
+   }
+
+   CAFitted(cas1, i, &a);
+   CAFitted(cas2, j, &b);
+
+   return((a.x - b.x) * (a.x - b.x) +
+          (a.y - b.y) * (a.y - b.y) +
+          (a.z - b.z) * (a.z - b.z));
+}
+
+
+/************************************************************************/
+/*>static int PopCount(unsigned long word)
+   ---------------------------------------
+   Input:   unsigned long word  Bitset word
+   Returns: int                 Number of bits set
+
+   16.10.26 Original   By: ACRM
+*/
+static int PopCount(unsigned long word)
+{
+#ifdef __GNUC__
+   return(__builtin_popcountl(word));
+#else
+   int count = 0;
+
+   while(word)
+   {
+      word &= word - 1;
+      count++;
+   }
+   return(count);
+#endif
+}
+
+
+/************************************************************************/
+/*>static int LowestBit(unsigned long word)
+   ----------------------------------------
+   Input:   unsigned long word  Bitset word (not 0)
+   Returns: int                 Position of the lowest bit set
+
+   16.10.26 Original   By: ACRM
+*/
+static int LowestBit(unsigned long word)
+{
+#ifdef __GNUC__
+   return(__builtin_ctzl(word));
+#else
+   int bit = 0;
+
+   while(!(word & 1UL))
+   {
+      word >>= 1;
+      bit++;
+   }
+   return(bit);
+#endif
+}
+
+
+/************************************************************************/
+/*>static int HighestBit(unsigned long word)
+   -----------------------------------------
+   Input:   unsigned long word  Bitset word (not 0)
+   Returns: int                 Position of the highest bit set
+
+   16.10.26 Original   By: ACRM
+*/
+static int HighestBit(unsigned long word)
+{
+#ifdef __GNUC__
+   return(CAWORDBITS - 1 - __builtin_clzl(word));
+#else
+   int bit = 0;
+
+   while(word >>= 1)
+      bit++;
+   return(bit);
+#endif
+}
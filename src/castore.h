@@ -0,0 +1,121 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       castore.h
+
+   Version:    V1.4
+   Date:       16.10.26
+   Function:   Compact C-alpha store used by the core finding code
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 Added residue number lookup table
+   V1.2  16.10.26 Core flags are held as a bitset
+   V1.3  16.10.26 Holds the current fit as a transform rather than a
+                  fitted copy of the coordinates
+   V1.4  16.10.26 Optional single precision coordinates
+
+*************************************************************************/
+#ifndef _CASTORE_H
+#define _CASTORE_H
+
+/************************************************************************/
+/* Includes
+*/
+#include <limits.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+#include "bioplib/pdb.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define CAS_CHAINLEN 8
+
+/* Core membership is one bit per C-alpha                               */
+#define CAWORDBITS   (CHAR_BIT * (int)sizeof(unsigned long))
+
+/* The C-alphas of one structure held as parallel arrays in sequence
+   order. x/y/z are the coordinates as read; the structure currently
+   sits at rot . (x - centre) + shift. residx[] maps a residue number
+   (offset by minres) to the first C-alpha with that number.
+
+   A single precision store keeps the coordinates in sx/sy/sz instead
+   (x/y/z are NULL) and does all its fitted coordinate and distance
+   arithmetic in float, using a float copy of the fit.
+*/
+typedef struct
+{
+   int   ncas;               /* Number of C-alphas                      */
+   BOOL  single;             /* Coordinates held in single precision    */
+   VEC3F CofG;               /* Centre of geometry of all the C-alphas  */
+   REAL  *x,  *y,  *z,       /* Unfitted coordinates                    */
+         rot[3][3];          /* Current fitting rotation                */
+   VEC3F centre,             /* Centre of rotation                      */
+         shift;              /* Where the centre is moved to            */
+   float *sx, *sy, *sz,      /* Single precision coordinates            */
+         srot[3][3],         /* Single precision copy of the fit        */
+         scentre[3],
+         sshift[3];
+   int   *resnum;            /* Residue numbers                         */
+   char  *insert,            /* Insert codes                            */
+         *chain;             /* Chain labels, CAS_CHAINLEN apart        */
+   unsigned long *core;      /* Bits set for residues in the core       */
+   int   ncorewords,         /* Size of core[]                          */
+         minres,             /* Lowest residue number                   */
+         nresidx,            /* Size of residx[]                        */
+         *residx;            /* Residue number to C-alpha lookup        */
+}  CASTORE;
+
+/* Test, set and unset the core bit for C-alpha i                       */
+#define CAINCORE(s, i)                                        \
+   (((s)->core[(i) / CAWORDBITS] >> ((i) % CAWORDBITS)) & 1UL)
+#define CASETCORE(s, i)                                       \
+   ((s)->core[(i) / CAWORDBITS] |= (1UL << ((i) % CAWORDBITS)))
+#define CAUNSETCORE(s, i)                                     \
+   ((s)->core[(i) / CAWORDBITS] &= ~(1UL << ((i) % CAWORDBITS)))
+
+/* Copy the unfitted coordinates of C-alpha i into a VEC3F              */
+#define CACOOR(v, s, i)                                       \
+   do { if((s)->single)                                       \
+        { (v).x = (s)->sx[i]; (v).y = (s)->sy[i]; (v).z = (s)->sz[i]; } \
+        else                                                  \
+        { (v).x = (s)->x[i];  (v).y = (s)->y[i];  (v).z = (s)->z[i];  } \
+   } while(0)
+
+/************************************************************************/
+/* Prototypes
+*/
+CASTORE *BuildCAStore(PDB *pdb, BOOL single);
+void FreeCAStore(CASTORE *cas);
+void ClearCACore(CASTORE *cas);
+int CountCACore(CASTORE *cas);
+int FindCAResidue(CASTORE *cas, int resnum);
+int NextCACore(CASTORE *cas, int i);
+int PrevCACore(CASTORE *cas, int i);
+BOOL AnyCACore(CASTORE *cas, int first, int last);
+BOOL AllCACore(CASTORE *cas, int first, int last);
+void SetCAFit(CASTORE *cas, REAL rot[3][3], VEC3F centre, VEC3F shift);
+void ClearCAFit(CASTORE *cas);
+void CAFitted(CASTORE *cas, int i, VEC3F *out);
+void ApplyCAFitPDB(CASTORE *cas, PDB *pdb);
+REAL CADistSq(CASTORE *cas1, int i, CASTORE *cas2, int j);
+
+#endif
@@ -0,0 +1,588 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       corafile.c
+
+   Version:    V1.0
+   Date:       16.10.26
+   Function:   Read CORA multiple structure alignments
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Modified:   Gabby Marsden (nee Reeves)
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Description:
+   ============
+   Reads a CORA alignment file and finds the starting zones for the
+   core from the secondary structure of the aligned positions. Moved
+   out of findcora so that the library (libfindcore.c) can seed zones
+   from CORA files too. Nothing here prints or keeps any state between
+   calls.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original. Taken from findcora V1.27. calcZone() takes
+                  the random coil flag rather than using a global
+
+*************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/macros.h"
+#include "zonelist.h"
+#include "corafile.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define CORABLOCK 1048576    /* Bytes of CORA file read at a time       */
+
+
+/************************************************************************/
+/*>Malign *ReadCORA(FILE *fp)
+   --------------------------
+   Input:   FILE   *fp      CORA alignment file
+   Returns: Malign *        The alignment (NULL if no memory or the
+                            file is incomplete)
+
+   Read a CORA alignment file into a set of zones showing residue
+   equivalences
+
+   The whole file is read into memory and scanned in one pass. The
+   alignment rows are held as one array of length x procnt Protdata.
+   The secondary structure is also recorded in bitmasks over the
+   positions for calcZone().
+
+   14.11.96 Original   By: ACRM 
+   23.01.97 Added gDoRandomCoil checking; swapped the logic round for
+            checking secondary structure matches to make this easier.
+   16.10.26 Names and per-protein data are allocated for however many
+            proteins the file has. Returns NULL if out of memory
+   16.10.26 Reads the file in one go and scans it by hand rather than
+            with fscanf() and reallocating for every row and protein.
+            Residue labels of any length are accepted
+   16.10.26 Builds the secondary structure bitmasks
+*/
+Malign *ReadCORA(FILE *fp)
+{
+   Malign   *maln_ptr;
+   Malndata *d_ptr;          
+   Protdata *p_ptr;  
+   char     *buffer,
+            *p,
+            *word;
+   int      count, count2,
+            len,
+            nwords;
+   
+   if((buffer = ReadCORAFile(fp)) == NULL)
+      return(NULL);
+   if((maln_ptr = new_Malign()) == NULL)
+   {
+      free(buffer);
+      return(NULL);
+   }
+   sprintf(maln_ptr->title, "%s", "alnfile");
+   
+   /* Skip comments. The number of proteins is the first thing on the
+      next line and the names start on the line after
+   */
+   for(p=buffer; *p == '#'; p++)
+   {
+      if((p = strchr(p, '\n')) == NULL)
+         break;
+   }
+   if((p == NULL) || !ScanCORAInt(&p, &maln_ptr->procnt) ||
+      (maln_ptr->procnt < 1))
+   {
+      free(buffer);
+      FreeMalign(maln_ptr);
+      return(NULL);
+   }
+   if((p = strchr(p, '\n')) == NULL)
+      p = buffer + strlen(buffer);
+
+   /* Store the names                                                   */
+   if((maln_ptr->proname =
+       (char **)malloc(maln_ptr->procnt * sizeof(char *)))==NULL)
+   {
+      free(buffer);
+      FreeMalign(maln_ptr);
+      return(NULL);
+   }
+   for(count=0; count < maln_ptr->procnt; count++) 
+      maln_ptr->proname[count] = NULL;
+   for(count=0; count < maln_ptr->procnt; count++) 
+   { 
+      if(((word = ScanCORAWord(&p, &len)) == NULL) ||
+         ((maln_ptr->proname[count] = (char *)malloc(len+1)) == NULL))
+      {
+         free(buffer);
+         FreeMalign(maln_ptr);
+         return(NULL);
+      }
+      strncpy(maln_ptr->proname[count], word, len);
+      maln_ptr->proname[count][len] = '\0';
+   }
+
+   /* Get the number of rows and allocate them all                      */
+   if(!ScanCORAInt(&p, &maln_ptr->length) || (maln_ptr->length < 0) ||
+      ((maln_ptr->malndata_ptr = 
+        (Malndata *)malloc(MAX(maln_ptr->length, 1) *
+                           sizeof(Malndata))) == NULL) ||
+      ((maln_ptr->protdata = 
+        (Protdata *)malloc(MAX(maln_ptr->length, 1) * maln_ptr->procnt *
+                           sizeof(Protdata))) == NULL))
+   {
+      free(buffer);
+      FreeMalign(maln_ptr);
+      return(NULL);
+   }
+
+   for(count=0; count < maln_ptr->length; count++) 
+   {
+      d_ptr = maln_ptr->malndata_ptr + count; 
+      d_ptr->protdata_ptr = maln_ptr->protdata + 
+                            (count * maln_ptr->procnt);
+   }
+
+   /* The four secondary structure masks share one allocation           */
+   nwords = MAX(SSNWORDS(maln_ptr->length), 1);
+   if((maln_ptr->anyE = (unsigned long *)calloc(4 * nwords,
+                                      sizeof(unsigned long)))==NULL)
+   {
+      free(buffer);
+      FreeMalign(maln_ptr);
+      return(NULL);
+   }
+   maln_ptr->anyH    = maln_ptr->anyE    + nwords;
+   maln_ptr->anyNoSS = maln_ptr->anyH    + nwords;
+   maln_ptr->anyGap  = maln_ptr->anyNoSS + nwords;
+   
+   /* Read each row                                                     */
+   for(count=0; count < maln_ptr->length; count++) 
+   { 	  
+      d_ptr = maln_ptr->malndata_ptr + count; 
+      if(!ScanCORAInt(&p, &d_ptr->alnpos) ||
+         !ScanCORAInt(&p, &d_ptr->conpos) ||
+         !ScanCORAInt(&p, &d_ptr->proaln))
+         break;
+      
+      for(count2=0; count2 < maln_ptr->procnt; count2++) 
+      {
+         p_ptr = d_ptr->protdata_ptr + count2;
+
+         /* The residue label is a number with an optional insert code */
+         if((word = ScanCORAWord(&p, &len)) == NULL)
+            break;
+         p_ptr->resnum = (int)strtol(word, &word, 10);
+         p_ptr->insert = (isspace(*word) || (*word == '\0')) ? 
+                         ' ' : *word;
+
+         if(((p_ptr->acid      = ScanCORAChar(&p)) == '\0') ||
+            ((p_ptr->secstruct = ScanCORAChar(&p)) == '\0'))
+            break;
+
+         switch(p_ptr->secstruct)
+         {
+         case 'E':
+            SSSETBIT(maln_ptr->anyE, count);
+            break;
+         case 'H':
+            SSSETBIT(maln_ptr->anyH, count);
+            break;
+         case '0':
+            SSSETBIT(maln_ptr->anyNoSS, count);
+            break;
+         }
+         if(p_ptr->acid == '0')
+            SSSETBIT(maln_ptr->anyGap, count);
+      }
+      if(count2 < maln_ptr->procnt)
+         break;
+      
+      /* Take the consensus and ignore the rest of the line             */
+      if((d_ptr->consecstruc = ScanCORAChar(&p)) == '\0')
+         break;
+      if((p = strchr(p, '\n')) == NULL)
+         p = buffer + strlen(buffer);
+   }
+   free(buffer);
+
+   if(count < maln_ptr->length)
+   {
+      FreeMalign(maln_ptr);
+      return(NULL);
+   }
+   
+   return(maln_ptr);
+}
+
+
+/************************************************************************/
+/*>char *ReadCORAFile(FILE *fp)
+   ----------------------------
+   Input:   FILE   *fp      File to read
+   Returns: char   *        Malloc'd contents of the file with a
+                            terminating nul (NULL if no memory)
+
+   Reads the rest of a file in blocks of CORABLOCK bytes
+
+   16.10.26 Original   By: ACRM
+*/
+char *ReadCORAFile(FILE *fp)
+{
+   char   *buffer = NULL,
+          *tmp;
+   size_t len     = 0,
+          maxlen  = 0,
+          nread;
+
+   do
+   {
+      if(len + CORABLOCK + 1 > maxlen)
+      {
+         maxlen = (maxlen ? 2 * maxlen : CORABLOCK + 1);
+         if((tmp = (char *)realloc(buffer, maxlen))==NULL)
+         {
+            free(buffer);
+            return(NULL);
+         }
+         buffer = tmp;
+      }
+      nread = fread(buffer + len, 1, CORABLOCK, fp);
+      len  += nread;
+   }  while(nread == CORABLOCK);
+
+   buffer[len] = '\0';
+   return(buffer);
+}
+
+
+/************************************************************************/
+/*>char *ScanCORAWord(char **pp, int *len)
+   ---------------------------------------
+   I/O:     char   **pp     Position in the buffer; moved past the word
+   Output:  int    *len     Length of the word
+   Returns: char   *        Start of the next whitespace delimited
+                            word (NULL if there isn't one)
+
+   16.10.26 Original   By: ACRM
+*/
+char *ScanCORAWord(char **pp, int *len)
+{
+   char *p = *pp,
+        *word;
+
+   while(isspace(*p))
+      p++;
+   if(*p == '\0')
+   {
+      *pp = p;
+      return(NULL);
+   }
+
+   for(word=p; (*p != '\0') && !isspace(*p); p++);
+   *len = (int)(p - word);
+   *pp  = p;
+   return(word);
+}
+
+
+/************************************************************************/
+/*>BOOL ScanCORAInt(char **pp, int *value)
+   ---------------------------------------
+   I/O:     char   **pp     Position in the buffer; moved past the
+                            number
+   Output:  int    *value   The number
+   Returns: BOOL            There was a number
+
+   16.10.26 Original   By: ACRM
+*/
+BOOL ScanCORAInt(char **pp, int *value)
+{
+   char *end;
+   long number;
+
+   number = strtol(*pp, &end, 10);
+   if(end == *pp)
+      return(FALSE);
+
+   *value = (int)number;
+   *pp    = end;
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>char ScanCORAChar(char **pp)
+   ----------------------------
+   I/O:     char   **pp     Position in the buffer; moved past the
+                            character
+   Returns: char            Next character which isn't whitespace
+                            ('\0' at the end of the buffer)
+
+   Like fscanf(" %c") this only takes one character even if more
+   follow it
+
+   16.10.26 Original   By: ACRM
+*/
+char ScanCORAChar(char **pp)
+{
+   char *p = *pp;
+
+   while(isspace(*p))
+      p++;
+   if(*p == '\0')
+   {
+      *pp = p;
+      return('\0');
+   }
+
+   *pp = p+1;
+   return(*p);
+}
+
+/************************************************************************/
+/*>ZONELIST *calcZone(Malign *maln_ptr, BOOL randomCoil)
+   ------------------------------------------------------
+   Input:   Malign   *maln_ptr    CORA alignment
+            BOOL     randomCoil   Also make zones from aligned coil
+   Returns: ZONELIST *            Starting zones (NULL if no memory)
+
+   FINDS THE ZONES IN CORA
+
+   A strand zone starts at a position where some protein is in a
+   strand and none is in a helix or has no secondary structure ('0'),
+   and carries on while no protein is in a helix or has no secondary
+   structure. Helix zones are the same with strands and helices
+   swapped. The position which ends a strand or helix zone can't start
+   the next one and, as always, a zone can't start at the first
+   position. With randomCoil, runs of positions where every protein
+   is aligned and none is in a strand or helix are zones too.
+
+   The tests are done on the bitmasks made by ReadCORA(), a word of
+   positions at a time.
+
+   16.10.26 Works from the secondary structure bitmasks. Added
+            gDoRandomCoil   By: ACRM
+   16.10.26 Takes randomCoil rather than using gDoRandomCoil
+*/
+ZONELIST *calcZone(Malign *maln_ptr, BOOL randomCoil)
+{
+   ZONELIST      *zones;
+   unsigned long *mask,
+                 *startE, *contE,
+                 *startH, *contH,
+                 *coil,
+                 *start;
+   int           nwords = SSNWORDS(maln_ptr->length),
+                 length = maln_ptr->length,
+                 w, z,
+                 pos, end, next,
+                 protnum;
+   Protdata      *p_start,
+                 *p_end;
+   
+   if((zones = NewZoneList(maln_ptr->procnt))==NULL)
+      return(NULL);
+   if((mask = (unsigned long *)malloc((6 * nwords + 1) *
+                                      sizeof(unsigned long)))==NULL)
+   {
+      FreeZoneList(zones);
+      return(NULL);
+   }
+   startE = mask;
+   contE  = startE + nwords;
+   startH = contE  + nwords;
+   contH  = startH + nwords;
+   coil   = contH  + nwords;
+   start  = coil   + nwords;
+
+   for(w=0; w<nwords; w++)
+   {
+      contE[w]  = ~(maln_ptr->anyH[w] | maln_ptr->anyNoSS[w]);
+      startE[w] = maln_ptr->anyE[w] & contE[w];
+      contH[w]  = ~(maln_ptr->anyE[w] | maln_ptr->anyNoSS[w]);
+      startH[w] = maln_ptr->anyH[w] & contH[w];
+      coil[w]   = ~(maln_ptr->anyE[w] | maln_ptr->anyH[w] |
+                    maln_ptr->anyGap[w]);
+      start[w]  = startE[w] | startH[w] | (randomCoil ? coil[w] : 0UL);
+   }
+
+   for(pos=NextSSBit(start, 0, length, TRUE);
+       pos < length;
+       pos=NextSSBit(start, next, length, TRUE))
+   {
+      if(SSBIT(startE, pos))
+      {
+         end  = NextSSBit(contE, pos+1, length, FALSE);
+         next = end+1;
+      }
+      else if(SSBIT(startH, pos))
+      {
+         end  = NextSSBit(contH, pos+1, length, FALSE);
+         next = end+1;
+      }
+      else
+      {
+         end  = NextSSBit(coil, pos+1, length, FALSE);
+         next = end;
+      }
+      
+      /* record the start and end residues into the zone array          */
+      if(pos)
+      {
+         z = zones->nzones;
+         if(!InsertZone(zones, z))
+         {
+            free(mask);
+            FreeZoneList(zones);
+            return(NULL);
+         }
+         
+         p_start = maln_ptr->malndata_ptr[pos].protdata_ptr;
+         p_end   = maln_ptr->malndata_ptr[end-1].protdata_ptr;
+         for(protnum=0; protnum < maln_ptr->procnt; protnum++)
+         {
+            ZSTART(zones, z, protnum) = p_start[protnum].resnum;
+            ZEND(zones, z, protnum)   = p_end[protnum].resnum;
+         } 
+      }
+   }
+   
+   free(mask);
+   return(zones);
+}
+
+
+/************************************************************************/
+/*>int NextSSBit(unsigned long *mask, int i, int n, BOOL set)
+   ----------------------------------------------------------
+   Input:   unsigned long *mask  Bitmask over alignment positions
+            int           i      Where to start looking
+            int           n      Number of positions
+            BOOL          set    Look for a set bit rather than a clear
+                                 one
+   Returns: int                  First position at or after i with the
+                                 bit set (or clear). n if there is none
+
+   16.10.26 Original   By: ACRM
+*/
+int NextSSBit(unsigned long *mask, int i, int n, BOOL set)
+{
+   int           w, 
+                 nwords = SSNWORDS(n),
+                 bit;
+   unsigned long word;
+
+   if(i >= n)
+      return(n);
+
+   w    = i / SSWORDBITS;
+   word = (set ? mask[w] : ~mask[w]) & (~0UL << (i % SSWORDBITS));
+   while(word == 0UL)
+   {
+      if(++w >= nwords)
+         return(n);
+      word = (set ? mask[w] : ~mask[w]);
+   }
+
+#ifdef __GNUC__
+   bit = __builtin_ctzl(word);
+#else
+   for(bit=0; !(word & 1UL); bit++)
+      word >>= 1;
+#endif
+   
+   return(MIN(w * SSWORDBITS + bit, n));
+}
+
+/************************************************************************/
+/*>Malign *new_Malign(void)
+   ------------------------
+   Returns: Malign *        An empty alignment (NULL if no memory)
+
+   16.10.26 Added header. Uses malloc() directly so that running out
+            of memory isn't reported here   By: ACRM
+*/
+Malign *new_Malign(void)
+{
+   Malign *maln;
+
+   if((maln = (Malign *)malloc(sizeof(Malign))) != NULL)
+      clear_Malign(maln);
+   return(maln);
+}
+
+
+/************************************************************************/
+/*>void clear_Malign(Malign *m)
+   ----------------------------
+   I/O:     Malign *m       Alignment to empty (nothing is freed)
+
+   16.10.26 Added header   By: ACRM
+*/
+void clear_Malign(Malign *m)
+{
+   m->procnt = 0;
+   m->length = 0;
+   *(m->title) = '\0';
+   m->proname = NULL;
+   m->malndata_ptr = NULL;
+   m->protdata = NULL;
+   m->anyE = m->anyH = m->anyNoSS = m->anyGap = NULL;
+}
+
+
+/************************************************************************/
+/*>void FreeMalign(Malign *m)
+   --------------------------
+   I/O:     Malign *m       Alignment to free. May be NULL
+
+   16.10.26 Original   By: ACRM
+*/
+void FreeMalign(Malign *m)
+{
+   int i;
+
+   if(m == NULL)
+      return;
+
+   if(m->proname != NULL)
+   {
+      for(i=0; i<m->procnt; i++)
+         FREE(m->proname[i]);
+      free(m->proname);
+   }
+   FREE(m->malndata_ptr);
+   FREE(m->protdata);
+   FREE(m->anyE);
+   free(m);
+}
+
+
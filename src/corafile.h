@@ -0,0 +1,109 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       corafile.h
+
+   Version:    V1.0
+   Date:       16.10.26
+   Function:   Read CORA multiple structure alignments
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Modified:   Gabby Marsden (nee Reeves)
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original. Taken from findcora V1.27
+
+*************************************************************************/
+#ifndef _CORAFILE_H
+#define _CORAFILE_H
+
+/************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <limits.h>
+#include "bioplib/SysDefs.h"
+#include "zonelist.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+/* Secondary structure bitmasks have one bit per alignment position     */
+#define SSWORDBITS  (CHAR_BIT * (int)sizeof(unsigned long))
+#define SSNWORDS(n) (((n) + SSWORDBITS - 1) / SSWORDBITS)
+#define SSBIT(m, i)                                           \
+   (((m)[(i) / SSWORDBITS] >> ((i) % SSWORDBITS)) & 1UL)
+#define SSSETBIT(m, i)                                        \
+   ((m)[(i) / SSWORDBITS] |= (1UL << ((i) % SSWORDBITS)))
+/*  CORA - Line data for multiple alignment files                       */
+typedef struct
+{  /* data for each protein in the alignment                            */
+   int  resnum;              /* Residue number (0 if not aligned)       */
+   char acid,
+        secstruct,
+        insert;              /* Insert code                             */
+}  Protdata;
+
+typedef struct
+{
+   int      alnpos,
+            conpos,
+            proaln,
+            colx,
+            coly,
+            score;
+   char     consecstruc;
+   /* Pointer defined to point to the first address in Protdata         */
+   Protdata *protdata_ptr;   
+}  Malndata;
+
+/*  general data for multiple alignment files                           */
+typedef struct
+{
+   int       procnt,
+             length; 		                    
+   char      title[50],
+             **proname;
+   /* Pointer defined to point to the first address in Malndata         */
+   Malndata  *malndata_ptr;      
+   /* Protdata for every row; each row's protdata_ptr points into it    */
+   Protdata  *protdata;
+   /* Positions where any protein is in a strand, in a helix, has no
+      secondary structure ('0') or isn't aligned
+   */
+   unsigned long *anyE,
+                 *anyH,
+                 *anyNoSS,
+                 *anyGap;
+}  Malign;
+
+/************************************************************************/
+/* Prototypes
+*/
+Malign *ReadCORA(FILE *fp);
+ZONELIST *calcZone(Malign *maln_ptr, BOOL randomCoil);
+int NextSSBit(unsigned long *mask, int i, int n, BOOL set);
+Malign *new_Malign(void);
+void clear_Malign(Malign *m);
+void FreeMalign(Malign *m);
+char *ReadCORAFile(FILE *fp);
+char *ScanCORAWord(char **pp, int *len);
+BOOL ScanCORAInt(char **pp, int *value);
+char ScanCORAChar(char **pp);
+
+#endif
@@ -0,0 +1,1058 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       coreeng.c
+
+   Version:    V1.5
+   Date:       16.10.26
+   Function:   Core definition engine shared by findcore and findcora
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Description:
+   ============
+   findcore (2 structures from SSAP) and findcora (any number from
+   CORA) used to carry their own copies of the cut, the zone extension
+   and the fitting. Here they are written once for nstruc structures;
+   the two programs just read their alignments, build the starting
+   zones and write out the results.
+
+   Every structure is fitted onto the first. Zones are walked in step
+   in all the structures, and a position is only kept (or added) if
+   every pair of structures is within the cutoff there, so with two
+   structures this is exactly the old findcore behaviour.
+
+   The per-structure positions used while walking a zone are kept in
+   the engine rather than in fixed size arrays on the stack. For up to
+   CORE_SMALLN structures (which includes the usual pairwise case) they
+   live in the engine structure itself; beyond that they are allocated
+   once when the engine is set up.
+
+   Each structure's fit only reads the first structure and writes its
+   own sums and transform, so with a thread pool the fits are run in
+   parallel. RunPool() doesn't return until they have all finished, and
+   every fit does the same arithmetic whichever thread runs it, so the
+   zones are the same for any number of threads.
+
+   Fitting onto the first structure makes the result depend on which
+   structure is listed first. With consensus set, FitAllCores() instead
+   does a generalised Procrustes fit: the mean of the fitted core
+   C-alphas is worked out from the current transforms, every structure
+   is fitted onto it (in parallel), and this is repeated until the mean
+   stops moving. The first time, the structures are fitted onto the
+   first to give a starting mean; after that each call starts from the
+   transforms left by the last one. The core positions are paired off
+   in order in every structure, as BuildFitSums() does.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original. Taken from the copies in findcore V1.14 and
+                  findcora V1.17
+   V1.1  16.10.26 Fits can be run on a thread pool
+   V1.2  16.10.26 Structures can be fitted to their mean instead of the
+                  first
+   V1.3  16.10.26 The fitting backend and deviation test are held in
+                  the engine. Nothing is printed; problems are returned
+                  to the caller
+   V1.4  16.10.26 The workspace for CAFirstOverCut() is allocated once
+                  with the engine
+   V1.5  16.10.26 Added ZoneEndsInStore() so that zones ending at a
+                  residue with no C-alpha can be rejected before the
+                  cut and extension look them up
+
+*************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+#include "bioplib/pdb.h"
+#include "bioplib/macros.h"
+#include "corefit.h"
+#include "castore.h"
+#include "zonelist.h"
+#include "distkern.h"
+#include "coreeng.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+static BOOL BuildFitSums(FITSUMS *fs, CASTORE *cas1, CASTORE *cas2);
+static BOOL PairsMatchZones(CASTORE *cas1, CASTORE *cas2,
+                            ZONELIST *zones, int which);
+static BOOL AllInCore(COREENGINE *ce, int *pos);
+static BOOL ZoneAnyCore(COREENGINE *ce, int len);
+static BOOL ZoneAllCore(COREENGINE *ce, int len);
+static int ZoneLength(COREENGINE *ce);
+static void FitTask(void *arg, int i);
+static BOOL FitToMean(COREENGINE *ce);
+static REAL BuildMean(COREENGINE *ce);
+static void MeanFitTask(void *arg, int s);
+
+
+/************************************************************************/
+/*>COREENGINE *NewCoreEngine(PDB **pdb, int nstruc, ZONELIST *zones,
+                             BOOL single)
+   -----------------------------------------------------------------
+   Input:   PDB        **pdb    The structures
+            int        nstruc   Number of structures
+            ZONELIST   *zones   Starting zones
+            BOOL       single   Hold the C-alphas in single precision
+   Returns: COREENGINE *        Engine ready to find the core (NULL if
+                                no memory)
+
+   Copies the C-alphas into stores, flags those in the starting zones
+   as core and sets up the sums for fitting each structure onto the
+   first. If every flagged residue is paired with its partner through
+   a zone the sums are kept up to date as pairs are added and removed;
+   otherwise they are rebuilt for each fit.
+
+   The engine starts with no thread pool, fitting onto the first
+   structure with blMatfit() and testing every pair of structures;
+   pool, consensus, backend and test may be changed before it is used.
+
+   16.10.26 Original based on DefineCore()   By: ACRM
+   16.10.26 Sets the backend and test
+   16.10.26 Allocates the workspace for CAFirstOverCut()
+*/
+COREENGINE *NewCoreEngine(PDB **pdb, int nstruc, ZONELIST *zones,
+                          BOOL single)
+{
+   COREENGINE *ce;
+   int        s;
+
+   if((ce = (COREENGINE *)malloc(sizeof(COREENGINE)))==NULL)
+      return(NULL);
+
+   ce->nstruc      = nstruc;
+   ce->pool        = NULL;
+   ce->consensus   = FALSE;
+   ce->backend     = FITBACKEND_MATFIT;
+   ce->test        = CATEST_PAIRS;
+   ce->mean        = NULL;
+   ce->lastMean    = NULL;
+   ce->nmean       = 0;
+   ce->cas         = (CASTORE **)malloc(nstruc * sizeof(CASTORE *));
+   ce->sums        = (FITSUMS *)malloc(nstruc * sizeof(FITSUMS));
+   ce->incremental = (BOOL *)malloc(nstruc * sizeof(BOOL));
+   ce->radius      = (REAL *)malloc(nstruc * sizeof(REAL));
+   if(nstruc <= CORE_SMALLN)
+      ce->start    = ce->smallWork;
+   else
+      ce->start    = (int *)malloc(3 * nstruc * sizeof(int));
+
+   if(ce->cas != NULL)
+   {
+      for(s=0; s<nstruc; s++)
+         ce->cas[s] = NULL;
+   }
+
+   if((ce->cas == NULL) || (ce->sums == NULL) ||
+      (ce->incremental == NULL) || (ce->radius == NULL) ||
+      (ce->start == NULL))
+   {
+      FreeCoreEngine(ce);
+      return(NULL);
+   }
+   ce->end    = ce->start + nstruc;
+   ce->offset = ce->end   + nstruc;
+
+   /* Copy the C-alphas into compact stores                             */
+   for(s=0; s<nstruc; s++)
+   {
+      if((ce->cas[s] = BuildCAStore(pdb[s], single)) == NULL)
+      {
+         FreeCoreEngine(ce);
+         return(NULL);
+      }
+      SetCoreByZone(ce->cas[s], zones, s);
+   }
+
+   /* Set up the fitting sums for each structure onto the first         */
+   ce->incremental[0] = FALSE;
+   for(s=1; s<nstruc; s++)
+   {
+      InitFitSums(&(ce->sums[s]), ce->cas[0]->CofG, ce->cas[s]->CofG);
+      ce->incremental[s] =
+         BuildFitSums(&(ce->sums[s]), ce->cas[0], ce->cas[s]) &&
+         PairsMatchZones(ce->cas[0], ce->cas[s], zones, s);
+   }
+
+   return(ce);
+}
+
+
+/************************************************************************/
+/*>void FreeCoreEngine(COREENGINE *ce)
+   -----------------------------------
+   I/O:     COREENGINE *ce      Core engine
+
+   Frees a core engine and its C-alpha stores. May be given NULL.
+
+   16.10.26 Original   By: ACRM
+*/
+void FreeCoreEngine(COREENGINE *ce)
+{
+   int s;
+
+   if(ce == NULL)
+      return;
+
+   if(ce->cas != NULL)
+   {
+      for(s=0; s<ce->nstruc; s++)
+         FreeCAStore(ce->cas[s]);
+      free(ce->cas);
+   }
+   FREE(ce->sums);
+   FREE(ce->incremental);
+   FREE(ce->radius);
+   FREE(ce->mean);
+   FREE(ce->lastMean);
+   if(ce->start != ce->smallWork)
+      FREE(ce->start);
+   free(ce);
+}
+
+
+/************************************************************************/
+/*>BOOL IterateCore(COREENGINE *ce, ZONELIST *zones, REAL cutsq)
+   -------------------------------------------------------------
+   I/O:     COREENGINE *ce      Core engine
+            ZONELIST   *zones   Current zones
+   Input:   REAL       cutsq    Squared distance cutoff
+   Returns: BOOL                FALSE if the core hadn't settled down
+                                after CORE_MAXITER iterations
+
+   Repeatedly fits the core and extends the zones until no more
+   residues are added
+
+   14.11.96 Original (as part of DefineCore())   By: ACRM
+   16.10.26 Split out for the shared engine
+   16.10.26 No longer prints a warning; the caller reports it
+*/
+BOOL IterateCore(COREENGINE *ce, ZONELIST *zones, REAL cutsq)
+{
+   int count = CountCACore(ce->cas[0]),
+       last  = 0,
+       iter  = 0;
+
+   while(last != count)
+   {
+      FitAllCores(ce);
+      UpdateBValues(ce, zones, cutsq);
+      last  = count;
+      count = CountCACore(ce->cas[0]);
+      if(++iter > CORE_MAXITER)
+         return(FALSE);
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void SetCoreByZone(CASTORE *cas, ZONELIST *zones, int which)
+   ------------------------------------------------------------
+   Flag the C-alphas in the zones as core
+
+   16.10.26 Original based on SetBValByZone()   By: ACRM
+*/
+void SetCoreByZone(CASTORE *cas, ZONELIST *zones, int which)
+{
+   int  z,
+        i;
+
+   ClearCACore(cas);
+
+   for(i=0; i<cas->ncas; i++)
+   {
+      for(z=0; z<zones->nzones; z++)
+      {
+         if((cas->resnum[i] >= ZSTART(zones, z, which)) &&
+            (cas->resnum[i] <= ZEND(zones, z, which)))
+         {
+            CASETCORE(cas, i);
+            break;
+         }
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>BOOL ZoneEndsInStore(CASTORE *cas, ZONELIST *zones, int which)
+   --------------------------------------------------------------
+   Input:   CASTORE  *cas       C-alpha store
+            ZONELIST *zones     Zones
+            int      which      Which structure of the zones cas holds
+   Returns: BOOL                Every zone starts and ends at a residue
+                                with a C-alpha
+
+   DoCut() and UpdateBValues() find the zone ends with FindCAResidue(),
+   so each must be in the store before they are called
+
+   16.10.26 Original   By: ACRM
+*/
+BOOL ZoneEndsInStore(CASTORE *cas, ZONELIST *zones, int which)
+{
+   int z;
+
+   for(z=0; z<zones->nzones; z++)
+   {
+      if(ZONEDELETED(zones, z))
+         continue;
+      if((FindCAResidue(cas, ZSTART(zones, z, which)) >= cas->ncas) ||
+         (FindCAResidue(cas, ZEND(zones, z, which))   >= cas->ncas))
+         return(FALSE);
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>BOOL FitCore(COREENGINE *ce, int s)
+   -----------------------------------
+   I/O:     COREENGINE *ce      Core engine
+   Input:   int        s        Structure to fit onto the first
+   Returns: BOOL                Success
+
+   Fits structure s onto the first using the residues flagged as core.
+   If the sums have not been kept up to date they are rebuilt from the
+   flags first.
+
+   Only the transform is recorded in the mobile store; nothing is
+   moved. Each fit is from the unfitted coordinates so fits don't
+   accumulate. If the fit fails the previous transform is kept.
+
+   14.11.96 Original (as FitCaPDBBFlag()) based on FitCaPDB() By: ACRM
+   16.10.26 Rewritten to work from running sums rather than building
+            new CA lists
+   16.10.26 Works on C-alpha stores
+   16.10.26 Just records the transform
+   16.10.26 Works on the shared engine
+   16.10.26 Uses the engine's backend
+*/
+BOOL FitCore(COREENGINE *ce, int s)
+{
+   FITSUMS *fs = &(ce->sums[s]);
+
+   if(!ce->incremental[s])
+   {
+      if(!BuildFitSums(fs, ce->cas[0], ce->cas[s]))
+         return(FALSE);
+   }
+
+   if(!SolveFitSums(fs, ce->backend))
+      return(FALSE);
+
+   SetCAFit(ce->cas[s], fs->rot, fs->fitCofG, fs->refCofG);
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void FitAllCores(COREENGINE *ce)
+   --------------------------------
+   I/O:     COREENGINE *ce      Core engine
+
+   Fits every structure onto the first, using the thread pool if there
+   is one. If ce->consensus is set they are all fitted onto their mean
+   instead (unless there is no memory for it).
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Runs the fits on ce->pool
+   16.10.26 Fits to the mean structure
+*/
+void FitAllCores(COREENGINE *ce)
+{
+   if(ce->consensus && FitToMean(ce))
+      return;
+
+   RunPool(ce->pool, FitTask, (void *)ce, ce->nstruc - 1);
+}
+
+
+/************************************************************************/
+/*>static void FitTask(void *arg, int i)
+   -------------------------------------
+   Input:   void       *arg     Core engine
+            int        i        Fit structure i+1
+
+   Pool task for FitAllCores()
+
+   16.10.26 Original   By: ACRM
+*/
+static void FitTask(void *arg, int i)
+{
+   FitCore((COREENGINE *)arg, i+1);
+}
+
+
+/************************************************************************/
+/*>static BOOL FitToMean(COREENGINE *ce)
+   -------------------------------------
+   I/O:     COREENGINE *ce      Core engine
+   Returns: BOOL                FALSE if no memory for the mean
+
+   Fits every structure onto the mean of the fitted cores and repeats
+   until the mean settles down or CORE_MAXMEAN rounds have been done.
+   The fits for each round are run on the thread pool. The mean is
+   built in the same order whatever the number of threads.
+
+   16.10.26 Original   By: ACRM
+*/
+static BOOL FitToMean(COREENGINE *ce)
+{
+   int   s,
+         round;
+   VEC3F *tmp;
+
+   if(ce->mean == NULL)
+   {
+      s = MAX(ce->cas[0]->ncas, 1);
+      ce->mean     = (VEC3F *)malloc(s * sizeof(VEC3F));
+      ce->lastMean = (VEC3F *)malloc(s * sizeof(VEC3F));
+      ce->nmean    = 0;
+      if((ce->mean == NULL) || (ce->lastMean == NULL))
+      {
+         FREE(ce->mean);
+         FREE(ce->lastMean);
+         return(FALSE);
+      }
+
+      /* Start from every structure fitted onto the first. The sums
+         will be for fitting onto the mean from now on so aren't
+         updated as pairs come and go
+      */
+      RunPool(ce->pool, FitTask, (void *)ce, ce->nstruc - 1);
+      for(s=0; s<ce->nstruc; s++)
+         ce->incremental[s] = FALSE;
+   }
+
+   for(round=0; ; round++)
+   {
+      tmp          = ce->lastMean;
+      ce->lastMean = ce->mean;
+      ce->mean     = tmp;
+
+      if(((BuildMean(ce) < CORE_MEANTOL) && round) ||
+         (round == CORE_MAXMEAN))
+         break;
+
+      RunPool(ce->pool, MeanFitTask, (void *)ce, ce->nstruc);
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static REAL BuildMean(COREENGINE *ce)
+   -------------------------------------
+   I/O:     COREENGINE *ce      Core engine
+   Returns: REAL                Mean squared movement of the points
+                                since lastMean[] (or a large value if
+                                the number of points has changed)
+
+   Averages the fitted C-alphas of the core over all the structures,
+   pairing off the core C-alphas in order. Stops at the end of the
+   shortest core.
+
+   16.10.26 Original   By: ACRM
+*/
+static REAL BuildMean(COREENGINE *ce)
+{
+   CASTORE **cas   = ce->cas;
+   int     nstruc  = ce->nstruc,
+           *offset = ce->offset,
+           nlast   = ce->nmean,
+           j, s;
+   VEC3F   fit,
+           *mean;
+   REAL    shift   = (REAL)0.0;
+
+   for(s=0; s<nstruc; s++)
+      offset[s] = -1;
+
+   for(j=0; ; j++)
+   {
+      for(s=0; s<nstruc; s++)
+      {
+         offset[s] = NextCACore(cas[s], offset[s]+1);
+         if(offset[s] >= cas[s]->ncas)
+            break;
+      }
+      if(s < nstruc)
+         break;
+
+      mean    = &(ce->mean[j]);
+      mean->x = mean->y = mean->z = (REAL)0.0;
+      for(s=0; s<nstruc; s++)
+      {
+         CAFitted(cas[s], offset[s], &fit);
+         mean->x += fit.x;
+         mean->y += fit.y;
+         mean->z += fit.z;
+      }
+      mean->x /= nstruc;
+      mean->y /= nstruc;
+      mean->z /= nstruc;
+
+      if(j < nlast)
+         shift += DISTSQ(mean, &(ce->lastMean[j]));
+   }
+   ce->nmean = j;
+
+   if((j != nlast) || (j == 0))
+      return((REAL)1.0);
+   return(shift / j);
+}
+
+
+/************************************************************************/
+/*>static void MeanFitTask(void *arg, int s)
+   -----------------------------------------
+   Input:   void       *arg     Core engine
+            int        s        Structure to fit onto the mean
+
+   Pool task for FitToMean(). If the fit fails the previous transform
+   is kept.
+
+   16.10.26 Original   By: ACRM
+*/
+static void MeanFitTask(void *arg, int s)
+{
+   COREENGINE *ce  = (COREENGINE *)arg;
+   CASTORE    *cas = ce->cas[s];
+   FITSUMS    *fs  = &(ce->sums[s]);
+   VEC3F      fit;
+   int        i, j;
+
+   InitFitSums(fs, ce->cas[0]->CofG, cas->CofG);
+   for(i=0, j=0; j<ce->nmean; i++, j++)
+   {
+      i = NextCACore(cas, i);
+      CACOOR(fit, cas, i);
+      AddFitPair(fs, &(ce->mean[j]), &fit);
+   }
+
+   if(SolveFitSums(fs, ce->backend))
+      SetCAFit(cas, fs->rot, fs->fitCofG, fs->refCofG);
+}
+
+
+/************************************************************************/
+/*>BOOL DoCut(COREENGINE *ce, ZONELIST *zones, REAL cutsq)
+   -------------------------------------------------------
+   I/O:     COREENGINE *ce      Core engine
+            ZONELIST   *zones   Current zones
+   Input:   REAL       cutsq    Squared distance cutoff
+   Returns: BOOL                Success (FALSE if no memory)
+
+   Performs the initial cut of positions where any pair of structures
+   deviates by more than the cutoff. Zones with gaps are split and
+   zones with nothing left are marked for deletion.
+
+   Positions which are cut are also removed from any fitting sums
+   which are being kept up to date. Every zone must start and end at a
+   C-alpha in the stores (ZoneEndsInStore()).
+
+   06.12.96 Original   By: ACRM
+   16.10.26 Added fitting sums
+   16.10.26 Works on C-alpha stores
+   16.10.26 Zone ends are found with FindCAResidue()
+   16.10.26 Split zones are inserted into the zone array
+   16.10.26 Checks for split zones a word at a time
+   16.10.26 Distances are checked in blocks with CAFirstOverCut()
+   16.10.26 Merged the findcore and findcora versions. The zone is
+            checked over the length it has in every structure and a
+            split is only taken back to a position which is in the
+            core in every structure, as findcore did
+   16.10.26 Running out of memory is left to the caller to report
+*/
+BOOL DoCut(COREENGINE *ce, ZONELIST *zones, REAL cutsq)
+{
+   CASTORE **cas   = ce->cas;
+   int     nstruc  = ce->nstruc,
+           *start  = ce->start,
+           *end    = ce->end,
+           *offset = ce->offset,
+           z, zend,
+           s, k, n,
+           len;
+   BOOL    split;
+   VEC3F   ref, fit;
+
+   for(z=0; z<zones->nzones; z++)
+   {
+      /* Look for the start and end of the zone                         */
+      for(s=0; s<nstruc; s++)
+      {
+         start[s] = FindCAResidue(cas[s], ZSTART(zones, z, s));
+         end[s]   = FindCAResidue(cas[s], ZEND(zones, z, s));
+      }
+
+      /* Find how many positions there are in the zone in every
+         structure
+      */
+      n = ZoneLength(ce) + 1;
+      for(s=0; s<nstruc; s++)
+         n = MIN(n, cas[s]->ncas - start[s]);
+
+      /* Step through the zone to see if we are within the cutoff,
+         jumping from one position which is out of range to the next
+      */
+      split = FALSE;
+      for(k=0; k<n; k++)
+      {
+         for(s=0; s<nstruc; s++)
+            offset[s] = start[s] + k;
+         if((k += CAFirstOverCut(cas, nstruc, offset, 1, n-k, cutsq,
+                                 ce->test, ce->radius)) >= n)
+            break;
+
+         /* Remove the position from the core                           */
+         split = TRUE;
+         for(s=1; s<nstruc; s++)
+         {
+            if(ce->incremental[s]          &&
+               CAINCORE(cas[0], start[0]+k) &&
+               CAINCORE(cas[s], start[s]+k))
+            {
+               CACOOR(ref, cas[0], start[0]+k);
+               CACOOR(fit, cas[s], start[s]+k);
+               RemoveFitPair(&(ce->sums[s]), &ref, &fit);
+            }
+         }
+         for(s=0; s<nstruc; s++)
+            CAUNSETCORE(cas[s], start[s]+k);
+      }
+
+      /* See if there were any bits out of range which need the zones
+         to be split
+      */
+      if(split)
+      {
+         /* If the zone contains no pairs within the cutoff, mark it for
+            deletion
+         */
+         if(!ZoneAnyCore(ce, ZoneLength(ce)))
+         {
+            DeleteZone(zones, z);
+         }
+         else
+         {
+            /* There were some parts which are still required, but it's
+               been modified, so we need to split the zones up
+
+               First see if we've lost residues from the start of the
+               zone
+            */
+            while(!AllInCore(ce, start))
+            {
+               for(s=0; s<nstruc; s++)
+               {
+                  start[s]++;
+                  ZSTART(zones, z, s) = cas[s]->resnum[start[s]];
+               }
+            }
+            /* Now remove residues from the end of the zone in the same
+               way
+            */
+            while(!AllInCore(ce, end))
+            {
+               for(s=0; s<nstruc; s++)
+               {
+                  end[s]--;
+                  ZEND(zones, z, s) = cas[s]->resnum[end[s]];
+               }
+            }
+
+            /* See if the new zone is split                             */
+            len   = ZoneLength(ce);
+            split = !ZoneAllCore(ce, len);
+            while(split)
+            {
+               /* Move the last sub-zone into a separate zone           */
+               zend = z+1;
+               if(!InsertZone(zones, zend))
+                  return(FALSE);
+
+               for(s=0; s<nstruc; s++)
+                  ZEND(zones, zend, s) = ZEND(zones, z, s);
+
+               /* Step back through the zone to find the start of this
+                  subzone
+               */
+               while(AllInCore(ce, end))
+               {
+                  for(s=0; s<nstruc; s++)
+                  {
+                     end[s]--;
+                     ZSTART(zones, zend, s) = cas[s]->resnum[end[s]];
+                  }
+               }
+               /* Now step back to the end of the previous subzone      */
+               while(!AllInCore(ce, end))
+               {
+                  for(s=0; s<nstruc; s++)
+                  {
+                     end[s]--;
+                     ZEND(zones, z, s) = cas[s]->resnum[end[s]];
+                  }
+               }
+
+               /* Test again to see if it's split                       */
+               len   = ZoneLength(ce);
+               split = !ZoneAllCore(ce, len);
+            }
+         }
+      }
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void UpdateBValues(COREENGINE *ce, ZONELIST *zones, REAL cutsq)
+   ---------------------------------------------------------------
+   I/O:     COREENGINE *ce      Core engine
+            ZONELIST   *zones   Current zones
+   Input:   REAL       cutsq    Squared distance cutoff
+
+   Update the core flags and the current zones by extending out from
+   the secondary structure regions. Each end of a zone is extended
+   while every pair of structures is within the cutoff, up to the
+   residue before one which is already in the core.
+
+   Positions which are added are also added to any fitting sums which
+   are being kept up to date. Every zone must start and end at a
+   C-alpha in the stores (ZoneEndsInStore()).
+
+   14.11.96 Original   By: ACRM
+   13.03.97 Now checks that residues are not already in a zone before
+            adding them to the current zone. Fixes a problem at the
+            zone-merge stage where the merged zones could end up with
+            different numbers of residues.
+   08.05.02 Generalized to work with multiple structures
+   16.10.26 Added fitting sums
+   16.10.26 Works on C-alpha stores
+   16.10.26 Zone ends are found with FindCAResidue()
+   16.10.26 Distances are checked in blocks with CAFirstOverCut() up to
+            the next residue already in the core
+   16.10.26 Merged the findcore and findcora versions
+*/
+void UpdateBValues(COREENGINE *ce, ZONELIST *zones, REAL cutsq)
+{
+   CASTORE **cas   = ce->cas;
+   int     nstruc  = ce->nstruc,
+           *offset = ce->offset,
+           z, s, k, m, n;
+   VEC3F   ref, fit;
+
+   for(z=0; z<zones->nzones; z++)
+   {
+      if(ZONEDELETED(zones, z))
+         continue;
+
+      /* Step back from the start of the zone. We can go as far as the
+         residue after one already in the core
+      */
+      for(s=0; s<nstruc; s++)
+         offset[s] = FindCAResidue(cas[s], ZSTART(zones, z, s)) - 1;
+      n = offset[0] - PrevCACore(cas[0], offset[0]);
+      for(s=1; s<nstruc; s++)
+      {
+         m = offset[s] - PrevCACore(cas[s], offset[s]);
+         n = MIN(n, m);
+      }
+      n = CAFirstOverCut(cas, nstruc, offset, -1, n, cutsq, ce->test,
+                         ce->radius);
+
+      for(k=0; k<n; k++)
+      {
+         for(s=0; s<nstruc; s++)
+            CASETCORE(cas[s], offset[s] - k);
+         for(s=1; s<nstruc; s++)
+         {
+            if(ce->incremental[s])
+            {
+               CACOOR(ref, cas[0], offset[0] - k);
+               CACOOR(fit, cas[s], offset[s] - k);
+               AddFitPair(&(ce->sums[s]), &ref, &fit);
+            }
+         }
+      }
+
+      for(s=0; s<nstruc; s++)
+         ZSTART(zones, z, s) = cas[s]->resnum[offset[s] - n + 1];
+
+      /* Step forward from the end of the zone as far as the residue
+         before the next one in the core
+      */
+      for(s=0; s<nstruc; s++)
+         offset[s] = FindCAResidue(cas[s], ZEND(zones, z, s)) + 1;
+      n = NextCACore(cas[0], offset[0]) - offset[0];
+      for(s=1; s<nstruc; s++)
+      {
+         m = NextCACore(cas[s], offset[s]) - offset[s];
+         n = MIN(n, m);
+      }
+      n = CAFirstOverCut(cas, nstruc, offset, 1, n, cutsq, ce->test,
+                         ce->radius);
+
+      for(k=0; k<n; k++)
+      {
+         for(s=0; s<nstruc; s++)
+            CASETCORE(cas[s], offset[s] + k);
+         for(s=1; s<nstruc; s++)
+         {
+            if(ce->incremental[s])
+            {
+               CACOOR(ref, cas[0], offset[0] + k);
+               CACOOR(fit, cas[s], offset[s] + k);
+               AddFitPair(&(ce->sums[s]), &ref, &fit);
+            }
+         }
+      }
+
+      for(s=0; s<nstruc; s++)
+         ZEND(zones, z, s) = cas[s]->resnum[offset[s] + n - 1];
+   }
+}
+
+
+/************************************************************************/
+/*>static BOOL AllInCore(COREENGINE *ce, int *pos)
+   -----------------------------------------------
+   Input:   COREENGINE *ce      Core engine
+            int        *pos     C-alpha offset in each structure
+   Returns: BOOL                All the C-alphas are in the core
+
+   16.10.26 Original   By: ACRM
+*/
+static BOOL AllInCore(COREENGINE *ce, int *pos)
+{
+   int s;
+
+   for(s=0; s<ce->nstruc; s++)
+   {
+      if(!CAINCORE(ce->cas[s], pos[s]))
+         return(FALSE);
+   }
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static int ZoneLength(COREENGINE *ce)
+   -------------------------------------
+   Input:   COREENGINE *ce      Core engine
+   Returns: int                 Smallest end - start of the zone being
+                                worked on over all the structures
+
+   16.10.26 Original   By: ACRM
+*/
+static int ZoneLength(COREENGINE *ce)
+{
+   int s,
+       len = ce->end[0] - ce->start[0];
+
+   for(s=1; s<ce->nstruc; s++)
+      len = MIN(len, ce->end[s] - ce->start[s]);
+   return(len);
+}
+
+
+/************************************************************************/
+/*>static BOOL ZoneAnyCore(COREENGINE *ce, int len)
+   ------------------------------------------------
+   Input:   COREENGINE *ce      Core engine
+            int        len      Length of the zone being worked on
+   Returns: BOOL                Any structure has something in the core
+                                in the zone
+
+   16.10.26 Original   By: ACRM
+*/
+static BOOL ZoneAnyCore(COREENGINE *ce, int len)
+{
+   int s;
+
+   for(s=0; s<ce->nstruc; s++)
+   {
+      if(AnyCACore(ce->cas[s], ce->start[s], ce->start[s]+len))
+         return(TRUE);
+   }
+   return(FALSE);
+}
+
+
+/************************************************************************/
+/*>static BOOL ZoneAllCore(COREENGINE *ce, int len)
+   ------------------------------------------------
+   Input:   COREENGINE *ce      Core engine
+            int        len      Length of the zone being worked on
+   Returns: BOOL                Every structure has the whole zone in
+                                the core
+
+   16.10.26 Original   By: ACRM
+*/
+static BOOL ZoneAllCore(COREENGINE *ce, int len)
+{
+   int s;
+
+   for(s=0; s<ce->nstruc; s++)
+   {
+      if(!AllCACore(ce->cas[s], ce->start[s], ce->start[s]+len))
+         return(FALSE);
+   }
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL BuildFitSums(FITSUMS *fs, CASTORE *cas1, CASTORE *cas2)
+   -------------------------------------------------------------------
+   I/O:     FITSUMS *fs          Fitting sums
+   Input:   CASTORE *cas1        Reference C-alphas
+            CASTORE *cas2        Mobile C-alphas
+   Returns: BOOL                 Same number of CAs flagged in each
+
+   Rebuilds the fitting sums from scratch. The C-alphas flagged as core
+   are paired off in order.
+
+   16.10.26 Original based on DupeCAByBVal()   By: ACRM
+*/
+static BOOL BuildFitSums(FITSUMS *fs, CASTORE *cas1, CASTORE *cas2)
+{
+   int   i = 0,
+         j = 0;
+   VEC3F ref, fit;
+
+   ClearFitSums(fs);
+   for(;;)
+   {
+      i = NextCACore(cas1, i);
+      j = NextCACore(cas2, j);
+      if((i>=cas1->ncas) || (j>=cas2->ncas))
+         break;
+
+      CACOOR(ref, cas1, i);
+      CACOOR(fit, cas2, j);
+      AddFitPair(fs, &ref, &fit);
+      i++;
+      j++;
+   }
+
+   /* Check that neither structure has flagged CAs left over            */
+   i = NextCACore(cas1, i);
+   j = NextCACore(cas2, j);
+   return((i>=cas1->ncas) && (j>=cas2->ncas));
+}
+
+
+/************************************************************************/
+/*>static BOOL PairsMatchZones(CASTORE *cas1, CASTORE *cas2,
+                               ZONELIST *zones, int which)
+   ---------------------------------------------------------
+   Input:   CASTORE *cas1        C-alphas of the first structure
+            CASTORE *cas2        C-alphas of structure which
+            ZONELIST *zones      Current zones
+            int     which        Structure being paired with the first
+   Returns: BOOL                 Flagged pairs correspond to the zones
+
+   Checks that pairing off the flagged CAs in order gives the same
+   residue pairs as stepping through the zones. If it does, adding and
+   removing pairs at the same position in both structures (as DoCut()
+   and UpdateBValues() do) keeps this true and the fitting sums can be
+   updated as we go. Zones are located by residue number, so this also
+   requires the residue numbers to be unique and ascending.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Zone ends are found with FindCAResidue()
+*/
+static BOOL PairsMatchZones(CASTORE *cas1, CASTORE *cas2,
+                            ZONELIST *zones, int which)
+{
+   int  *partner,
+        z, i, j,
+        natom1 = cas1->ncas,
+        natom2 = cas2->ncas;
+   BOOL ok = TRUE;
+
+   for(i=1; i<natom1; i++)
+      if(cas1->resnum[i] <= cas1->resnum[i-1])
+         return(FALSE);
+   for(j=1; j<natom2; j++)
+      if(cas2->resnum[j] <= cas2->resnum[j-1])
+         return(FALSE);
+
+   if((partner = (int *)malloc((natom1?natom1:1) * sizeof(int)))==NULL)
+      return(FALSE);
+   for(i=0; i<natom1; i++)
+      partner[i] = (-1);
+
+   /* Record the partner of each residue by stepping through the zones  */
+   for(z=0; z<zones->nzones; z++)
+   {
+      i = FindCAResidue(cas1, ZSTART(zones, z, 0));
+      j = FindCAResidue(cas2, ZSTART(zones, z, which));
+
+      for(; (i<natom1) && (j<natom2) &&
+             (cas1->resnum[i] <= ZEND(zones, z, 0)) &&
+             (cas2->resnum[j] <= ZEND(zones, z, which));
+          i++, j++)
+      {
+         if(partner[i] != (-1))
+            ok = FALSE;
+         partner[i] = j;
+      }
+   }
+
+   /* Now check these against the flagged CAs paired off in order       */
+   i = j = 0;
+   while(ok)
+   {
+      i = NextCACore(cas1, i);
+      j = NextCACore(cas2, j);
+      if((i>=natom1) || (j>=natom2))
+         break;
+      if(partner[i] != j)
+         ok = FALSE;
+      i++;
+      j++;
+   }
+
+   free(partner);
+   return(ok);
+}
@@ -0,0 +1,116 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       coreeng.h
+
+   Version:    V1.5
+   Date:       16.10.26
+   Function:   Core definition engine shared by findcore and findcora
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 Fits can be run on a thread pool
+   V1.2  16.10.26 Structures can be fitted to their mean instead of the
+                  first
+   V1.3  16.10.26 The fitting backend and deviation test are held in
+                  the engine
+   V1.4  16.10.26 Added the workspace for CAFirstOverCut()
+   V1.5  16.10.26 Added ZoneEndsInStore()
+
+*************************************************************************/
+#ifndef _COREENG_H
+#define _COREENG_H
+
+/************************************************************************/
+/* Includes
+*/
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+#include "bioplib/pdb.h"
+#include "corefit.h"
+#include "castore.h"
+#include "zonelist.h"
+#include "distkern.h"
+#include "pool.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define CORE_MAXITER 1000
+
+/* Rounds of fitting to the mean structure before it is taken as
+   settled, and the mean squared movement of its points which counts
+   as settled
+*/
+#define CORE_MAXMEAN 20
+#define CORE_MEANTOL ((REAL)1.0e-6)
+
+/* Workspace held in the engine itself for up to this many structures  */
+#define CORE_SMALLN  8
+
+/* Everything needed to find the core of nstruc aligned structures.
+   Every structure is fitted onto the first; sums[s] and incremental[s]
+   are for fitting structure s (sums[0] is unused). start[], end[] and
+   offset[] are per-structure workspace for walking along a zone.
+   If pool is set the fits are shared out over its threads.
+
+   If consensus is set every structure (including the first) is
+   instead fitted to the mean of the fitted cores, held in mean[].
+   sums[s] are then for fitting structure s onto the mean.
+
+   backend is how the fits are done (FITBACKEND_MATFIT or _QCP) and
+   test how positions are tested against the cutoff (CATEST_PAIRS or
+   _CENTROID).
+*/
+typedef struct
+{
+   int        nstruc;        /* Number of structures                    */
+   CASTORE    **cas;         /* C-alphas of each structure              */
+   FITSUMS    *sums;         /* Sums for fitting onto the first         */
+   BOOL       *incremental;  /* sums[s] are kept up to date             */
+   int        *start,        /* Zone start in each structure            */
+              *end,          /* Zone end in each structure              */
+              *offset;       /* Position being tested                   */
+   REAL       *radius;       /* Workspace for CAFirstOverCut()          */
+   THREADPOOL *pool;         /* Threads for fitting (or NULL)           */
+   BOOL       consensus;     /* Fit to the mean structure               */
+   VEC3F      *mean,         /* Mean structure                          */
+              *lastMean;     /* Mean structure from the last round      */
+   int        nmean;         /* Number of points in mean[]              */
+   int        backend,       /* Fitting backend                         */
+              test;          /* Deviation test                          */
+   int        smallWork[3 * CORE_SMALLN];
+}  COREENGINE;
+
+/************************************************************************/
+/* Prototypes
+*/
+COREENGINE *NewCoreEngine(PDB **pdb, int nstruc, ZONELIST *zones,
+                          BOOL single);
+void FreeCoreEngine(COREENGINE *ce);
+void SetCoreByZone(CASTORE *cas, ZONELIST *zones, int which);
+BOOL ZoneEndsInStore(CASTORE *cas, ZONELIST *zones, int which);
+BOOL FitCore(COREENGINE *ce, int s);
+void FitAllCores(COREENGINE *ce);
+BOOL DoCut(COREENGINE *ce, ZONELIST *zones, REAL cutsq);
+void UpdateBValues(COREENGINE *ce, ZONELIST *zones, REAL cutsq);
+BOOL IterateCore(COREENGINE *ce, ZONELIST *zones, REAL cutsq);
+
+#endif
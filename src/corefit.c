@@ -0,0 +1,397 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       corefit.c
+
+   Version:    V1.2
+   Date:       16.10.26
+   Function:   Incremental least squares fitting of core residue pairs
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Description:
+   ============
+   The core definition iterates a fit on the residue pairs currently
+   in the core. Between iterations only a few pairs are added or
+   removed, so rather than extracting the flagged C-alphas and fitting
+   from scratch each time, we keep the sums needed to build the
+   centres of geometry and the 3x3 correlation matrix. Adding or
+   removing a pair is then O(1) and a refit is a 3x3 problem.
+
+   By default the rotation is obtained from blMatfit(). Since the
+   correlation matrix blMatfit() builds is bilinear in the two
+   coordinate sets, passing the three unit vectors as the reference
+   coordinates and the rows of our correlation matrix as the mobile
+   coordinates gives it exactly the matrix it would have built from
+   the full (centred) coordinate sets.
+
+   SolveFitSums() can instead use the QCP method (qcpfit.c) which works
+   from the same matrix plus the sums of squares without iterating
+   over a rotation. If QCP can't define a rotation, blMatfit() is used
+   for that fit. FitSumsRMSD() always uses QCP since it needs no
+   rotation at all.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 Added the QCP backend and FitSumsRMSD()
+   V1.2  16.10.26 The backend is passed to SolveFitSums() rather than
+                  held here, so fits can be run with different backends
+                  at once
+
+*************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+#include "bioplib/fit.h"
+#include "bioplib/matrix.h"
+#include "corefit.h"
+#include "qcpfit.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+
+/************************************************************************/
+/* Prototypes
+*/
+static void AccumulatePair(FITSUMS *fs, VEC3F *ref, VEC3F *fit,
+                           REAL weight);
+static void CentredSums(FITSUMS *fs, REAL refMean[3], REAL fitMean[3],
+                        REAL corr[3][3], REAL *E0);
+
+
+/************************************************************************/
+/*>void InitFitSums(FITSUMS *fs, VEC3F refOrigin, VEC3F fitOrigin)
+   ---------------------------------------------------------------
+   I/O:     FITSUMS *fs         Fitting sums
+   Input:   VEC3F   refOrigin   Origin for reference coordinates
+            VEC3F   fitOrigin   Origin for mobile coordinates
+
+   Initialize a set of fitting sums. The origins should be somewhere
+   near the middle of each structure (e.g. the C-alpha centre of
+   geometry) to reduce rounding in the cross terms. The rotation is
+   set to the identity so an unfitted structure is left where it is.
+
+   16.10.26 Original   By: ACRM
+*/
+void InitFitSums(FITSUMS *fs, VEC3F refOrigin, VEC3F fitOrigin)
+{
+   int i, j;
+
+   fs->refOrigin = refOrigin;
+   fs->fitOrigin = fitOrigin;
+   fs->refCofG   = refOrigin;
+   fs->fitCofG   = fitOrigin;
+
+   for(i=0; i<3; i++)
+      for(j=0; j<3; j++)
+         fs->rot[i][j] = (REAL)((i==j)?1.0:0.0);
+
+   ClearFitSums(fs);
+}
+
+
+/************************************************************************/
+/*>void ClearFitSums(FITSUMS *fs)
+   ------------------------------
+   I/O:     FITSUMS *fs         Fitting sums
+
+   Empties the sums without changing the origins or the current
+   rotation
+
+   16.10.26 Original   By: ACRM
+*/
+void ClearFitSums(FITSUMS *fs)
+{
+   int i, j;
+
+   fs->npairs   = 0;
+   fs->sumSqRef = fs->sumSqFit = (REAL)0.0;
+   for(i=0; i<3; i++)
+   {
+      fs->sumRef[i] = fs->sumFit[i] = (REAL)0.0;
+      for(j=0; j<3; j++)
+         fs->sumCross[i][j] = (REAL)0.0;
+   }
+}
+
+
+/************************************************************************/
+/*>void AddFitPair(FITSUMS *fs, VEC3F *ref, VEC3F *fit)
+   ----------------------------------------------------
+   I/O:     FITSUMS *fs         Fitting sums
+   Input:   VEC3F   *ref        Reference coordinate
+            VEC3F   *fit        Equivalent (unfitted) mobile coordinate
+
+   Add a residue pair to the sums
+
+   16.10.26 Original   By: ACRM
+*/
+void AddFitPair(FITSUMS *fs, VEC3F *ref, VEC3F *fit)
+{
+   AccumulatePair(fs, ref, fit, (REAL)1.0);
+   (fs->npairs)++;
+}
+
+
+/************************************************************************/
+/*>void RemoveFitPair(FITSUMS *fs, VEC3F *ref, VEC3F *fit)
+   -------------------------------------------------------
+   I/O:     FITSUMS *fs         Fitting sums
+   Input:   VEC3F   *ref        Reference coordinate
+            VEC3F   *fit        Equivalent (unfitted) mobile coordinate
+
+   Remove a residue pair which was earlier added with AddFitPair()
+
+   16.10.26 Original   By: ACRM
+*/
+void RemoveFitPair(FITSUMS *fs, VEC3F *ref, VEC3F *fit)
+{
+   AccumulatePair(fs, ref, fit, (REAL)(-1.0));
+   (fs->npairs)--;
+}
+
+
+/************************************************************************/
+/*>BOOL SolveFitSums(FITSUMS *fs, int backend)
+   -------------------------------------------
+   I/O:     FITSUMS *fs         Fitting sums
+   Input:   int     backend     FITBACKEND_MATFIT or FITBACKEND_QCP
+   Returns: BOOL                Success
+
+   Calculates the centres of geometry and the rotation which best fits
+   the mobile pairs onto the reference pairs. Can't fit with fewer than
+   3 pairs in which case the previous fit is left unchanged.
+
+   16.10.26 Original based on FitCaPDBBFlag()   By: ACRM
+   16.10.26 Can use QCP for the rotation
+   16.10.26 Takes the backend rather than using a global
+*/
+BOOL SolveFitSums(FITSUMS *fs, int backend)
+{
+   COOR  axes[3],
+         corr[3];
+   REAL  RotMat[3][3],
+         C[3][3],
+         rot[3][3],
+         E0,
+         refMean[3],
+         fitMean[3];
+   VEC3F col;
+   int   i, j;
+
+   if(fs->npairs < 3)
+      return(FALSE);
+
+   CentredSums(fs, refMean, fitMean, C, &E0);
+
+   if(!((backend == FITBACKEND_QCP) &&
+        QCPFit(C, E0, fs->npairs, rot, NULL)))
+   {
+      /* Hand the correlation matrix to blMatfit() as three
+         pseudo-coordinate pairs
+      */
+      for(i=0; i<3; i++)
+      {
+         axes[i].x = (REAL)((i==0)?1.0:0.0);
+         axes[i].y = (REAL)((i==1)?1.0:0.0);
+         axes[i].z = (REAL)((i==2)?1.0:0.0);
+
+         corr[i].x = C[i][0];
+         corr[i].y = C[i][1];
+         corr[i].z = C[i][2];
+      }
+
+      if(!blMatfit(axes, corr, RotMat, 3, NULL, FALSE))
+         return(FALSE);
+
+      /* Convert to our own x' = rot . x convention by pushing the unit
+         vectors through the same routine blApplyMatrixPDB() uses
+      */
+      for(j=0; j<3; j++)
+      {
+         blMatMult3_33(axes[j], RotMat, &col);
+         rot[0][j] = col.x;
+         rot[1][j] = col.y;
+         rot[2][j] = col.z;
+      }
+   }
+
+   for(i=0; i<3; i++)
+      for(j=0; j<3; j++)
+         fs->rot[i][j] = rot[i][j];
+
+   fs->refCofG.x = fs->refOrigin.x + refMean[0];
+   fs->refCofG.y = fs->refOrigin.y + refMean[1];
+   fs->refCofG.z = fs->refOrigin.z + refMean[2];
+   fs->fitCofG.x = fs->fitOrigin.x + fitMean[0];
+   fs->fitCofG.y = fs->fitOrigin.y + fitMean[1];
+   fs->fitCofG.z = fs->fitOrigin.z + fitMean[2];
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>REAL FitSumsRMSD(FITSUMS *fs)
+   -----------------------------
+   Input:   FITSUMS *fs         Fitting sums
+   Returns: REAL                RMSD of the pairs in the sums after the
+                                best fit (0 if there are none)
+
+   The RMSD comes straight from the sums without finding the rotation,
+   so the sums needn't have been solved
+
+   16.10.26 Original   By: ACRM
+*/
+REAL FitSumsRMSD(FITSUMS *fs)
+{
+   REAL C[3][3],
+        E0,
+        refMean[3],
+        fitMean[3],
+        rmsd = (REAL)0.0;
+
+   if(fs->npairs < 1)
+      return(rmsd);
+
+   CentredSums(fs, refMean, fitMean, C, &E0);
+   QCPFit(C, E0, fs->npairs, NULL, &rmsd);
+
+   return(rmsd);
+}
+
+
+/************************************************************************/
+/*>void ApplyFitSums(FITSUMS *fs, VEC3F *in, VEC3F *out)
+   -----------------------------------------------------
+   Input:   FITSUMS *fs         Fitting sums after SolveFitSums()
+            VEC3F   *in         Unfitted mobile coordinate
+   Output:  VEC3F   *out        Coordinate after fitting
+
+   Moves a mobile coordinate onto the reference using the last fit.
+   in and out may be the same.
+
+   16.10.26 Original   By: ACRM
+*/
+void ApplyFitSums(FITSUMS *fs, VEC3F *in, VEC3F *out)
+{
+   REAL x, y, z;
+
+   x = in->x - fs->fitCofG.x;
+   y = in->y - fs->fitCofG.y;
+   z = in->z - fs->fitCofG.z;
+
+   out->x = fs->rot[0][0]*x + fs->rot[0][1]*y + fs->rot[0][2]*z
+            + fs->refCofG.x;
+   out->y = fs->rot[1][0]*x + fs->rot[1][1]*y + fs->rot[1][2]*z
+            + fs->refCofG.y;
+   out->z = fs->rot[2][0]*x + fs->rot[2][1]*y + fs->rot[2][2]*z
+            + fs->refCofG.z;
+}
+
+
+/************************************************************************/
+/*>static void CentredSums(FITSUMS *fs, REAL refMean[3],
+                           REAL fitMean[3], REAL corr[3][3], REAL *E0)
+   -------------------------------------------------------------------
+   Input:   FITSUMS *fs          Fitting sums (at least one pair)
+   Output:  REAL    refMean[3]   Mean reference coordinate
+            REAL    fitMean[3]   Mean mobile coordinate
+            REAL    corr[3][3]   Correlation matrix of the centred
+                                 coordinates
+            REAL    *E0          Half the sum of the squared distances
+                                 of both sets from their centres
+
+   All relative to the origins in the sums
+
+   16.10.26 Original   By: ACRM
+*/
+static void CentredSums(FITSUMS *fs, REAL refMean[3], REAL fitMean[3],
+                        REAL corr[3][3], REAL *E0)
+{
+   REAL n = (REAL)fs->npairs,
+        refSq,
+        fitSq;
+   int  i, j;
+
+   for(i=0; i<3; i++)
+   {
+      refMean[i] = fs->sumRef[i] / n;
+      fitMean[i] = fs->sumFit[i] / n;
+   }
+
+   for(i=0; i<3; i++)
+      for(j=0; j<3; j++)
+         corr[i][j] = fs->sumCross[i][j] - n * refMean[i] * fitMean[j];
+
+   refSq = fs->sumSqRef - n * (refMean[0] * refMean[0] +
+                               refMean[1] * refMean[1] +
+                               refMean[2] * refMean[2]);
+   fitSq = fs->sumSqFit - n * (fitMean[0] * fitMean[0] +
+                               fitMean[1] * fitMean[1] +
+                               fitMean[2] * fitMean[2]);
+   *E0 = (REAL)0.5 * (refSq + fitSq);
+}
+
+
+/************************************************************************/
+/*>static void AccumulatePair(FITSUMS *fs, VEC3F *ref, VEC3F *fit,
+                              REAL weight)
+   ----------------------------------------------------------------
+   I/O:     FITSUMS *fs         Fitting sums
+   Input:   VEC3F   *ref        Reference coordinate
+            VEC3F   *fit        Mobile coordinate
+            REAL    weight      +1 to add, -1 to remove
+
+   Does the work for AddFitPair() and RemoveFitPair()
+
+   16.10.26 Original   By: ACRM
+*/
+static void AccumulatePair(FITSUMS *fs, VEC3F *ref, VEC3F *fit,
+                           REAL weight)
+{
+   REAL r[3], f[3];
+   int  i, j;
+
+   r[0] = weight * (ref->x - fs->refOrigin.x);
+   r[1] = weight * (ref->y - fs->refOrigin.y);
+   r[2] = weight * (ref->z - fs->refOrigin.z);
+   f[0] = fit->x - fs->fitOrigin.x;
+   f[1] = fit->y - fs->fitOrigin.y;
+   f[2] = fit->z - fs->fitOrigin.z;
+
+   for(i=0; i<3; i++)
+   {
+      fs->sumRef[i] += r[i];
+      fs->sumFit[i] += weight * f[i];
+      fs->sumSqRef  += weight * r[i] * r[i];
+      fs->sumSqFit  += weight * f[i] * f[i];
+      for(j=0; j<3; j++)
+         fs->sumCross[i][j] += r[i] * f[j];
+   }
+}
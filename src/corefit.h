@@ -0,0 +1,79 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       corefit.h
+   
+   Version:    V1.2
+   Date:       16.10.26
+   Function:   Incremental least squares fitting of core residue pairs
+   
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+               
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 Added the QCP backend and FitSumsRMSD()
+   V1.2  16.10.26 The backend is passed to SolveFitSums()
+
+*************************************************************************/
+#ifndef _COREFIT_H
+#define _COREFIT_H
+
+/************************************************************************/
+/* Includes
+*/
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+/* Ways of finding the rotation                                         */
+#define FITBACKEND_MATFIT 0
+#define FITBACKEND_QCP    1
+
+/* Running sums for fitting one mobile structure onto the reference.
+   Coordinates are accumulated relative to a fixed origin for each
+   structure to keep the cross terms small.
+*/
+typedef struct
+{
+   int   npairs;             /* Number of residue pairs in the sums     */
+   VEC3F refOrigin,          /* Origin subtracted from reference coords */
+         fitOrigin,          /* Origin subtracted from mobile coords    */
+         refCofG,            /* Centre of geometry of fitted ref pairs  */
+         fitCofG;            /* Centre of geometry of fitted mob pairs  */
+   REAL  sumRef[3],          /* Sum of reference coordinates            */
+         sumFit[3],          /* Sum of mobile coordinates               */
+         sumSqRef,           /* Sum of squared reference coordinates    */
+         sumSqFit,           /* Sum of squared mobile coordinates       */
+         sumCross[3][3],     /* sumCross[i][j] = Sum ref[i] * fit[j]    */
+         rot[3][3];          /* Current rotation: x' = rot . x          */
+}  FITSUMS;
+
+/************************************************************************/
+/* Prototypes
+*/
+void InitFitSums(FITSUMS *fs, VEC3F refOrigin, VEC3F fitOrigin);
+void ClearFitSums(FITSUMS *fs);
+void AddFitPair(FITSUMS *fs, VEC3F *ref, VEC3F *fit);
+void RemoveFitPair(FITSUMS *fs, VEC3F *ref, VEC3F *fit);
+BOOL SolveFitSums(FITSUMS *fs, int backend);
+void ApplyFitSums(FITSUMS *fs, VEC3F *in, VEC3F *out);
+REAL FitSumsRMSD(FITSUMS *fs);
+
+#endif
@@ -0,0 +1,881 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       distkern.c
+
+   Version:    V1.4
+   Date:       16.10.26
+   Function:   Batched C-alpha distance checks for zone extension and
+               cutting
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Description:
+   ============
+   Extending a zone and cutting a zone both step along a run of aligned
+   positions testing whether every pair of structures is within the
+   cutoff, stopping at (or acting on) the first position which isn't.
+   CAFirstOverCut() does that test for a whole run. The positions are
+   handled a block at a time: each structure's C-alphas for the block
+   are moved by its current fit, the squared deviations for every pair
+   of structures are compared with the cutoff together and the first
+   failing position is read off the comparison mask.
+
+   On x86 built with gcc the block is 8 positions (AVX-512) or 4 (AVX),
+   chosen (once, by whichever thread gets there first) the first time
+   the kernel is used according to what the CPU supports. Anything
+   else, or a build with -DNOSIMD, does one position at a time.
+   Coordinates are REAL (double) so those are the widths the vector
+   registers allow. Single precision stores have their own kernels
+   working on twice as many positions per block (16 or 8), and then
+   the cutoff is compared in float too.
+
+   The vector code does the same operations in the same order as
+   CAFitted() and CADistSq() without fused multiply-adds, so every path
+   finds exactly the same positions for a given precision.
+
+   Testing every pair is O(S^2) in the number of structures. With
+   CAPRUNE_MINSTRUC or more structures each position is first compared
+   with the centroid of the fitted C-alphas, which is O(S). If any
+   structure is further than the cutoff from the centroid, some pair
+   must be further apart than the cutoff; if the two furthest from it
+   are within the cutoff of each other even when on opposite sides of
+   it, every pair must be. Only when neither is true are pairs
+   checked, and then only those whose distances from the centroid add
+   up to more than the cutoff. The bounds allow a margin (CAPRUNE_TOL)
+   for rounding and anything that close is settled by CADistSq(), so
+   the positions found are exactly those found by testing every pair.
+
+   The CATEST_CENTROID test instead accepts a position if every
+   structure is within the cutoff of the centroid. That is always O(S)
+   but it is a different (looser) test, so gives a different core.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 Single precision kernels
+   V1.2  16.10.26 Bounds from the centroid skip most pairwise checks
+                  when there are many structures. Added the centroid
+                  deviation test
+   V1.3  16.10.26 The deviation test is passed to CAFirstOverCut()
+                  rather than held here, and the kernel is chosen with
+                  pthread_once(), so any number of threads can find
+                  cores at once with different settings
+   V1.4  16.10.26 The workspace for the centroid bounds is passed in
+                  rather than allocated on every call
+
+*************************************************************************/
+/* Includes
+*/
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+#include "bioplib/macros.h"
+#include "castore.h"
+#include "distkern.h"
+
+#if defined(__GNUC__) && !defined(NOSIMD) &&                  \
+    (defined(__x86_64__) || defined(__i386__)) &&             \
+    ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))
+#  define CAKERN_X86
+#  include <immintrin.h>
+#endif
+
+/************************************************************************/
+/* Defines and macros
+*/
+typedef int (*CAKERNEL)(CASTORE **cas, int nstruc, int *offset,
+                        int dir, int n, REAL cutsq);
+
+/* Bound positions using the centroid from this many structures         */
+#ifndef CAPRUNE_MINSTRUC
+#  define CAPRUNE_MINSTRUC 16
+#endif
+
+/* Relative margin on the cutoff before a bound is trusted              */
+#define CAPRUNE_TOL ((REAL)1.0e-4)
+
+/************************************************************************/
+/* Globals
+*/
+static CAKERNEL       sKernel       = NULL,
+                      sKernelSingle = NULL;
+static char           *sKernelName  = "scalar";
+static pthread_once_t sKernelOnce   = PTHREAD_ONCE_INIT;
+
+/************************************************************************/
+/* Prototypes
+*/
+static void ChooseKernel(void);
+static int ScalarFirstOverCut(CASTORE **cas, int nstruc, int *offset,
+                              int dir, int n, REAL cutsq);
+static int ScalarRun(CASTORE **cas, int nstruc, int *offset, int dir,
+                     int k, int n, REAL cutsq);
+static int CentroidRun(CASTORE **cas, int nstruc, int *offset, int dir,
+                       int n, REAL cutsq, REAL *radius);
+#ifdef CAKERN_X86
+static void AVXFitted(CASTORE *cas, int first, __m256d *fx,
+                      __m256d *fy, __m256d *fz)
+   __attribute__((target("avx")));
+static int AVXFirstOverCut(CASTORE **cas, int nstruc, int *offset,
+                           int dir, int n, REAL cutsq)
+   __attribute__((target("avx")));
+static void AVX512Fitted(CASTORE *cas, int first, __mmask8 lanes,
+                         __m512d *fx, __m512d *fy, __m512d *fz)
+   __attribute__((target("avx512f")));
+static int AVX512FirstOverCut(CASTORE **cas, int nstruc, int *offset,
+                              int dir, int n, REAL cutsq)
+   __attribute__((target("avx512f")));
+static void AVXFittedSingle(CASTORE *cas, int first, __m256 *fx,
+                            __m256 *fy, __m256 *fz)
+   __attribute__((target("avx")));
+static int AVXFirstOverCutSingle(CASTORE **cas, int nstruc,
+                                 int *offset, int dir, int n,
+                                 REAL cutsq)
+   __attribute__((target("avx")));
+static void AVX512FittedSingle(CASTORE *cas, int first,
+                               __mmask16 lanes, __m512 *fx,
+                               __m512 *fy, __m512 *fz)
+   __attribute__((target("avx512f")));
+static int AVX512FirstOverCutSingle(CASTORE **cas, int nstruc,
+                                    int *offset, int dir, int n,
+                                    REAL cutsq)
+   __attribute__((target("avx512f")));
+#endif
+
+
+/************************************************************************/
+/*>int CAFirstOverCut(CASTORE **cas, int nstruc, int *offset, int dir,
+                      int n, REAL cutsq, int test)
+   -------------------------------------------------------------------
+   Input:   CASTORE  **cas      C-alpha stores
+            int      nstruc     Number of structures
+            int      *offset    First C-alpha to test in each store
+            int      dir        1 to step forwards, -1 to step back
+            int      n          Number of positions to test
+            REAL     cutsq      Squared distance cutoff
+            int      test       CATEST_PAIRS or CATEST_CENTROID
+            REAL     *radius    Workspace for nstruc distances from
+                                the centroid
+   Returns: int                 Number of positions before the first
+                                one where some pair of structures is
+                                further apart than the cutoff. n if
+                                they are all within it.
+
+   Position k is C-alpha offset[s] + k*dir of each structure s. The
+   caller must make sure all n positions exist in every store. The
+   stores must all be the same precision.
+
+   With the centroid test (CATEST_CENTROID) a position is instead
+   out of range if any structure is further than the cutoff from the
+   centroid.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Uses the single precision kernel for single precision
+            stores
+   16.10.26 Uses the centroid bounds for many structures and does the
+            centroid test
+   16.10.26 Takes the test rather than using a global. The kernel is
+            chosen with pthread_once()
+   16.10.26 Takes the workspace for the bounds
+*/
+int CAFirstOverCut(CASTORE **cas, int nstruc, int *offset, int dir,
+                   int n, REAL cutsq, int test, REAL *radius)
+{
+   pthread_once(&sKernelOnce, ChooseKernel);
+
+   if((n <= 0) || (nstruc < 2))
+      return((n > 0) ? n : 0);
+
+   if(test == CATEST_CENTROID)
+      return(CentroidRun(cas, nstruc, offset, dir, n, cutsq, NULL));
+
+   if(nstruc >= CAPRUNE_MINSTRUC)
+      return(CentroidRun(cas, nstruc, offset, dir, n, cutsq, radius));
+
+   if(cas[0]->single)
+      return((*sKernelSingle)(cas, nstruc, offset, dir, n, cutsq));
+   return((*sKernel)(cas, nstruc, offset, dir, n, cutsq));
+}
+
+
+/************************************************************************/
+/*>char *CAKernelName(void)
+   ------------------------
+   Returns: char *              Name of the distance kernel in use
+
+   16.10.26 Original   By: ACRM
+   16.10.26 The kernel is chosen with pthread_once()
+*/
+char *CAKernelName(void)
+{
+   pthread_once(&sKernelOnce, ChooseKernel);
+
+   return(sKernelName);
+}
+
+
+/************************************************************************/
+/*>static void ChooseKernel(void)
+   ------------------------------
+   Picks the widest kernels the CPU will run. The double precision
+   vector kernels assume REAL is double. Called once through
+   pthread_once().
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Also picks the single precision kernel
+*/
+static void ChooseKernel(void)
+{
+   sKernel       = ScalarFirstOverCut;
+   sKernelSingle = ScalarFirstOverCut;
+   sKernelName   = "scalar";
+
+#ifdef CAKERN_X86
+   __builtin_cpu_init();
+   if(__builtin_cpu_supports("avx512f"))
+   {
+      sKernelSingle = AVX512FirstOverCutSingle;
+      sKernelName   = "AVX-512";
+      if(sizeof(REAL) == sizeof(double))
+         sKernel    = AVX512FirstOverCut;
+   }
+   else if(__builtin_cpu_supports("avx"))
+   {
+      sKernelSingle = AVXFirstOverCutSingle;
+      sKernelName   = "AVX";
+      if(sizeof(REAL) == sizeof(double))
+         sKernel    = AVXFirstOverCut;
+   }
+#endif
+}
+
+
+/************************************************************************/
+/*>static int ScalarFirstOverCut(CASTORE **cas, int nstruc, int *offset,
+                                 int dir, int n, REAL cutsq)
+   ---------------------------------------------------------------------
+   Portable version of CAFirstOverCut()
+
+   16.10.26 Original   By: ACRM
+*/
+static int ScalarFirstOverCut(CASTORE **cas, int nstruc, int *offset,
+                              int dir, int n, REAL cutsq)
+{
+   return(ScalarRun(cas, nstruc, offset, dir, 0, n, cutsq));
+}
+
+
+/************************************************************************/
+/*>static int ScalarRun(CASTORE **cas, int nstruc, int *offset, int dir,
+                        int k, int n, REAL cutsq)
+   --------------------------------------------------------------------
+   Does the work of CAFirstOverCut() one position at a time, starting
+   from position k. Single precision distances are compared with the
+   cutoff in single precision as the vector kernels do.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Handles single precision stores
+*/
+static int ScalarRun(CASTORE **cas, int nstruc, int *offset, int dir,
+                     int k, int n, REAL cutsq)
+{
+   int   s, s2;
+   REAL  distsq;
+   float scutsq = (float)cutsq;
+   BOOL  single = cas[0]->single;
+
+   for(; k<n; k++)
+   {
+      for(s=0; s<nstruc-1; s++)
+      {
+         for(s2=s+1; s2<nstruc; s2++)
+         {
+            distsq = CADistSq(cas[s],  offset[s]  + k*dir,
+                              cas[s2], offset[s2] + k*dir);
+            if(single ? ((float)distsq > scutsq) : (distsq > cutsq))
+               return(k);
+         }
+      }
+   }
+
+   return(n);
+}
+
+
+/************************************************************************/
+/*>static int CentroidRun(CASTORE **cas, int nstruc, int *offset,
+                          int dir, int n, REAL cutsq, REAL *radius)
+   ----------------------------------------------------------------
+   Input:   CASTORE  **cas      C-alpha stores
+            int      nstruc     Number of structures
+            int      *offset    First C-alpha to test in each store
+            int      dir        1 to step forwards, -1 to step back
+            int      n          Number of positions to test
+            REAL     cutsq      Squared distance cutoff
+            REAL     *radius    Workspace for nstruc distances from
+                                the centroid, or NULL for the centroid
+                                test
+   Returns: int                 As CAFirstOverCut()
+
+   Tests each position against the centroid of the fitted C-alphas.
+   Given radius[], this bounds the pairwise test and checks pairs only
+   where the bounds don't decide it; without it, structures are just
+   required to be within the cutoff of the centroid.
+
+   16.10.26 Original   By: ACRM
+*/
+static int CentroidRun(CASTORE **cas, int nstruc, int *offset, int dir,
+                       int n, REAL cutsq, REAL *radius)
+{
+   VEC3F centroid,
+         p;
+   REAL  cut    = (REAL)sqrt((double)cutsq),
+         reject = cut * ((REAL)1.0 + CAPRUNE_TOL),
+         accept = cut * ((REAL)1.0 - CAPRUNE_TOL),
+         r, rmax, rnext,
+         distsq;
+   float scutsq = (float)cutsq;
+   BOOL  single = cas[0]->single;
+   int   k, s, s2;
+
+   for(k=0; k<n; k++)
+   {
+      centroid.x = centroid.y = centroid.z = (REAL)0.0;
+      for(s=0; s<nstruc; s++)
+      {
+         CAFitted(cas[s], offset[s] + k*dir, &p);
+         centroid.x += p.x;
+         centroid.y += p.y;
+         centroid.z += p.z;
+      }
+      centroid.x /= nstruc;
+      centroid.y /= nstruc;
+      centroid.z /= nstruc;
+
+      /* Find the two largest distances from the centroid. Any one
+         over the cutoff fails the position straight away
+      */
+      rmax = rnext = (REAL)0.0;
+      for(s=0; s<nstruc; s++)
+      {
+         CAFitted(cas[s], offset[s] + k*dir, &p);
+         r = DISTSQ(&p, &centroid);
+
+         if(radius == NULL)
+         {
+            if(r > cutsq)
+               return(k);
+            continue;
+         }
+
+         r = (REAL)sqrt((double)r);
+         if(r > reject)
+            return(k);
+
+         radius[s] = r;
+         if(r > rmax)
+         {
+            rnext = rmax;
+            rmax  = r;
+         }
+         else if(r > rnext)
+         {
+            rnext = r;
+         }
+      }
+
+      /* No pair can be further apart than their two distances from
+         the centroid added together
+      */
+      if((radius == NULL) || (rmax + rnext < accept))
+         continue;
+
+      for(s=0; s<nstruc-1; s++)
+      {
+         if(radius[s] + rmax < accept)
+            continue;
+
+         for(s2=s+1; s2<nstruc; s2++)
+         {
+            if(radius[s] + radius[s2] < accept)
+               continue;
+
+            distsq = CADistSq(cas[s],  offset[s]  + k*dir,
+                              cas[s2], offset[s2] + k*dir);
+            if(single ? ((float)distsq > scutsq) : (distsq > cutsq))
+               return(k);
+         }
+      }
+   }
+
+   return(n);
+}
+
+
+#ifdef CAKERN_X86
+/************************************************************************/
+/*>static void AVXFitted(CASTORE *cas, int first, __m256d *fx,
+                         __m256d *fy, __m256d *fz)
+   -----------------------------------------------------------
+   Input:   CASTORE  *cas       C-alpha store
+            int      first      First of 4 consecutive C-alphas
+   Output:  __m256d  *fx,*fy,*fz  Their fitted coordinates
+
+   16.10.26 Original   By: ACRM
+*/
+static void AVXFitted(CASTORE *cas, int first, __m256d *fx,
+                      __m256d *fy, __m256d *fz)
+{
+   __m256d x, y, z;
+
+   x = _mm256_sub_pd(_mm256_loadu_pd(cas->x + first),
+                     _mm256_set1_pd(cas->centre.x));
+   y = _mm256_sub_pd(_mm256_loadu_pd(cas->y + first),
+                     _mm256_set1_pd(cas->centre.y));
+   z = _mm256_sub_pd(_mm256_loadu_pd(cas->z + first),
+                     _mm256_set1_pd(cas->centre.z));
+
+   *fx = _mm256_add_pd(
+            _mm256_add_pd(
+               _mm256_add_pd(
+                  _mm256_mul_pd(_mm256_set1_pd(cas->rot[0][0]), x),
+                  _mm256_mul_pd(_mm256_set1_pd(cas->rot[0][1]), y)),
+               _mm256_mul_pd(_mm256_set1_pd(cas->rot[0][2]), z)),
+            _mm256_set1_pd(cas->shift.x));
+   *fy = _mm256_add_pd(
+            _mm256_add_pd(
+               _mm256_add_pd(
+                  _mm256_mul_pd(_mm256_set1_pd(cas->rot[1][0]), x),
+                  _mm256_mul_pd(_mm256_set1_pd(cas->rot[1][1]), y)),
+               _mm256_mul_pd(_mm256_set1_pd(cas->rot[1][2]), z)),
+            _mm256_set1_pd(cas->shift.y));
+   *fz = _mm256_add_pd(
+            _mm256_add_pd(
+               _mm256_add_pd(
+                  _mm256_mul_pd(_mm256_set1_pd(cas->rot[2][0]), x),
+                  _mm256_mul_pd(_mm256_set1_pd(cas->rot[2][1]), y)),
+               _mm256_mul_pd(_mm256_set1_pd(cas->rot[2][2]), z)),
+            _mm256_set1_pd(cas->shift.z));
+}
+
+
+/************************************************************************/
+/*>static int AVXFirstOverCut(CASTORE **cas, int nstruc, int *offset,
+                              int dir, int n, REAL cutsq)
+   ------------------------------------------------------------------
+   CAFirstOverCut() 4 positions at a time. Any positions left over at
+   the end of the run are done one at a time.
+
+   16.10.26 Original   By: ACRM
+*/
+static int AVXFirstOverCut(CASTORE **cas, int nstruc, int *offset,
+                           int dir, int n, REAL cutsq)
+{
+   __m256d cut = _mm256_set1_pd(cutsq),
+           ax, ay, az,
+           bx, by, bz,
+           dx, dy, dz;
+   int     k, s, s2,
+           mask,
+           first, first2;
+
+   for(k=0; k+4<=n; k+=4)
+   {
+      mask = 0;
+      for(s=0; s<nstruc-1; s++)
+      {
+         /* Going backwards the block is loaded from its lowest C-alpha
+            so lane 3 is the first position
+         */
+         first = offset[s] + ((dir > 0) ? k : -(k+3));
+         AVXFitted(cas[s], first, &ax, &ay, &az);
+
+         for(s2=s+1; s2<nstruc; s2++)
+         {
+            first2 = offset[s2] + ((dir > 0) ? k : -(k+3));
+            AVXFitted(cas[s2], first2, &bx, &by, &bz);
+
+            dx = _mm256_sub_pd(ax, bx);
+            dy = _mm256_sub_pd(ay, by);
+            dz = _mm256_sub_pd(az, bz);
+            mask |= _mm256_movemask_pd(
+                       _mm256_cmp_pd(
+                          _mm256_add_pd(
+                             _mm256_add_pd(_mm256_mul_pd(dx, dx),
+                                           _mm256_mul_pd(dy, dy)),
+                             _mm256_mul_pd(dz, dz)),
+                          cut, _CMP_GT_OQ));
+         }
+      }
+
+      if(mask)
+      {
+         if(dir > 0)
+            return(k + __builtin_ctz(mask));
+         return(k + 3 - (31 - __builtin_clz(mask)));
+      }
+   }
+
+   /* Finish off one position at a time                              */
+   return(ScalarRun(cas, nstruc, offset, dir, k, n, cutsq));
+}
+
+
+/************************************************************************/
+/*>static void AVX512Fitted(CASTORE *cas, int first, __mmask8 lanes,
+                            __m512d *fx, __m512d *fy, __m512d *fz)
+   -----------------------------------------------------------------
+   Input:   CASTORE  *cas       C-alpha store
+            int      first      First of 8 consecutive C-alphas
+            __mmask8 lanes      Which of the 8 to load
+   Output:  __m512d  *fx,*fy,*fz  Their fitted coordinates
+
+   16.10.26 Original   By: ACRM
+*/
+static void AVX512Fitted(CASTORE *cas, int first, __mmask8 lanes,
+                         __m512d *fx, __m512d *fy, __m512d *fz)
+{
+   __m512d x, y, z;
+
+   x = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, cas->x + first),
+                     _mm512_set1_pd(cas->centre.x));
+   y = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, cas->y + first),
+                     _mm512_set1_pd(cas->centre.y));
+   z = _mm512_sub_pd(_mm512_maskz_loadu_pd(lanes, cas->z + first),
+                     _mm512_set1_pd(cas->centre.z));
+
+   *fx = _mm512_add_pd(
+            _mm512_add_pd(
+               _mm512_add_pd(
+                  _mm512_mul_pd(_mm512_set1_pd(cas->rot[0][0]), x),
+                  _mm512_mul_pd(_mm512_set1_pd(cas->rot[0][1]), y)),
+               _mm512_mul_pd(_mm512_set1_pd(cas->rot[0][2]), z)),
+            _mm512_set1_pd(cas->shift.x));
+   *fy = _mm512_add_pd(
+            _mm512_add_pd(
+               _mm512_add_pd(
+                  _mm512_mul_pd(_mm512_set1_pd(cas->rot[1][0]), x),
+                  _mm512_mul_pd(_mm512_set1_pd(cas->rot[1][1]), y)),
+               _mm512_mul_pd(_mm512_set1_pd(cas->rot[1][2]), z)),
+            _mm512_set1_pd(cas->shift.y));
+   *fz = _mm512_add_pd(
+            _mm512_add_pd(
+               _mm512_add_pd(
+                  _mm512_mul_pd(_mm512_set1_pd(cas->rot[2][0]), x),
+                  _mm512_mul_pd(_mm512_set1_pd(cas->rot[2][1]), y)),
+               _mm512_mul_pd(_mm512_set1_pd(cas->rot[2][2]), z)),
+            _mm512_set1_pd(cas->shift.z));
+}
+
+
+/************************************************************************/
+/*>static int AVX512FirstOverCut(CASTORE **cas, int nstruc, int *offset,
+                                 int dir, int n, REAL cutsq)
+   ---------------------------------------------------------------------
+   CAFirstOverCut() 8 positions at a time. A short final block is done
+   with masked loads so nothing beyond the run is read.
+
+   16.10.26 Original   By: ACRM
+*/
+static int AVX512FirstOverCut(CASTORE **cas, int nstruc, int *offset,
+                              int dir, int n, REAL cutsq)
+{
+   __m512d  cut = _mm512_set1_pd(cutsq),
+            ax, ay, az,
+            bx, by, bz,
+            dx, dy, dz;
+   __mmask8 lanes,
+            mask;
+   int      k, s, s2,
+            nlanes,
+            first, first2;
+
+   for(k=0; k<n; k+=8)
+   {
+      /* Going backwards the block is loaded from its lowest C-alpha so
+         the highest lane in use is the first position
+      */
+      nlanes = ((n-k) < 8) ? (n-k) : 8;
+      lanes  = (__mmask8)((1U << nlanes) - 1U);
+
+      mask = 0;
+      for(s=0; s<nstruc-1; s++)
+      {
+         first = offset[s] + ((dir > 0) ? k : -(k+nlanes-1));
+         AVX512Fitted(cas[s], first, lanes, &ax, &ay, &az);
+
+         for(s2=s+1; s2<nstruc; s2++)
+         {
+            first2 = offset[s2] + ((dir > 0) ? k : -(k+nlanes-1));
+            AVX512Fitted(cas[s2], first2, lanes, &bx, &by, &bz);
+
+            dx = _mm512_sub_pd(ax, bx);
+            dy = _mm512_sub_pd(ay, by);
+            dz = _mm512_sub_pd(az, bz);
+            mask |= _mm512_mask_cmp_pd_mask(
+                       lanes,
+                       _mm512_add_pd(
+                          _mm512_add_pd(_mm512_mul_pd(dx, dx),
+                                        _mm512_mul_pd(dy, dy)),
+                          _mm512_mul_pd(dz, dz)),
+                       cut, _CMP_GT_OQ);
+         }
+      }
+
+      if(mask)
+      {
+         if(dir > 0)
+            return(k + __builtin_ctz(mask));
+         return(k + nlanes-1 - (31 - __builtin_clz(mask)));
+      }
+   }
+
+   return(n);
+}
+
+
+/************************************************************************/
+/*>static void AVXFittedSingle(CASTORE *cas, int first, __m256 *fx,
+                               __m256 *fy, __m256 *fz)
+   ----------------------------------------------------------------
+   Input:   CASTORE  *cas       Single precision C-alpha store
+            int      first      First of 8 consecutive C-alphas
+   Output:  __m256   *fx,*fy,*fz  Their fitted coordinates
+
+   16.10.26 Original   By: ACRM
+*/
+static void AVXFittedSingle(CASTORE *cas, int first, __m256 *fx,
+                            __m256 *fy, __m256 *fz)
+{
+   __m256 x, y, z;
+
+   x = _mm256_sub_ps(_mm256_loadu_ps(cas->sx + first),
+                     _mm256_set1_ps(cas->scentre[0]));
+   y = _mm256_sub_ps(_mm256_loadu_ps(cas->sy + first),
+                     _mm256_set1_ps(cas->scentre[1]));
+   z = _mm256_sub_ps(_mm256_loadu_ps(cas->sz + first),
+                     _mm256_set1_ps(cas->scentre[2]));
+
+   *fx = _mm256_add_ps(
+            _mm256_add_ps(
+               _mm256_add_ps(
+                  _mm256_mul_ps(_mm256_set1_ps(cas->srot[0][0]), x),
+                  _mm256_mul_ps(_mm256_set1_ps(cas->srot[0][1]), y)),
+               _mm256_mul_ps(_mm256_set1_ps(cas->srot[0][2]), z)),
+            _mm256_set1_ps(cas->sshift[0]));
+   *fy = _mm256_add_ps(
+            _mm256_add_ps(
+               _mm256_add_ps(
+                  _mm256_mul_ps(_mm256_set1_ps(cas->srot[1][0]), x),
+                  _mm256_mul_ps(_mm256_set1_ps(cas->srot[1][1]), y)),
+               _mm256_mul_ps(_mm256_set1_ps(cas->srot[1][2]), z)),
+            _mm256_set1_ps(cas->sshift[1]));
+   *fz = _mm256_add_ps(
+            _mm256_add_ps(
+               _mm256_add_ps(
+                  _mm256_mul_ps(_mm256_set1_ps(cas->srot[2][0]), x),
+                  _mm256_mul_ps(_mm256_set1_ps(cas->srot[2][1]), y)),
+               _mm256_mul_ps(_mm256_set1_ps(cas->srot[2][2]), z)),
+            _mm256_set1_ps(cas->sshift[2]));
+}
+
+
+/************************************************************************/
+/*>static int AVXFirstOverCutSingle(CASTORE **cas, int nstruc,
+                                    int *offset, int dir, int n,
+                                    REAL cutsq)
+   ------------------------------------------------------------
+   AVXFirstOverCut() for single precision stores, 8 positions at a
+   time
+
+   16.10.26 Original   By: ACRM
+*/
+static int AVXFirstOverCutSingle(CASTORE **cas, int nstruc,
+                                 int *offset, int dir, int n,
+                                 REAL cutsq)
+{
+   __m256 cut = _mm256_set1_ps((float)cutsq),
+          ax, ay, az,
+          bx, by, bz,
+          dx, dy, dz;
+   int    k, s, s2,
+          mask,
+          first, first2;
+
+   for(k=0; k+8<=n; k+=8)
+   {
+      mask = 0;
+      for(s=0; s<nstruc-1; s++)
+      {
+         first = offset[s] + ((dir > 0) ? k : -(k+7));
+         AVXFittedSingle(cas[s], first, &ax, &ay, &az);
+
+         for(s2=s+1; s2<nstruc; s2++)
+         {
+            first2 = offset[s2] + ((dir > 0) ? k : -(k+7));
+            AVXFittedSingle(cas[s2], first2, &bx, &by, &bz);
+
+            dx = _mm256_sub_ps(ax, bx);
+            dy = _mm256_sub_ps(ay, by);
+            dz = _mm256_sub_ps(az, bz);
+            mask |= _mm256_movemask_ps(
+                       _mm256_cmp_ps(
+                          _mm256_add_ps(
+                             _mm256_add_ps(_mm256_mul_ps(dx, dx),
+                                           _mm256_mul_ps(dy, dy)),
+                             _mm256_mul_ps(dz, dz)),
+                          cut, _CMP_GT_OQ));
+         }
+      }
+
+      if(mask)
+      {
+         if(dir > 0)
+            return(k + __builtin_ctz(mask));
+         return(k + 7 - (31 - __builtin_clz(mask)));
+      }
+   }
+
+   return(ScalarRun(cas, nstruc, offset, dir, k, n, cutsq));
+}
+
+
+/************************************************************************/
+/*>static void AVX512FittedSingle(CASTORE *cas, int first,
+                                  __mmask16 lanes, __m512 *fx,
+                                  __m512 *fy, __m512 *fz)
+   --------------------------------------------------------
+   Input:   CASTORE   *cas      Single precision C-alpha store
+            int       first     First of 16 consecutive C-alphas
+            __mmask16 lanes     Which of the 16 to load
+   Output:  __m512    *fx,*fy,*fz  Their fitted coordinates
+
+   16.10.26 Original   By: ACRM
+*/
+static void AVX512FittedSingle(CASTORE *cas, int first,
+                               __mmask16 lanes, __m512 *fx,
+                               __m512 *fy, __m512 *fz)
+{
+   __m512 x, y, z;
+
+   x = _mm512_sub_ps(_mm512_maskz_loadu_ps(lanes, cas->sx + first),
+                     _mm512_set1_ps(cas->scentre[0]));
+   y = _mm512_sub_ps(_mm512_maskz_loadu_ps(lanes, cas->sy + first),
+                     _mm512_set1_ps(cas->scentre[1]));
+   z = _mm512_sub_ps(_mm512_maskz_loadu_ps(lanes, cas->sz + first),
+                     _mm512_set1_ps(cas->scentre[2]));
+
+   *fx = _mm512_add_ps(
+            _mm512_add_ps(
+               _mm512_add_ps(
+                  _mm512_mul_ps(_mm512_set1_ps(cas->srot[0][0]), x),
+                  _mm512_mul_ps(_mm512_set1_ps(cas->srot[0][1]), y)),
+               _mm512_mul_ps(_mm512_set1_ps(cas->srot[0][2]), z)),
+            _mm512_set1_ps(cas->sshift[0]));
+   *fy = _mm512_add_ps(
+            _mm512_add_ps(
+               _mm512_add_ps(
+                  _mm512_mul_ps(_mm512_set1_ps(cas->srot[1][0]), x),
+                  _mm512_mul_ps(_mm512_set1_ps(cas->srot[1][1]), y)),
+               _mm512_mul_ps(_mm512_set1_ps(cas->srot[1][2]), z)),
+            _mm512_set1_ps(cas->sshift[1]));
+   *fz = _mm512_add_ps(
+            _mm512_add_ps(
+               _mm512_add_ps(
+                  _mm512_mul_ps(_mm512_set1_ps(cas->srot[2][0]), x),
+                  _mm512_mul_ps(_mm512_set1_ps(cas->srot[2][1]), y)),
+               _mm512_mul_ps(_mm512_set1_ps(cas->srot[2][2]), z)),
+            _mm512_set1_ps(cas->sshift[2]));
+}
+
+
+/************************************************************************/
+/*>static int AVX512FirstOverCutSingle(CASTORE **cas, int nstruc,
+                                       int *offset, int dir, int n,
+                                       REAL cutsq)
+   ---------------------------------------------------------------
+   AVX512FirstOverCut() for single precision stores, 16 positions at
+   a time
+
+   16.10.26 Original   By: ACRM
+*/
+static int AVX512FirstOverCutSingle(CASTORE **cas, int nstruc,
+                                    int *offset, int dir, int n,
+                                    REAL cutsq)
+{
+   __m512    cut = _mm512_set1_ps((float)cutsq),
+             ax, ay, az,
+             bx, by, bz,
+             dx, dy, dz;
+   __mmask16 lanes,
+             mask;
+   int       k, s, s2,
+             nlanes,
+             first, first2;
+
+   for(k=0; k<n; k+=16)
+   {
+      nlanes = ((n-k) < 16) ? (n-k) : 16;
+      lanes  = (__mmask16)((1U << nlanes) - 1U);
+
+      mask = 0;
+      for(s=0; s<nstruc-1; s++)
+      {
+         first = offset[s] + ((dir > 0) ? k : -(k+nlanes-1));
+         AVX512FittedSingle(cas[s], first, lanes, &ax, &ay, &az);
+
+         for(s2=s+1; s2<nstruc; s2++)
+         {
+            first2 = offset[s2] + ((dir > 0) ? k : -(k+nlanes-1));
+            AVX512FittedSingle(cas[s2], first2, lanes, &bx, &by, &bz);
+
+            dx = _mm512_sub_ps(ax, bx);
+            dy = _mm512_sub_ps(ay, by);
+            dz = _mm512_sub_ps(az, bz);
+            mask |= _mm512_mask_cmp_ps_mask(
+                       lanes,
+                       _mm512_add_ps(
+                          _mm512_add_ps(_mm512_mul_ps(dx, dx),
+                                        _mm512_mul_ps(dy, dy)),
+                          _mm512_mul_ps(dz, dz)),
+                       cut, _CMP_GT_OQ);
+         }
+      }
+
+      if(mask)
+      {
+         if(dir > 0)
+            return(k + __builtin_ctz(mask));
+         return(k + nlanes-1 - (31 - __builtin_clz(mask)));
+      }
+   }
+
+   return(n);
+}
+#endif
@@ -0,0 +1,61 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       distkern.h
+
+   Version:    V1.4
+   Date:       16.10.26
+   Function:   Batched C-alpha distance checks for zone extension and
+               cutting
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 Single precision kernels
+   V1.2  16.10.26 Centroid deviation test
+   V1.3  16.10.26 The test is passed to CAFirstOverCut()
+   V1.4  16.10.26 So is the workspace for the centroid bounds
+
+*************************************************************************/
+#ifndef _DISTKERN_H
+#define _DISTKERN_H
+
+/************************************************************************/
+/* Includes
+*/
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+#include "castore.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+/* How a position is tested against the cutoff                          */
+#define CATEST_PAIRS    0    /* Every pair of structures within cutoff  */
+#define CATEST_CENTROID 1    /* Every structure within cutoff of the
+                                centroid                                */
+
+/************************************************************************/
+/* Prototypes
+*/
+int CAFirstOverCut(CASTORE **cas, int nstruc, int *offset, int dir,
+                   int n, REAL cutsq, int test, REAL *radius);
+char *CAKernelName(void);
+
+#endif
@@ -3,12 +3,12 @@
    Program:    findcore_Apr16
    File:       findcore_Apr16.c
    
-   Version:    V1.8
-   Date:       05.11.25
+   Version:    V1.30
+   Date:       16.10.26
    Function:   Find core from multiple structures given the CORA alignment
                file as a staring point
    
-   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2025
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
    Author:     Prof. Andrew C. R. Martin
    Modified:   Gabby Marsden (nee Reeves)
    Address:    Biomolecular Structure & Modelling Unit,
@@ -48,6 +48,70 @@
                   wasn't already in a zone.
    V1.4...V1.7  16.04.02
    V1.8  05.11.25 Updated for new biolib
+   V1.9  16.10.26 Fitting now keeps running sums over the core pairs and
+                  updates them as pairs are added or removed rather than
+                  rebuilding the fitted set on every iteration
+   V1.10 16.10.26 The core loop works on compact arrays of C-alpha
+                  coordinates and core flags rather than walking copies
+                  of the PDB linked lists
+   V1.11 16.10.26 Zone boundaries are found through a residue number
+                  lookup table rather than by scanning the structure
+   V1.12 16.10.26 Zones are held in a contiguous array shared with findcore
+                  (zonelist.c). MergeZones() no longer restarts after
+                  every deletion and no longer crashes when the first
+                  zone is merged or when every zone has been cut
+   V1.13 16.10.26 Core membership is held as a bitset in the C-alpha
+                  store. Zone runs are checked and the core counted a
+                  word at a time
+   V1.14 16.10.26 Each fit just records a transform for the mobile
+                  C-alphas rather than moving all of them
+   V1.15 16.10.26 Distance checks when extending and cutting zones are
+                  done a block of positions at a time (distkern.c),
+                  using AVX-512 or AVX where the CPU has them
+   V1.16 16.10.26 Added -f to choose between blMatfit() and QCP for the
+                  fitting. Verbose mode reports the final core RMSDs
+   V1.17 16.10.26 Added -r to hold the C-alpha coordinates and do the
+                  distance checks in single precision (the fitting sums
+                  are still double) and -c to also find the core in
+                  double precision and report any zones which differ
+   V1.18 16.10.26 The cut, zone extension and fitting are shared with
+                  findcore (coreeng.c). A zone being split is now only
+                  taken back to a position in the core in every
+                  structure, so the split-off zone always has a start
+   V1.19 16.10.26 Added -t to fit the structures on several threads
+   V1.20 16.10.26 Removed the limits of 50 structures and 9 character
+                  structure names; storage for each structure is
+                  allocated once the number of structures is known
+   V1.21 16.10.26 Added -m to test deviations from the centroid rather
+                  than between every pair of structures. The pairwise
+                  test now uses the centroid to skip most pairs when
+                  there are many structures
+   V1.22 16.10.26 Added -g to fit the structures to their mean rather
+                  than to the first structure
+   V1.23 16.10.26 The CORA file is read in one go and scanned by hand
+                  into storage allocated up front from the declared
+                  size. Residue labels of any length are accepted
+   V1.24 16.10.26 The secondary structure of each alignment position is
+                  recorded in bitmasks as the file is read and zones
+                  are found by scanning these. -n now works, adding
+                  zones where every protein is aligned and none is in
+                  a strand or helix
+   V1.25 16.10.26 -p writes each structure with the core flagged in the
+                  B-value column. The files are written on the thread
+                  pool
+   V1.26 16.10.26 The PDB files are read on the thread pool with
+                  read-ahead hints
+   V1.27 16.10.26 Added -k to keep the C-alphas of the PDB files in a
+                  binary cache
+   V1.28 16.10.26 The CORA file reading moved to corafile.c. The PDB
+                  reading and core definition are done by libfindcore.
+                  Settings used by the library are held in its options
+                  rather than in globals
+   V1.29 16.10.26 Added -b to run a list of CORA files in one process,
+                  taking the structures from an in-memory cache with a
+                  memory budget (strcache.c) set by -l
+   V1.30 16.10.26 The usage message describes findcora's own options
+                  and CORA input rather than findcore's
 
 *************************************************************************/
 /* Includes
@@ -61,208 +125,546 @@
 #include "bioplib/general.h"
 #include "bioplib/macros.h"
 #include "bioplib/fit.h"
-#include "bioplib/fsscanf.h"
+#include "corefit.h"
+#include "castore.h"
+#include "zonelist.h"
+#include "distkern.h"
+#include "coreeng.h"
+#include "pdbload.h"
+#include "corafile.h"
+#include "libfindcore.h"
+#include "strcache.h"
 
 /************************************************************************/
 /* Defines and macros
 */
-#define MAXITER 1000
 #define MAXBUFF 160
-#define MAXCHAR 10
+#define COREEXT   ".core"    /* Added to the names of -p output files   */
+#define PDBBUFFER 1048576    /* Output buffer for each -p output file   */
+#define BATCH_LINE 1024      /* Longest -b manifest line                */
+
 #define DEFAULT_CUT ((REAL)3.0)
-#define MAXMALNPNO 50
 #define COMMENT
 
-#define TEST(obj)  if( obj == NULL ) printf("no memory for obj !\n")
-#define ALLOC(x,y) do { (x) = (y *)malloc(sizeof(y)); TEST(x); } while(0)
-
-typedef struct _zone
-{
-   struct _zone *next,
-                *prev;
-   int start[MAXMALNPNO], 
-       end[MAXMALNPNO];
-}  ZONE;
-
-/*  CORA - Line data for multiple alignment files                       */
-typedef struct
-{  /* data for each protein in the alignment                            */
-   char acid,
-        secstruct,
-        pdb[6];  
-}  Protdata;
-
+/* What the -p output tasks need                                        */
 typedef struct
 {
-   int      alnpos,
-            conpos,
-            proaln,
-            colx,
-            coly,
-            score;
-   char     consecstruc;
-   /* Pointer defined to point to the first address in Protdata         */
-   Protdata *protdata_ptr;   
-}  Malndata;
-
-/*  general data for multiple alignment files                           */
+   PDB      **pdb;
+   ZONELIST *zones;
+   char     **names;
+   BOOL     *written;        /* Output file written for each structure  */
+}  COREOUTPUT;
+
+/* What the tasks getting structures from the cache need                */
 typedef struct
 {
-   int       procnt,
-             length; 		                    
-   char      title[50],
-             proname[MAXMALNPNO][MAXCHAR];
-   /* Pointer defined to point to the first address in Malndata         */
-   Malndata  *malndata_ptr;      
-}  Malign;
+   STRCACHE *cache;
+   char     **names;
+   PDB      **pdb;
+   STRENTRY **entry;
+   int      *natoms;
+}  CACHELOAD;
 
 /************************************************************************/
 /* Globals
 */
 BOOL gVerbose      = FALSE,
-     gInitialCut   = FALSE,
-     gDoRandomCoil = FALSE,
-     gDoOutput     = FALSE;
+     gDoOutput     = FALSE,
+     gCheckSingle  = FALSE;
+int  gThreads      = 1,
+     gCacheMB      = STRCACHE_DEFAULTMB;
+FCOPTIONS gOptions;          /* Settings for libfindcore                */
 
 /************************************************************************/
 /* Prototypes
 */
 int main(int argc, char **argv);
-BOOL ParseCmdLine(int argc, char **argv, char *corafile, REAL *dcut);
-Malign *ReadCORA(FILE *fp);
-ZONE *calcZone(Malign *maln_ptr);
-BOOL DefineCore(PDB **pdb, ZONE *zones, Malign *maln_ptr, REAL dcut);
-void UpdateBValues(PDB **idx[MAXMALNPNO], int *natoms, int nstruc,
-                   ZONE *zones, REAL cutsq);
-void SetBValByZone(PDB *pdb, ZONE *zones, int protNum);
-BOOL FitCaPDBBFlag(PDB *ref_pdb, PDB *fit_pdb, REAL rm[3][3]);
-int CountCore(PDB *pdb);
-PDB *DupeCAByBVal(PDB *pdb);
-Malign *new_Malign(void);
-void clear_Malign(Malign *m);
-void WriteTextOutput(ZONE *zones, int *numProts);
+BOOL ParseCmdLine(int argc, char **argv, char *corafile, REAL *dcut,
+                  char *manifest);
+int RunCoraBatch(char *manifest, REAL dcut);
+int RunCoraJob(char *corafile, REAL dcut, STRCACHE *cache);
+BOOL ReadStructures(Malign *maln_ptr, PDB **pdb, STRCACHE *cache,
+                    STRENTRY **entry);
+void CacheTask(void *arg, int s);
+void FreeStructures(PDB **pdb, int numProts, STRCACHE *cache,
+                    STRENTRY **entry);
+int FindCoraCore(PDB **pdb, ZONELIST *zones, Malign *maln_ptr,
+                 REAL dcut);
+BOOL DefineCore(PDB **pdb, ZONELIST *zones, Malign *maln_ptr, REAL dcut,
+                BOOL single, BOOL verbose);
+void ReportCut(void *arg, ZONELIST *zones);
+void WriteTextOutput(ZONELIST *zones, int *numProts);
 void Usage(void);
-BOOL DoCut(PDB **idx[MAXMALNPNO], int *natoms, int nstruc,
-           ZONE *zones, REAL cutsq);
-ZONE *MergeZones(ZONE *zones, int numProts);
-BOOL SubsetZone(ZONE *z, ZONE *zones);
+BOOL WriteCorePDBs(PDB **pdb, ZONELIST *zones, Malign *maln_ptr);
+void WriteCoreTask(void *arg, int s);
+ZONELIST *DoubleCore(PDB **pdb, ZONELIST *zones, Malign *maln_ptr,
+                     REAL dcut);
 
 /************************************************************************/
+/*>int main(int argc, char **argv)
+   -------------------------------
+   Main program for core defining
+
+   14.11.96 Original   By: ACRM
+   16.10.26 The work is done by RunCoraJob(). Added batch mode
+*/
 int main(int argc, char **argv)
 {
-   char   corafile[MAXBUFF];
-   FILE   *corafp;
-   FILE   *pdbfp;
-   Malign *maln_ptr;
-   int    numPdb;
-   int    natoms[MAXMALNPNO];
-   int    numProts;
-   ZONE   *zones;
-   PDB    *pdb[MAXMALNPNO];
-   REAL   dcut = DEFAULT_CUT;
+   char   corafile[MAXBUFF],
+          manifest[MAXBUFF];
+   REAL   dcut   = DEFAULT_CUT;
+   int    status = 0;
    
-   if(ParseCmdLine(argc, argv, corafile, &dcut))
+   fcDefaultOptions(&gOptions);
+   if(ParseCmdLine(argc, argv, corafile, &dcut, manifest))
    {
-      /* Open files                                                     */
-      if((corafp=fopen(corafile,"r"))==NULL)
+      /* Start the threads for reading and fitting                      */
+      if((gThreads > 1) &&
+         ((gOptions.pool = NewThreadPool(gThreads)) == NULL))
       {
-         fprintf(stderr,"Unable to open %s for reading\n",corafile);
+         fprintf(stderr,"Unable to start %d threads\n", gThreads);
          return(1);
       }
-      
-      if((maln_ptr = ReadCORA(corafp)) == NULL)
+
+      if(manifest[0])
+         status = RunCoraBatch(manifest, dcut);
+      else
+         status = RunCoraJob(corafile, dcut, NULL);
+   }
+   else
+   {
+      Usage();
+   }
+   
+   FreeThreadPool(gOptions.pool);
+   return(status);
+}
+
+
+/************************************************************************/
+/*>int RunCoraBatch(char *manifest, REAL dcut)
+   -------------------------------------------
+   Input:   char   *manifest    List of jobs (- for stdin)
+            REAL   dcut         Cutoff for jobs which don't give one
+   Returns: int                 Exit status (0 if every job worked)
+
+   Runs each job in a manifest in turn. Each line is
+      corafile [dcut]
+   where - for dcut gives the default. Blank lines and lines starting
+   with # are skipped. The output of each job is headed by its number
+   and CORA file.
+
+   The structures are taken from a cache of gCacheMB Mbytes, so a
+   structure in many of the alignments is usually only read once.
+
+   16.10.26 Original   By: ACRM
+*/
+int RunCoraBatch(char *manifest, REAL dcut)
+{
+   FILE     *fp;
+   STRCACHE *cache;
+   char     buffer[BATCH_LINE],
+            corafile[BATCH_LINE],
+            cutfield[BATCH_LINE],
+            extra[BATCH_LINE];
+   REAL     jobcut;
+   int      nline  = 0,
+            njobs  = 0,
+            status = 0,
+            nfield;
+   BOOL     ok,
+            whole;
+
+   if(!strcmp(manifest, "-"))
+   {
+      fp = stdin;
+   }
+   else if((fp=fopen(manifest,"r"))==NULL)
+   {
+      fprintf(stderr,"Unable to open %s for reading\n",manifest);
+      return(1);
+   }
+
+   if((cache = NewStructCache((unsigned long)gCacheMB * 1048576UL,
+                              gOptions.cachedir))==NULL)
+   {
+      fprintf(stderr,"No memory for structure cache\n");
+      if(fp != stdin)
+         fclose(fp);
+      return(1);
+   }
+
+   while(fgets(buffer, BATCH_LINE, fp))
+   {
+      nline++;
+      whole  = (strchr(buffer, '\n') != NULL) || feof(fp);
+      nfield = sscanf(buffer, "%s %s %s", corafile, cutfield, extra);
+
+      /* Skip blank lines and comments                                 */
+      if(whole && ((nfield < 1) || (corafile[0] == '#')))
+         continue;
+
+      ok     = whole && (nfield <= 2) && (strlen(corafile) < MAXBUFF);
+      jobcut = dcut;
+      if(ok && (nfield == 2) && strcmp(cutfield, "-"))
+         ok = (sscanf(cutfield, "%lf", &jobcut) == 1);
+
+      if(!ok)
       {
-         fprintf(stderr,"No Zones read from %s\n",corafile);
-         return(1);
+         fprintf(stderr,"Bad job on line %d of %s\n", nline, manifest);
+         status = 1;
+
+         /* Skip the rest of an over-long line                          */
+         while(!whole && fgets(buffer, BATCH_LINE, fp))
+            whole = (strchr(buffer, '\n') != NULL);
+         continue;
       }
-      fclose(corafp);
+
+      printf("Job %d: %s\n", ++njobs, corafile);
+      fflush(stdout);
+      if(RunCoraJob(corafile, jobcut, cache))
+         status = 1;
+      fflush(stdout);
+   }
+
+   if(gVerbose)
+      ReportStructCache(stderr, cache);
+   FreeStructCache(cache);
+   if(fp != stdin)
+      fclose(fp);
+
+   return(status);
+}
+
+
+/************************************************************************/
+/*>int RunCoraJob(char *corafile, REAL dcut, STRCACHE *cache)
+   ----------------------------------------------------------
+   Input:   char     *corafile  CORA alignment file
+            REAL     dcut       Cutoff for defining core
+            STRCACHE *cache     Where to get the structures (or NULL to
+                                read them)
+   Returns: int                 Exit status (0 for success)
+
+   Reads the alignment and its structures, finds the core and writes
+   it out. Everything the job reads is freed again.
+
+   14.11.96 Original (as main())   By: ACRM
+   16.10.26 Split out of main() and added the cache
+*/
+int RunCoraJob(char *corafile, REAL dcut, STRCACHE *cache)
+{
+   FILE     *corafp;
+   Malign   *maln_ptr;
+   ZONELIST *zones;
+   PDB      **pdb;
+   STRENTRY **entry = NULL;
+   int      numProts,
+            status;
+
+   /* Open files                                                        */
+   if((corafp=fopen(corafile,"r"))==NULL)
+   {
+      fprintf(stderr,"Unable to open %s for reading\n",corafile);
+      return(1);
+   }
       
-      /* calculate inital zones                                         */
-      zones = calcZone(maln_ptr);
-      numProts = maln_ptr->procnt;
+   /* Read the alignment and calculate the initial zones               */
+   status = fcReadCORA(&gOptions, corafp, &maln_ptr, &zones);
+   fclose(corafp);
+   switch(status)
+   {
+   case FC_OK:
+      break;
+   case FC_NOZONES:
+      fprintf(stderr,"No Zones read from %s\n",corafile);
+      return(1);
+   default:
+      fprintf(stderr,"No memory for zones\n");
+      return(1);
+   }
+   numProts = maln_ptr->procnt;
       
-      /* open and read the pdbfiles by taking the names from the cora
-         file
-      */
-      for(numPdb = 0; numPdb<maln_ptr->procnt; numPdb++)
+   if(((pdb = (PDB **)calloc(numProts, sizeof(PDB *)))==NULL) ||
+      ((cache != NULL) &&
+       ((entry = (STRENTRY **)calloc(numProts, sizeof(STRENTRY *)))
+        ==NULL)))
+   {
+      fprintf(stderr,"No memory for %d structures\n", numProts);
+      FREE(pdb);
+      FreeZoneList(zones);
+      FreeMalign(maln_ptr);
+      return(1);
+   }
+
+   /* open and read the pdbfiles by taking the names from the cora
+      file
+   */
+   if(ReadStructures(maln_ptr, pdb, cache, entry))
+      status = FindCoraCore(pdb, zones, maln_ptr, dcut);
+   else
+      status = 1;
+
+   FreeStructures(pdb, numProts, cache, entry);
+   free(pdb);
+   FREE(entry);
+   FreeZoneList(zones);
+   FreeMalign(maln_ptr);
+
+   return(status);
+}
+
+
+/************************************************************************/
+/*>BOOL ReadStructures(Malign *maln_ptr, PDB **pdb, STRCACHE *cache,
+                       STRENTRY **entry)
+   -----------------------------------------------------------------
+   Input:   Malign   *maln_ptr  Alignment (for the file names)
+            STRCACHE *cache     Where to get the structures (or NULL to
+                                read them)
+   Output:  PDB      **pdb      The structures
+            STRENTRY **entry    Cache entry for each (if cache is set)
+   Returns: BOOL                Every structure was read
+
+   The structures are read on the thread pool. Only the C-alphas are
+   needed unless the structures are being written out, in which case
+   the job gets its own copies of those from the cache. Whatever has
+   been read must be freed with FreeStructures() even on failure.
+
+   16.10.26 Original (from main())   By: ACRM
+*/
+BOOL ReadStructures(Malign *maln_ptr, PDB **pdb, STRCACHE *cache,
+                    STRENTRY **entry)
+{
+   CACHELOAD load;
+   int       numProts = maln_ptr->procnt,
+             bad, s, t;
+
+   if(cache == NULL)
+   {
+      switch(fcLoadStructures(&gOptions, maln_ptr->proname, numProts,
+                              !gDoOutput, pdb, &bad))
       {
-         if((pdbfp=fopen(maln_ptr->proname[numPdb],"r"))==NULL)
-         {
+      case FC_OK:
+         return(TRUE);
+      case FC_NOFILE:
+         fprintf(stderr,"Unable to open %s for reading\n",
+                 maln_ptr->proname[bad]);
+         break;
+      case FC_NOATOMS:
+         fprintf(stderr,"No atoms read from PDB file: %s\n",
+                 maln_ptr->proname[bad]);
+         break;
+      default:
+         fprintf(stderr,"No memory for %d structures\n", numProts);
+         break;
+      }
+      return(FALSE);
+   }
+
+   if((load.natoms = (int *)malloc(numProts * sizeof(int)))==NULL)
+   {
+      fprintf(stderr,"No memory for %d structures\n", numProts);
+      return(FALSE);
+   }
+   load.cache = cache;
+   load.names = maln_ptr->proname;
+   load.pdb   = pdb;
+   load.entry = entry;
+   RunPool(gOptions.pool, CacheTask, (void *)&load, numProts);
+
+   for(s=0; s<numProts; s++)
+   {
+      if(entry[s] == NULL)
+      {
+         if(load.natoms[s] == PDBLOAD_NOFILE)
             fprintf(stderr,"Unable to open %s for reading\n",
-                    maln_ptr->proname[numPdb]);
-            return(1);
-         }
-         
-         /* Read them and get the data                                  */
-         if((pdb[numPdb] = blReadPDB(pdbfp, &natoms[numPdb])) == NULL)
-         {
+                    maln_ptr->proname[s]);
+         else if(pdb[s] == NULL)
             fprintf(stderr,"No atoms read from PDB file: %s\n",
-                    maln_ptr->proname[numPdb]);
-            return(1);
-         }
-         
-         fclose(pdbfp);
+                    maln_ptr->proname[s]);
+         else
+            fprintf(stderr,"No memory for %d structures\n", numProts);
+         break;
       }
+   }
+   free(load.natoms);
+   if(s < numProts)
+   {
+      /* Only copies are freed by FreeStructures()                      */
+      for(s=0; s<numProts; s++)
+         pdb[s] = NULL;
+      return(FALSE);
+   }
 
-      /* Print the current zones if required                            */
-      if(gVerbose)
+   /* The cached structures mustn't be changed by writing them out     */
+   if(gDoOutput)
+   {
+      for(s=0; s<numProts; s++)
       {
-         printf("SSAP Zones:\n");
-         WriteTextOutput(zones, &numProts);
+         if((pdb[s] = blDupePDB(pdb[s]))==NULL)
+         {
+            fprintf(stderr,"No memory for %d structures\n", numProts);
+            for(t=s+1; t<numProts; t++)
+               pdb[t] = NULL;
+            return(FALSE);
+         }
       }
+   }
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void CacheTask(void *arg, int s)
+   --------------------------------
+   Input:   void     *arg       CACHELOAD
+            int      s          Structure to get
+
+   Pool task for ReadStructures()
+
+   16.10.26 Original   By: ACRM
+*/
+void CacheTask(void *arg, int s)
+{
+   CACHELOAD *load = (CACHELOAD *)arg;
+
+   load->entry[s] = GetCachedStructure(load->cache, load->names[s],
+                                       gDoOutput, &(load->pdb[s]),
+                                       &(load->natoms[s]));
+}
+
+
+/************************************************************************/
+/*>void FreeStructures(PDB **pdb, int numProts, STRCACHE *cache,
+                       STRENTRY **entry)
+   -------------------------------------------------------------
+   I/O:     PDB      **pdb      Structures from ReadStructures()
+   Input:   int      numProts   Number of structures
+            STRCACHE *cache     Where they came from (or NULL)
+            STRENTRY **entry    Their cache entries
+
+   Frees the structures the job owns and gives back those from the
+   cache
+
+   16.10.26 Original   By: ACRM
+*/
+void FreeStructures(PDB **pdb, int numProts, STRCACHE *cache,
+                    STRENTRY **entry)
+{
+   int s;
+
+   for(s=0; s<numProts; s++)
+   {
+      if((cache == NULL) || gDoOutput)
+         FREELIST(pdb[s], PDB);
+      if((cache != NULL) && (entry[s] != NULL))
+         ReleaseCachedStructure(cache, entry[s]);
+   }
+}
+
+
+/************************************************************************/
+/*>int FindCoraCore(PDB **pdb, ZONELIST *zones, Malign *maln_ptr,
+                    REAL dcut)
+   --------------------------------------------------------------
+   Input:   Malign   *maln_ptr  The alignment
+            REAL     dcut       Cutoff for defining core
+   I/O:     PDB      **pdb      The structures
+            ZONELIST *zones     Starting zones; the core on return
+   Returns: int                 Exit status (0 for success)
+
+   Finds the core and writes the zones and any PDB files
+
+   14.11.96 Original (as main())   By: ACRM
+   16.10.26 Split out of main()
+   16.10.26 Fails if the core couldn't be found
+*/
+int FindCoraCore(PDB **pdb, ZONELIST *zones, Malign *maln_ptr,
+                 REAL dcut)
+{
+   ZONELIST *dzones = NULL;
+   int      numProts = maln_ptr->procnt;
+
+   /* Print the current zones if required                               */
+   if(gVerbose)
+   {
+      printf("SSAP Zones:\n");
+      WriteTextOutput(zones, &numProts);
+   }
       
-      /* Now call the routine to do the core definition                 */
-      DefineCore(pdb, zones, maln_ptr, dcut);
-      
-      if(gVerbose)
-      {
-         printf("\nCore before zone merging:\n");
-         WriteTextOutput(zones, &numProts);
-      }
+   /* If single precision is being checked, first find the core
+      from the same starting zones in double precision
+   */
+   if(gCheckSingle)
+   {
+      if((dzones = DoubleCore(pdb, zones, maln_ptr, dcut))==NULL)
+         return(1);
+   }
+
+   /* Now call the routine to do the core definition                    */
+   if(!DefineCore(pdb, zones, maln_ptr, dcut, gOptions.single, gVerbose))
+   {
+      if(dzones != NULL)
+         FreeZoneList(dzones);
+      return(1);
+   }
       
-      /* Now remove any zones which are subsets of other zones and merge
-         overlapping zones
-      */
-      zones = MergeZones(zones, numProts);
+   if(gVerbose)
+   {
+      printf("\nCore before zone merging:\n");
+      WriteTextOutput(zones, &numProts);
+   }
       
-      /* Finally write the output file which lists residues in the 
-         structural core and optionally write PDB files with the cores
-         flagged
-      */
-      if(gVerbose)
-      {
-         printf("\nFinal Zones:\n");
-         WriteTextOutput(zones, &numProts);
-      }
+   /* Now remove any zones which are subsets of other zones and merge
+      overlapping zones
+   */
+   if(!MergeZones(zones))
+   {
+      fprintf(stderr,"No memory for merging zones\n");
+      if(dzones != NULL)
+         FreeZoneList(dzones);
+      return(1);
+   }
       
-      if(gDoOutput)
-      {
-         /*WRITE OUTPUT FILES FOR EACH PDB IN THE CORA ALIGNMENT*/
-      }
+   /* Finally write the output file which lists residues in the 
+      structural core and optionally write PDB files with the cores
+      flagged
+   */
+   if(gVerbose)
+   {
+      printf("\nFinal Zones:\n");
+      WriteTextOutput(zones, &numProts);
    }
-   else
+
+   if(dzones != NULL)
    {
-      Usage();
+      if(!ReportZoneDiffs(stderr, zones, "Single", dzones, "Double"))
+         fprintf(stderr,"Single precision zones match double \
+precision\n");
+      FreeZoneList(dzones);
    }
-   
+      
+   if(gDoOutput)
+   {
+      if(!WriteCorePDBs(pdb, zones, maln_ptr))
+         return(1);
+   }
+
    return(0);
 }
 
 
 /************************************************************************/
-/*>BOOL ParseCmdLine(int argc, char **argv, char *ssapfile, 
-                     char *pdbfile1, char *pdbfile2, char *outfile, 
-                     char *outpdb1, char *outpdb2, REAL *dcut)
-   ----------------------------------------------------------------
+/*>BOOL ParseCmdLine(int argc, char **argv, char *corafile, REAL *dcut,
+                     char *manifest)
+   --------------------------------------------------------------------
    Input:   int    argc         Argument count
             char   **argv       Argument array
-   Output:  char   *ssapfile    Input SSAP file               
-            char   *pdbfile1    First input PDB file
-            char   *pdbfile2    Second input PDB file
-            char   *outfile     Output listing file (or blank string)
-            char   *outpdb1     Output first PDB file (or blank string)
-            char   *outpdb2     Output second PDB file (or blank string)
+   Output:  char   *corafile    Input CORA file (or blank string)
             REAL   *dcut        Cutoff for defining core
+            char   *manifest    Batch manifest (or blank string)
    Returns: BOOL                Success?
 
    Parse the command line
@@ -270,12 +672,19 @@ int main(int argc, char **argv)
    14.11.96 Original    By: ACRM
    06.12.96 Added -i
    23.01.97 Added -n
+   16.10.26 Added -f
+   16.10.26 Added -r and -c
+   16.10.26 Added -t
+   16.10.26 Added -k
+   16.10.26 Added -b and -l
+   16.10.26 Options missing their argument are rejected
 */
-BOOL ParseCmdLine(int argc, char **argv, char *corafile, REAL *dcut)
+BOOL ParseCmdLine(int argc, char **argv, char *corafile, REAL *dcut,
+                  char *manifest)
 {
    argc--;
    argv++;
-   corafile[0] = '\0';
+   corafile[0] = manifest[0] = '\0';
    
    if(argc==0)
       return(FALSE);
@@ -288,6 +697,8 @@ BOOL ParseCmdLine(int argc, char **argv, char *corafile, REAL *dcut)
          case 'd':
             argc--;
             argv++;
+            if(!argc)
+               return(FALSE);
             sscanf(argv[0],"%lf",dcut);
             break;
          case 'p':
@@ -297,10 +708,69 @@ BOOL ParseCmdLine(int argc, char **argv, char *corafile, REAL *dcut)
             gVerbose = TRUE;
             break;
          case 'i':
-            gInitialCut = TRUE;
+            gOptions.initialCut = TRUE;
             break;
          case 'n':
-            gDoRandomCoil = TRUE;
+            gOptions.randomCoil = TRUE;
+            break;
+         case 'f':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            if(!strcmp(argv[0], "qcp"))
+               gOptions.backend = FITBACKEND_QCP;
+            else if(!strcmp(argv[0], "matfit"))
+               gOptions.backend = FITBACKEND_MATFIT;
+            else
+               return(FALSE);
+            break;
+         case 'm':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            if(!strcmp(argv[0], "centroid"))
+               gOptions.test = CATEST_CENTROID;
+            else if(!strcmp(argv[0], "pairs"))
+               gOptions.test = CATEST_PAIRS;
+            else
+               return(FALSE);
+            break;
+         case 'r':
+            gOptions.single = TRUE;
+            break;
+         case 'g':
+            gOptions.consensus = TRUE;
+            break;
+         case 't':
+            argc--;
+            argv++;
+            if(!argc || !sscanf(argv[0],"%d",&gThreads) || (gThreads < 1))
+               return(FALSE);
+            break;
+         case 'c':
+            gOptions.single = gCheckSingle = TRUE;
+            break;
+         case 'k':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            gOptions.cachedir = argv[0];
+            break;
+         case 'b':
+            argc--;
+            argv++;
+            if(!argc || (strlen(argv[0]) >= MAXBUFF))
+               return(FALSE);
+            strcpy(manifest, argv[0]);
+            break;
+         case 'l':
+            argc--;
+            argv++;
+            if(!argc || !sscanf(argv[0],"%d",&gCacheMB) || (gCacheMB < 0))
+               return(FALSE);
             break;
          default:
             return(FALSE);
@@ -310,7 +780,7 @@ BOOL ParseCmdLine(int argc, char **argv, char *corafile, REAL *dcut)
       else
       {
          /* Check that there is  only 1 arguments left                  */
-         if(argc < 1 || argc > 1)
+         if(argc < 1 || argc > 1 || manifest[0])
             return(FALSE);
          
          /* Copy it                                                     */
@@ -322,1158 +792,286 @@ BOOL ParseCmdLine(int argc, char **argv, char *corafile, REAL *dcut)
       argv++;
    }
 
-   return(TRUE);
+   return(manifest[0] != '\0');
 }
 
 /************************************************************************/
-/*>ZONE *ReadCORA(FILE *fp)
-   ------------------------
-   Read a CORA alignment file into a set of zones showing residue
-   equivalences
-
-   14.11.96 Original   By: ACRM 
-   23.01.97 Added gDoRandomCoil checking; swapped the logic round for
-            checking secondary structure matches to make this easier.
+/*>BOOL DefineCore(PDB **pdb, ZONELIST *zones, Malign *maln_ptr, REAL dcut,
+                   BOOL single, BOOL verbose)
+  ------------------------------------------------------------------------
+  Input:   PDB       **pdb      The structures
+           Malign    *maln_ptr  The alignment (for the names)
+           REAL      dcut       Cutoff for defining core
+           BOOL      single     Work in single precision
+           BOOL      verbose    Report intermediate zones and the RMSDs
+  I/O:     ZONELIST  *zones     Starting zones; the core on return
+  Returns: BOOL                 Success
+
+  Main routine to do core definition
+  
+  14.11.96 Original   By: ACRM
+  06.12.96 Added handling of gInitialCut
+  16.10.26 Fitting is done from running sums which are updated as pairs
+           enter or leave the core. Falls back to rebuilding the sums
+           each time for any structure whose flagged residues can't be
+           paired off through the zones. Now frees its working copies.
+  16.10.26 Works on C-alpha stores rather than copies of the PDB lists
+  16.10.26 Reports the core RMSDs in verbose mode
+  16.10.26 Builds single precision stores if gSingle is set
+  16.10.26 The work is done by the shared core engine
+  16.10.26 Fits on gPool
+  16.10.26 The work is done by fcDefineCore(). Takes single and verbose
+           rather than using the globals
+  16.10.26 Fails if a zone end has no C-alpha
+  16.10.26 Gives no RMSD for an empty core
 */
-Malign *ReadCORA(FILE *fp)
+BOOL DefineCore(PDB **pdb, ZONELIST *zones, Malign *maln_ptr, REAL dcut,
+                BOOL single, BOOL verbose)
 {
-   /* Define a pointer to point to the first address in the Structure   */
-   Malign *maln_ptr;
-   /* Define a pointer to point to the first address in Malndata
-      (loop through)
-   */
-   Malndata *d_ptr;          
-   Protdata *p_ptr;  
-   /* ZONE *zones; */
-   
-   int  count, count2, count3;
-   char charbuf, buffer[1001], pdb[6];
-   /*  char *p; */
-   
-   maln_ptr = new_Malign();
-   while(fgets( buffer, MAXBUFF, fp ), buffer[0] == '#');
-   
-   /* read each line - maximum characters 100 - into the buffer string  */
-   sscanf(buffer, "%d", &maln_ptr->procnt);
-   
-   /* copy the number of proteins to parse out of the function          */
-   sprintf(maln_ptr->title, "%s", "alnfile");
-   
-   /* loop throught the number of aligned proteins and store the names  */
-   for(count=0; count < maln_ptr->procnt; count++) 
-   { 
-      fscanf(fp, "%s ", maln_ptr->proname[count]);
-   }
-   /* store the number of lines in the file                             */
-   fscanf(fp, "%d", &maln_ptr->length); 
-   
-   count = count2 = count3 = 0;
-   /* Reserve space for the structure Malndata - it returns a pointer 
-      which is made equal to the pointer malndata_ptr within the 
-      structure Malign
-   */
-   (maln_ptr->malndata_ptr) = (Malndata*)malloc(sizeof(Malndata));
-   TEST(maln_ptr->malndata_ptr);
-      
-   /* read through file saving data for selected chain                  */
-   /* loop through every line in the file                               */
-   while(count < maln_ptr->length) 
-   { 	  
-      /* reallocate space of size Malndata make it equal to the start
-         of the structure
-      */
-      (maln_ptr->malndata_ptr) =
-         (Malndata*)realloc(maln_ptr->malndata_ptr,
-                            (count+1)*sizeof(Malndata)); 
-      TEST(maln_ptr->malndata_ptr);
-      
-      /* move the pointer along to the next space by setting d_ptr      */
-      d_ptr = maln_ptr->malndata_ptr + count; 
-      
-      /* store values                                                   */
-      fscanf(fp, "%d %d %d ",
-             &d_ptr->alnpos, &d_ptr->conpos, &d_ptr->proaln );
-      
-      /* Reserve space for the structure Protdata- it returns a pointer 
-         which is made equal to the pointer malndata_ptr within the 
-         structure d
-      */
-      (d_ptr->protdata_ptr)=(Protdata*)malloc(sizeof(Protdata));
-      TEST(d_ptr->protdata_ptr);
-      
-      for(count2=0; count2 < maln_ptr->procnt; count2++) 
-      {
-         int  number;
-         char insert;
-         
-         (d_ptr->protdata_ptr)=
-            (Protdata*)realloc(d_ptr->protdata_ptr,
-                               (count2+1)*sizeof(Protdata));
-         TEST(d_ptr->protdata_ptr);
-         
-         p_ptr = d_ptr->protdata_ptr + count2;
-         fscanf(fp, "%s %c %c ", pdb, &p_ptr->acid, &p_ptr->secstruct);
-         insert = ' ';
-         sscanf(pdb, "%d%c", &number, &insert);
-         sprintf(p_ptr->pdb, "%d%c", number, insert);
-      }
-      
-      fscanf(fp, "%c ", &d_ptr->consecstruc);
-      while((charbuf = fgetc( fp )), charbuf != '\n' );
-      count++;
+   FCOPTIONS opts;
+   REAL      *rmsd;
+   int       *npairs,
+             protNum,
+             numProts = maln_ptr->procnt,
+             status;
+
+   if(((rmsd = (REAL *)malloc(numProts * sizeof(REAL)))==NULL) ||
+      ((npairs = (int *)malloc(numProts * sizeof(int)))==NULL))
+   {
+      FREE(rmsd);
+      fprintf(stderr,"No memory for finding the core\n");
+      return(FALSE);
    }
-   
-   return(maln_ptr);
-}
 
-/*************************************************************************
-   FINDS THE ZONES IN CORA
-*************************************************************************/
-ZONE *calcZone(Malign *maln_ptr)
-{
-   int count, count2;
-   Malndata *d_ptr;
-   Malndata *d_temp_ptr;
-   Malndata *d_temp_sec_ptr;
-   Protdata *p_ptr;
-   Protdata *p_temp_ptr;
-   Protdata *p_temp_sec_ptr;
-   
-   ZONE *zones = NULL, *z;
-   /*  int insertion = 0; */
-   int strands = 0;
-   int helix = 0; 
-   int no_ss = 0;
-   int startZone = 0;
-   int endZone = 0;
-   int protnum = 0;
-   /*  int i = 0; */
-   int first = 0;
-   int second = 0;
-   
-   /* Outer loop through each alignment position                        */
-   for(count2=0; count2 < maln_ptr->length; count2++) 
+   opts        = gOptions;
+   opts.single = single;
+   if(verbose)
+      opts.cutReport = ReportCut;
+
+   if((status = fcDefineCore(&opts, pdb, numProts, zones, dcut, rmsd,
+                             npairs)) == FC_NOMEM)
    {
-      /* inner cycles through each protein                              */
-      for( count=0; count < maln_ptr->procnt; count++)
-      { 	
-         d_ptr = maln_ptr->malndata_ptr + count2;	    
-         p_ptr = d_ptr->protdata_ptr + count;
-         
-         if(p_ptr->secstruct == 'E')
-            strands = 1;
-         
-         if(p_ptr->secstruct == 'H')
-            helix = 1;
+      fprintf(stderr,"No memory for finding the core\n");
+   }
+   else if(status == FC_BADZONE)
+   {
+      fprintf(stderr,"CORA zone starts or ends at a residue with no \
+C-alpha\n");
+   }
+   else
+   {
+      if(status == FC_MAXITER)
+         fprintf(stderr,"Warning: Maximum number of iterations (%d) \
+exceeded!\n",CORE_MAXITER);
 
-         if(p_ptr->secstruct == '0')
-            no_ss = 1;
-      }
-      
-      /* IF THERE ARE NO HELICES, COILS                                 */
-      if ((strands == 1) && (no_ss == 0) && (helix == 0))
+      if(verbose)
       {
-         /* THIS IS THE START POSITION                                  */
-         startZone = count2;
-         /* while there are still only strands aligned and the end of
-            the file is not reached
-         */
-         while((strands == 1) && (no_ss == 0) && (helix == 0) 
-               && (count2 < maln_ptr->length))
+         if(opts.consensus)
+            printf("\nCore RMSDs from the mean:\n");
+         else
+            printf("\nCore RMSDs:\n");
+         for(protNum=(opts.consensus?0:1); protNum<numProts; protNum++)
          {
-            /* go onto next alignment position                          */
-            count2++;
-            
-            /* loop through all prots at that alignment position        */
-            for (count=0; count < maln_ptr->procnt; count++)
-            {
-               d_ptr = maln_ptr->malndata_ptr + count2;	    
-               p_ptr = d_ptr->protdata_ptr + count;
-               if(p_ptr->secstruct == 'E')
-                  strands = 1;
-
-               if(p_ptr->secstruct == 'H')
-                  helix = 1;
-
-               if(p_ptr->secstruct == '0')
-                  no_ss = 1;
-            }
+            if(npairs[protNum])
+               printf("%s : %.3f over %d pairs\n",
+                      maln_ptr->proname[protNum], rmsd[protNum],
+                      npairs[protNum]);
+            else
+               printf("%s : none, the core is empty\n",
+                      maln_ptr->proname[protNum]);
          }
-
-         /* when this is not true any more mark the end of the zone
-            minus one as the program increments one beyond the 
-            zone to test it
-         */
-         endZone = count2;
-         endZone = endZone-1;
       }
-      /* IF THERE ARE NO STRANDS, COILS                                 */
-      else if((strands == 0) && (no_ss == 0) && (helix == 1))
-      {
-         /* THIS IS THE START POSITION                                  */
-         startZone = count2;
-	 
-         /* while there are still only strands aligned and the end of
-            the file is not reached
-         */
-         while((strands == 0) && (no_ss == 0) && (helix == 1) 
-               && (count2 < maln_ptr->length))
-         {
-            /* increment alignment position                             */
-            count2++;
-            
-            /* loop through all prots at that alignment position        */
-            for(count=0; count < maln_ptr->procnt; count++)
-            {
-               d_ptr = maln_ptr->malndata_ptr + count2;	    
-               p_ptr = d_ptr->protdata_ptr + count;
-               if(p_ptr->secstruct == 'E')
-                  strands = 1;
+   }
 
-               if(p_ptr->secstruct == 'H')
-                  helix = 1;
+   free(rmsd);
+   free(npairs);
 
-               if(p_ptr->secstruct == '0')
-                  no_ss = 1;
-            }
-         }
+   return((status != FC_NOMEM) && (status != FC_BADZONE));
+}
 
-         /* when this is not true any more mark the end of the zone
-            minus one as the program increments one beyond the 
-            zone to test it
-         */
-         endZone = count2;
-         endZone = endZone -1;
-      }
-      
-      /* record the start and end residues into the zone array          */
-      if(startZone)
-      {
-         if(zones==NULL)
-         {
-            INITPREV(zones,ZONE);
-            z=zones;
-         }
-         else
-         {
-            ALLOCNEXTPREV(z,ZONE);
-         }
 
-         if(z==NULL)
-         {
-            FREELIST(zones,ZONE);
-            return(NULL);
-         }
-         
-         {
-            int my_i;
-            for(my_i=0; my_i<MAXMALNPNO; my_i++)
-            {
-               z->start[my_i] = (-1);
-               z->end[my_i]   = (-1);
-            }
-         }
-	 
-         /* loop through the prots and record each resnum for start and
-            end
-         */
-         for(protnum=0; protnum < maln_ptr->procnt; protnum++)
-         {
-            /* pointer to the start position                            */
-            d_temp_ptr = maln_ptr->malndata_ptr + startZone;
-            p_temp_ptr = d_temp_ptr->protdata_ptr + protnum;
-            
-            d_temp_sec_ptr = maln_ptr->malndata_ptr + endZone; 
-            p_temp_sec_ptr = d_temp_sec_ptr->protdata_ptr + protnum;
-            
-            first = atoi(p_temp_ptr->pdb);
-            second = atoi(p_temp_sec_ptr->pdb);
-            
-            z->start[protnum] = first;
-            z->end[protnum] = second;
-         } 
-      }
-      
-      strands   = 0;
-      helix     = 0;
-      no_ss     = 0;
-      startZone = 0;
-      endZone   = 0;
-   }
-   
-   return(zones);
+/************************************************************************/
+/*>void ReportCut(void *arg, ZONELIST *zones)
+  ------------------------------------------
+  Input:   void     *arg       Not used
+           ZONELIST *zones     Zones after the initial cut
+
+  Verbose report from fcDefineCore() after the initial cut
+
+  06.12.96 Original (as part of DefineCore())   By: ACRM
+  16.10.26 Split out as a libfindcore callback
+*/
+void ReportCut(void *arg, ZONELIST *zones)
+{
+   int numProts = zones->nstruc;
+
+   printf("\nCore after removing residues > 3.0A:\n");
+   WriteTextOutput(zones, &numProts);
 }
 
 
 /************************************************************************/
-/*>BOOL DefineCore(FILE *outfp, PDB *pdb1, PDB *pdb2, ZONE *zones, 
-                   REAL dcut)
-  -----------------------------------------------------------------------
-  Main routine to do core definition
-  
-  14.11.96 Original   By: ACRM
-  06.12.96 Added handling of gInitialCut
+/*>ZONELIST *DoubleCore(PDB **pdb, ZONELIST *zones, Malign *maln_ptr,
+                        REAL dcut)
+  -------------------------------------------------------------------
+  Input:   PDB       **pdb      The structures
+           ZONELIST  *zones     Starting zones (not changed)
+           Malign    *maln_ptr  The alignment
+           REAL      dcut       Cutoff for defining core
+  Returns: ZONELIST  *          Merged core zones found in double
+                                precision (NULL on failure)
+
+  Finds the core from a copy of the starting zones in double precision
+  so the single precision result can be checked against it. Only
+  errors are printed.
+
+  16.10.26 Original   By: ACRM
+  16.10.26 Passes its settings to DefineCore() rather than changing
+           the globals
+  16.10.26 Reports its own errors and fails if the core couldn't be
+           found
 */
-BOOL DefineCore(PDB **pdb, ZONE *zones, Malign *maln_ptr, REAL dcut)
+ZONELIST *DoubleCore(PDB **pdb, ZONELIST *zones, Malign *maln_ptr,
+                     REAL dcut)
 {
-   int  count    = 0,
-        last     = 0,
-        iter     = 0,
-        protNum  = 0,
-        numProts = 0,
-        decrease = 0,
-        natoms[MAXMALNPNO];
-   REAL rm[3][3];
-   PDB  *pdbca[MAXMALNPNO],
-        **idx[MAXMALNPNO];
-   
-   /* Duplicate the PDB linked lists                                    */
-   for(protNum = 0; protNum< maln_ptr->procnt; protNum++)
-   {
-      if((pdbca[protNum] = blDupePDB(pdb[protNum])) == NULL)
-      {
-         return(FALSE);
-         for(decrease = protNum; decrease>1; decrease--)
-         {
-            FREELIST(pdbca[decrease],PDB);
-         }
-      }
-   }
-   
-   /* Reduce to CA only                                                 */
-   for(protNum = 0; protNum< maln_ptr->procnt; protNum++)
-   {                    
-      pdbca[protNum]= blSelectCaPDB(pdbca[protNum]);
-      SetBValByZone(pdbca[protNum],zones,protNum);
-   }
+   ZONELIST *dzones;
 
-   count = CountCore(pdbca[0]);
-   
-   for(protNum = 0; protNum< maln_ptr->procnt; protNum++)
+   if((dzones = DupZoneList(zones))==NULL)
    {
-      if((idx[protNum] = blIndexPDB(pdbca[protNum],
-                                    &natoms[protNum]))==NULL)
-      {
-         for(decrease = protNum; decrease>1; decrease--)
-         {
-            FREELIST(pdbca[decrease],PDB);
-            return(FALSE);
-         }
-      }
+      fprintf(stderr,"No memory for double precision check\n");
+      return(NULL);
    }
-   numProts = maln_ptr->procnt;
-   
-   if(gInitialCut)
-   {
-      for(protNum=1; protNum<numProts; protNum++)
-      {
-         FitCaPDBBFlag(pdbca[0], pdbca[protNum], rm);
-      }
-      
-      if(!DoCut(idx, natoms, numProts, zones, dcut*dcut))
-         return(FALSE);
-      
-      count = CountCore(pdbca[0]);
-      
-      if(gVerbose)
-      {
-         printf("\nCore after removing residues > 3.0A:\n");
-         WriteTextOutput(zones, &numProts);
-      }
-   }
-   
-   iter=0;
-   
-   while(last != count)
+
+   if(!DefineCore(pdb, dzones, maln_ptr, dcut, FALSE, FALSE))
    {
-      for(protNum=1; protNum<numProts; protNum++)
-      {
-         FitCaPDBBFlag(pdbca[0], pdbca[protNum], rm);
-      }
-      
-      UpdateBValues(idx, natoms, numProts, zones, dcut*dcut);
-      last = count;
-      count = CountCore(pdbca[0]);
-      if(++iter > MAXITER)
-      {
-         fprintf(stderr,"Warning: Maximum number of iterations \
-(%d) exceeded!\n",MAXITER);
-         break;
-      }
+      FreeZoneList(dzones);
+      return(NULL);
    }
-   
-   for(protNum = 0; protNum < maln_ptr->procnt; protNum++)
+
+   if(!MergeZones(dzones))
    {
-      free(idx[protNum]);
+      fprintf(stderr,"No memory for double precision check\n");
+      FreeZoneList(dzones);
+      return(NULL);
    }
-   
-   return(TRUE);
+
+   return(dzones);
 }
 
 
 /************************************************************************/
-/*>BOOL DoCut(PDB **idx1, int natom1, PDB **idx2, int natom2,
-  ZONE *zones, REAL cutsq)
-  ----------------------------------------------------------
-  Performs the initial cut of pairs which deviate by >3.0A
+/*>void WriteTextOutput(FILE *fp, ZONELIST *zones)
+  -----------------------------------------------
+  Writes the zones out in text format
   
-  06.12.96 Original   By: ACRM
+  14.11.96 Original   By: ACRM
+  06.12.96 Added check that zones have not been blanked out
 */
-BOOL DoCut(PDB **idx[MAXMALNPNO], int *natoms, int nstruc,
-           ZONE *zones, REAL cutsq)
+void WriteTextOutput(ZONELIST *zones, int *numProts)
 {
-   ZONE *z, *zend, *znext;
-   int  i,
-        snum, snum2, snum3,
-        starts[MAXMALNPNO], ends[MAXMALNPNO], offsets[MAXMALNPNO];
-   BOOL split,
-        ok,
-        lastIter;
+   int  z;
+   int  i = 0;
    
-   for(z=zones; z!=NULL; NEXT(z))
+   for(z=0; z<zones->nzones; z++)
    {
-      /* Look for the start of the zone                                 */
-      for(snum=0; snum<nstruc; snum++)
-      {
-         for(starts[snum]=0; starts[snum]<natoms[snum]; starts[snum]++)
-         {
-            if(idx[snum][starts[snum]]->resnum == z->start[snum])
-               break;
-         }
-      }
-      
-      /* Look for the end of the zone                                   */
-      for(snum=0; snum<nstruc; snum++)
+      if(!ZONEDELETED(zones, z))
       {
-         for(ends[snum]=0; ends[snum]<natoms[snum]; ends[snum]++)
-         {
-            if(idx[snum][ends[snum]]->resnum == z->end[snum])
-               break;
-         }
-      }
-      
-      /* Step through the zone to see if we are within the cutoff       */
-      split = FALSE;
-      for(snum=0; snum<nstruc; snum++)
-      {
-         offsets[snum] = starts[snum];
-      }
-      
-      lastIter = FALSE;
-      for(;;)
-      {
-         /* Check the offsets are all in range                          */
-         for(snum=0; snum<nstruc; snum++)
-         {
-            if(offsets[snum] > ends[snum])
-            {
-               lastIter = TRUE;
-               break;
-            }
-         }
-         if(lastIter)
-            break;
-         
-         /* Check all the pairwise distances are in range               */
-         for(snum=0; snum<nstruc-1; snum++)
+	 for(i = 0; i< *numProts; i++)
          {
-            for(snum2=snum+1; snum2<nstruc; snum2++)
+            printf("%4d -%4d ",ZSTART(zones, z, i),ZEND(zones, z, i));
+            if (i<*numProts)
             {
-               /* If a pair is out of range, then set the split flag and
-                  set the bvalues of all the members to zero
-               */
-               if(DISTSQ(idx[snum][offsets[snum]],
-                         idx[snum2][offsets[snum2]]) > cutsq)
-               {
-                  split = TRUE;
-                  for(snum3=0; snum3<nstruc; snum3++)
-                  {
-                     idx[snum3][offsets[snum3]]->bval = (REAL)0.0;
-                  }
-               }
+               printf(": ");
             }
          }
-         
-         /* Increment the offsets                                       */
-         for(snum=0; snum<nstruc; snum++)
-         {
-            (offsets[snum])++;
-         }
+	 printf("\n");
       }
-      
-      /* See if there were any bits out of range which need the zones
-         to be split
-      */
-      if(split)
-      {
-         /* See if the whole zone was out of range                      */
-         ok = FALSE;
-         lastIter = FALSE;
-         for(snum=0; snum<nstruc; snum++)
-         {
-            for(i=starts[snum]; i<=ends[snum]; i++)
-            {
-               if(idx[snum][i]->bval == (REAL)10.0)
-               {
-                  ok = TRUE;
-                  lastIter = TRUE;
-                  break;
-               }
-            }
-            if(lastIter)
-               break;
-         }
-         
-         /* If the zone contains no pairs within 3.0A, mark it for
-            deletion by setting all values to -9999
-         */
-         if(!ok)
-         {
-            for(snum=0; snum<nstruc; snum++)
-            {
-               z->start[snum] = z->end[snum] = (-9999);
-            }
-         }
-         else
-         {
-            /* There were some parts which are still required, but it's
-               been modified, so we need to split the zones up
-            */
-            
-            /* First see if we've lost residues from the start of the
-               zone
-            */
-            for(;;)
-            {
-               /* Start off assuming that all the pairs are OK at the 
-                  start of the zone and we are not removing anything.
-                  See if any of the pairs were to be removed and if so
-                  this isn't the last iteration
-               */
-               lastIter = TRUE;
-               for(snum=0; snum<nstruc; snum++)
-               {
-                  if(idx[snum][starts[snum]]->bval == (REAL)0.0)
-                  {
-                     lastIter = FALSE;
-                     break;
-                  }
-               }
-               
-               /* If it's the last iteration, so nothing more to be
-                  removed from the start of the zone, then break out
-               */
-               if(lastIter)
-               {
-                  break;
-               }
-               else
-               {
-                  /* We are removing this residue group from the zone
-                     so bump the start pointers and update the zone
-                  */
-                  for(snum=0; snum<nstruc; snum++)
-                  {
-                     (starts[snum])++;
-                     z->start[snum] = idx[snum][starts[snum]]->resnum;
-                  }
-               }
-            }
-            
-            /* Now remove residues from the end of the zone in the same
-               way
-            */
-            for(;;)
-            {
-               /* Start off assuming that all the pairs are OK at the 
-                  start of the zone and we are not removing anything.
-                  See if any of the pairs were to be removed and if so
-                  this isn't the last iteration
-               */
-               lastIter = TRUE;
-               for(snum=0; snum<nstruc; snum++)
-               {
-                  if(idx[snum][ends[snum]]->bval == (REAL)0.0)
-                  {
-                     lastIter = FALSE;
-                     break;
-                  }
-               }
-               
-               /* If it's the last iteration, so nothing more to be
-                  removed from the start of the zone, then break out
-               */
-               if(lastIter)
-               {
-                  break;
-               }
-               else
-               {
-                  /* We are removing this residue group from the zone
-                     so bump the start pointers and update the zone
-                  */
-                  for(snum=0; snum<nstruc; snum++)
-                  {
-                     (ends[snum])--;
-                     z->end[snum] = idx[snum][ends[snum]]->resnum;
-                  }
-               }
-            }
-            
-            /* See if the new zone is split                             */
-            split = FALSE;
-            for(snum=0; snum<nstruc; snum++)
-            {
-               for(i=starts[snum]; i<=ends[snum]; i++)
-               {
-                  if(idx[snum][i]->bval == (REAL)0.0)
-                  {
-                     split = TRUE;
-                     break;
-                  }
-               }
-               if(split)
-                  break;
-            }
-            
-            while(split)
-            {
-               /* Move the last sub-zone into a separate zone           */
-               znext = z->next;
-               INIT(zend, ZONE);
-               if(zend==NULL)
-               {
-                  fprintf(stderr,"No memory for new zones!\n");
-                  return(FALSE);
-               }
-               z->next     = zend;
-               zend->prev  = z;
-               zend->next  = znext;
-               znext->prev = zend;
-               
-               for(snum=0; snum<nstruc; snum++)
-               {
-                  zend->end[snum] = z->end[snum];
-               }
-               
-               /* Step back through the zone to find the start of this
-                  subzone
-               */
-               lastIter = FALSE;
-               for(;;)
-               {
-                  for(snum=0; snum<nstruc; snum++)
-                  {
-                     if(idx[snum][ends[snum]]->bval != (REAL)10.0)
-                     {
-                        lastIter = TRUE;
-                        break;
-                     }
-                  }
-                  if(lastIter)
-                     break;
-                  
-                  for(snum=0; snum<nstruc; snum++)
-                  {
-                     (ends[snum])--;
-                     zend->start[snum] = idx[snum][ends[snum]]->resnum;
-                  }
-               }
-               
-               /* Now step back to the end of the previous subzone      */
-               lastIter = FALSE;
-               for(;;)
-               {
-                  for(snum=0; snum<nstruc; snum++)
-                  {
-                     if(idx[snum][ends[snum]]->bval != (REAL)0.0)
-                     {
-                        lastIter = TRUE;
-                        break;
-                     }
-                  }
-                  if(lastIter)
-                     break;
-                  
-                  for(snum=0; snum<nstruc; snum++)
-                  {
-                     (ends[snum])--;
-                     z->end[snum] = idx[snum][ends[snum]]->resnum;
-                  }
-               }
-               
-               /* Test again to see if it's split                       */
-               split = FALSE;
-               
-               for(snum=0; snum<nstruc; snum++)
-               {
-                  for(i=starts[snum]; i<=ends[snum]; i++)
-                  {
-                     if(idx[snum][i]->bval == (REAL)0.0)
-                     {
-                        split = TRUE;
-                        break;
-                     }
-                  }
-                  if(split)
-                     break;
-               }
-            }  /* While the zone is split                               */
-         }  /* If this zone was OK                                      */
-      }  /* If the zone contained any splits                            */
-   }  /* For each zone                                                  */
-   
-   return(TRUE);
+   }
 }
 
+
 /************************************************************************/
-/*>void UpdateBValues(PDB **idx[MAXSTRUC], int *natoms, int nstruc,
-                      ZONE *zones, REAL cutsq)
-   ------------------------------------------------------------------
-   Update the B-values and the current zones by extending out from
-   the secondary structure regions
-  
-   14.11.96 Original   By: ACRM
-   13.03.97 Now checks that residues are not already in a zone before
-            adding them to the current zone. Fixes a problem at the
-            zone-merge stage where the merged zones could end up with
-            different numbers of residues.
-   08.05.02 Generalized to work with multiple structures
-*/
-void UpdateBValues(PDB **idx[MAXMALNPNO], int *natoms, int nstruc,
-                   ZONE *zones, REAL cutsq)
-{
-   ZONE *z;
-   int  snum, offset[MAXMALNPNO];
-   BOOL lastIter;
-   
-   for(z=zones; z!=NULL; NEXT(z))
-   {
-      if(z->start[0] < -9998)
-         continue;
-      
-      /* Look for the start of the zone - store this in offset[] for
-         each protein
-      */
-      for(snum=0; snum<nstruc; snum++)
-      {
-         for(offset[snum]=0; offset[snum]<natoms[snum]; offset[snum]++)
-         {
-            if(idx[snum][offset[snum]]->resnum == z->start[snum])
-               break;
-         }
-      }
-      
-      /* Step back from the start of a zone, checking every pair of
-         atoms is within the cutoff. Keep going back until an atom pair
-         is too far apart or we reach the beginning of one of the proteins
-      */
-      
-      /* Loop forever                                                   */
-      lastIter = FALSE;
-      for(;;)
-      {
-         /* Move the protein pointers back one residue, checking that we 
-            haven't come off the start of any of the structures.
-         */
-         for(snum=0; snum<nstruc; snum++)
-         {
-            if(--offset[snum] < 0)
-            {
-               lastIter = TRUE;
-               /* Note that we don't break out here as we need all the
-                  pointers to be in sync
-               */
-            }
-            
-         }
-         if(lastIter)
-            break;
-         
-         /* End the loop if the BVal for any of the structures is >5.0  */
-         for(snum=0; snum<nstruc; snum++)
-         {
-            if(idx[snum][offset[snum]]->bval > (REAL)5.0)
-            {
-               lastIter = TRUE;
-               break;
-            }
-         }
-         if(lastIter)
-            break;
-         
-         /* Now look at each pair of structures, if the distance between
-            the atoms is > cutsq then end the loop
-         */
-         for(snum=0; snum<nstruc-1; snum++)
-         {
-            int snum2;
-            for(snum2=snum+1; snum2<nstruc; snum2++)
-            {
-               if((DISTSQ(idx[snum][offset[snum]],
-                          idx[snum2][offset[snum2]])) > cutsq)
-               {
-                  lastIter = TRUE;
-                  snum = nstruc; /* Force break from outer loop         */
-                  break;
-               }
-            }
-         }
-         if(lastIter)
-            break;
-         
-         /* Everything was OK, so mark these residues as part of a zone */
-         for(snum=0; snum<nstruc; snum++)
-         {
-            idx[snum][offset[snum]]->bval = (REAL)10.0;
-         }
-      }  /* End of loop back from start of zone                         */
-      
-      /* Bump the offsets back up by one so we are pointing to the first
-         residue that was within the OK zone and update the zone starts
-      */
-      for(snum=0; snum<nstruc; snum++)
-      {
-         (offset[snum])++;
-         z->start[snum] = idx[snum][offset[snum]]->resnum;
-      }
-      
-      /* ---- Repeat the above procedure but for the ends of zones ---- */
-      
-      /* Look for the end of the zone - store this in offset[] for each
-         protein
-      */
-      for(snum=0; snum<nstruc; snum++)
-      {
-         for(offset[snum]=0; offset[snum]<natoms[snum]; offset[snum]++)
-         {
-            if(idx[snum][offset[snum]]->resnum == z->end[snum])
-               break;
-         }
-      }
-      
-      /* Step forward from the end of zone, checking every pair of
-         atoms is within the cutoff. Keep going forward until an atom 
-         pair is too far apart or we reach the end of one of the proteins
-      */
-      
-      /* Loop forever                                                   */
-      lastIter = FALSE;
-      for(;;)
-      {
-         /* Move the protein pointers forward one residue, checking that
-            we haven't come off the end of any of the structures.
-         */
-         for(snum=0; snum<nstruc; snum++)
-         {
-            if(++offset[snum] >= natoms[snum])
-            {
-               lastIter = TRUE;
-               /* Note that we don't break out here as we need all the
-                  pointers to be in sync
-               */
-            }
-            
-         }
-         if(lastIter)
-            break;
-         
-         /* End the loop if the BVal for any of the structures is >5.0  */
-         for(snum=0; snum<nstruc; snum++)
-         {
-            if(idx[snum][offset[snum]]->bval > (REAL)5.0)
-            {
-               lastIter = TRUE;
-               break;
-            }
-         }
-         if(lastIter)
-            break;
-         
-         /* Now look at each pair of structures, if the distance between
-            the atoms is > cutsq then end the loop
-         */
-         for(snum=0; snum<nstruc-1; snum++)
-         {
-            int snum2;
-            for(snum2=snum+1; snum2<nstruc; snum2++)
-            {
-               if((DISTSQ(idx[snum][offset[snum]],
-                          idx[snum2][offset[snum2]])) > cutsq)
-               {
-                  lastIter = TRUE;
-                  snum = nstruc; /* Force break from outer loop         */
-                  break;
-               }
-            }
-         }
-         if(lastIter)
-            break;
-         
-         /* Everything was OK, so mark these residues as part of a zone */
-         for(snum=0; snum<nstruc; snum++)
-         {
-            idx[snum][offset[snum]]->bval = (REAL)10.0;
-         }
-      }  /* End of loop forwards from end of zone                       */
-      
-      /* Bump the offsets back down by one so we are pointing to the last
-         residue that was within the OK zone and update the zone ends
-      */
-      for(snum=0; snum<nstruc; snum++)
-      {
-         (offset[snum])--;
-         z->end[snum] = idx[snum][offset[snum]]->resnum;
-      }
-   }  /* Continue with the next zone                                    */
-}
+/*>BOOL WriteCorePDBs(PDB **pdb, ZONELIST *zones, Malign *maln_ptr)
+   ----------------------------------------------------------------
+   Input:   PDB      **pdb      The structures
+            ZONELIST *zones     Final zones
+            Malign   *maln_ptr  Alignment (for the file names)
+   Returns: BOOL                All the files were written
 
+   Writes each structure to its name from the CORA file with COREEXT
+   added, with B-values of 10 in the core and 0 elsewhere. The files
+   are independent so they are written on the thread pool.
 
-/************************************************************************/
-/*>void SetBValByZone(PDB *pdb, ZONE *zones, int which)
-  ----------------------------------------------------
-  Set B-values to 10 if in the zones, otherwise to 0.0
-  
-  14.11.96 Original   By: ACRM
+   16.10.26 Original   By: ACRM
 */
-void SetBValByZone(PDB *pdb, ZONE *zones, int protNum)
+BOOL WriteCorePDBs(PDB **pdb, ZONELIST *zones, Malign *maln_ptr)
 {
-   PDB *p;
-   ZONE *z;
-   
-   for(p=pdb; p!=NULL; NEXT(p))
-      p->bval = (REAL)0.0;
-   
-   for(p=pdb; p!=NULL; NEXT(p))
+   COREOUTPUT out;
+   int        s;
+   BOOL       ok = TRUE;
+
+   if((out.written = (BOOL *)malloc(maln_ptr->procnt * sizeof(BOOL)))
+      == NULL)
    {
-      for(z=zones; z!=NULL; NEXT(z))
-      {
-         if((p->resnum >= z->start[protNum]) &&
-            (p->resnum <= z->end[protNum]))
-            p->bval = (REAL)10.0;
-      }
+      fprintf(stderr,"No memory for writing PDB files\n");
+      return(FALSE);
    }
-}
-
+   out.pdb   = pdb;
+   out.zones = zones;
+   out.names = maln_ptr->proname;
 
-/************************************************************************/
-/*>BOOL FitCaPDBBFlag(PDB *ref_pdb, PDB *fit_pdb, REAL rm[3][3])
-  -------------------------------------------------------------
-  Input:   PDB  *ref_pdb     Reference PDB linked list
-  I/O:     PDB  *fit_pdb     Mobile PDB linked list
-  Output:  REAL rm[3][3]     Rotation matrix (May be input as NULL).
-  Returns: BOOL              Success
-  
-  Fits two PDB linked lists using only the CA atoms of residues
-  flagged in the BVal column with a non-zero BValue (atoms not to be 
-  fitted have BVal set to 0).
-  
-  Actually fits fit_pdb onto ref_pdb and also returns the rotation 
-  matrix. This may be NULL if these data are not required.
-  
-  14.11.96 Original based on FitCaPDB()   By: ACRM
-*/
-BOOL FitCaPDBBFlag(PDB *ref_pdb, PDB *fit_pdb, REAL rm[3][3])
-{
-   REAL  RotMat[3][3];
-   COOR  *ref_coor   = NULL,
-         *fit_coor   = NULL;
-   VEC3F ref_ca_CofG,
-         fit_ca_CofG,
-         tvect;
-   int   NCoor       = 0,
-         i, j;
-   BOOL  RetVal;
-   PDB   *ref_ca_pdb = NULL,
-         *fit_ca_pdb = NULL;
-   
-   /* First extract only the CA atoms of residues where BVal > 0.5      */
-   if((ref_ca_pdb = DupeCAByBVal(ref_pdb))==NULL)
-      RetVal = FALSE;
+   RunPool(gOptions.pool, WriteCoreTask, (void *)&out, maln_ptr->procnt);
 
-   if((fit_ca_pdb = DupeCAByBVal(fit_pdb))==NULL)
-      RetVal = FALSE;
-   
-   /* If we succeeded in building our CA PDB linked lists...            */
-   if(RetVal)
+   /* Report any failures in order                                      */
+   for(s=0; s<maln_ptr->procnt; s++)
    {
-      /* Get the CofG of the CA structures and the original mobile      */
-      blGetCofGPDB(ref_ca_pdb, &ref_ca_CofG);
-      blGetCofGPDB(fit_ca_pdb, &fit_ca_CofG);
-      
-      /* Move them both to the origin                                   */
-      blOriginPDB(ref_ca_pdb);
-      blOriginPDB(fit_ca_pdb);
-      /*
-      for(p=fit_ca_pdb;  p!=NULL; NEXT(p))
-      {
-         printf("%f  \n", p->x);
-      }
-      */
-
-      /* Create coordinate arrays, checking numbers match               */
-      NCoor = blGetPDBCoor(ref_ca_pdb, &ref_coor);
-      if(blGetPDBCoor(fit_ca_pdb, &fit_coor) != NCoor)
-      {
-         RetVal = FALSE;
-      }
-      else
+      if(!out.written[s])
       {
-         /* Can't fit with fewer than 3 coordinates                     */
-         if(NCoor < 3)
-         {
-            RetVal = FALSE;
-         }
-         else
-         {
-            /* Everything OK, go ahead with the fitting                 */
-            if(!blMatfit(ref_coor,fit_coor,RotMat,NCoor,NULL,FALSE))
-            {
-               RetVal = FALSE;
-            }
-            else
-            {
-               /* Apply the operations to the true coordinates          */
-               tvect.x = (-fit_ca_CofG.x);
-               tvect.y = (-fit_ca_CofG.y);
-               tvect.z = (-fit_ca_CofG.z);
-               blTranslatePDB(fit_pdb, tvect);
-               blApplyMatrixPDB(fit_pdb, RotMat);
-               blTranslatePDB(fit_pdb, ref_ca_CofG);
-            }
-         }
+         fprintf(stderr,"Unable to write %s%s\n", maln_ptr->proname[s],
+                 COREEXT);
+         ok = FALSE;
       }
    }
-   
-   /* Free the coordinate arrays and CA PDB linked lists                */
-   if(ref_coor)   free(ref_coor);
-   if(fit_coor)   free(fit_coor);
-   if(ref_ca_pdb) FREELIST(ref_ca_pdb, PDB);
-   if(fit_ca_pdb) FREELIST(fit_ca_pdb, PDB);
-   
-   /* Fill in the rotation matrix for output, if required               */
-   if(RetVal && (rm!=NULL))
-   {
-      for(i=0; i<3; i++)
-         for(j=0; j<3; j++)
-            rm[i][j] = RotMat[i][j];
-   }
-   
-   return(RetVal);
+
+   free(out.written);
+   return(ok);
 }
 
 
 /************************************************************************/
-/*>int CountCore(PDB *pdb)
-  -----------------------
-  Count how many residues are in the core regions
-  
-  14.11.96 Original   By: ACRM
-*/
-int CountCore(PDB *pdb)
-{
-   PDB *p;
-   int count = 0;
-   
-   for(p=pdb; p!=NULL; NEXT(p))
-      if(p->bval > (REAL)0.0)
-         count++;
-   
-   return(count);
-}
+/*>void WriteCoreTask(void *arg, int s)
+   ------------------------------------
+   Input:   void     *arg       COREOUTPUT
+            int      s          Structure to write
 
+   Pool task for WriteCorePDBs(). Each file gets a PDBBUFFER byte
+   buffer so it goes out in a few large writes.
 
-/************************************************************************/
-/*>PDB *DupeCAByBVal(PDB *pdb)
-  ---------------------------
-  Extract the CAs with BVal > 0.0 from a PDB linked list into a new
-  linked list
-  
-  14.11.96 Original   By: ACRM
+   16.10.26 Original   By: ACRM
 */
-PDB *DupeCAByBVal(PDB *pdb)
+void WriteCoreTask(void *arg, int s)
 {
-   PDB *out = NULL, 
-       *p, *q;
-   
-   for(p=pdb; p!=NULL; NEXT(p))
-   {
-      if(!strncmp(p->atnam,"CA  ",3) && (p->bval > (REAL)0.0))
-      {
-         if(out==NULL)
-         {
-            INIT(out,PDB);
-            q=out;
-         }
-         else
-         {
-            ALLOCNEXT(q,PDB);
-         }
-         if(q==NULL)
-         {
-            FREELIST(out,PDB);
-            return(NULL);
-         }
-         
-         blCopyPDB(q,p);
-      }
-   }
-   
-   return(out);
-}
+   COREOUTPUT *out = (COREOUTPUT *)arg;
+   char       *filename;
+   FILE       *fp;
 
-Malign *new_Malign(void)
-{
-   Malign *maln;
-   ALLOC( maln, Malign );
-   TEST(maln);
-   clear_Malign(maln);
-   return(maln);
-}
+   out->written[s] = FALSE;
+   if((filename = (char *)malloc(strlen(out->names[s]) +
+                                 strlen(COREEXT) + 1))==NULL)
+      return;
+   sprintf(filename, "%s%s", out->names[s], COREEXT);
 
-void clear_Malign(Malign *m)
-{
-   int i;
-   
-   m->procnt = 0;
-   m->length = 0;
-   *(m->title) = '\0';
-   
-   for(i=0; i<MAXMALNPNO; i++) 
+   if((fp = fopen(filename, "w"))!=NULL)
    {
-      *(m->proname[i]) = '\0';
+      setvbuf(fp, NULL, _IOFBF, PDBBUFFER);
+      SetBValByZone(out->pdb[s], out->zones, s);
+      blWritePDB(fp, out->pdb[s]);
+      out->written[s] = !ferror(fp);
+      if(fclose(fp))
+         out->written[s] = FALSE;
    }
-}
-
 
-/************************************************************************/
-/*>void WriteTextOutput(FILE *fp, ZONE *zones)
-  -------------------------------------------
-  Writes the zones out in text format
-  
-  14.11.96 Original   By: ACRM
-  06.12.96 Added check that zones have not been blanked out
-*/
-void WriteTextOutput(ZONE *zones, int *numProts)
-{
-   ZONE *z;
-   int  i = 0;
-   
-   for(z=zones; z!=NULL; NEXT(z))
-   {
-      if(z->start[0] > -9999)
-      {
-	 for(i = 0; i< *numProts; i++)
-         {
-            printf("%4d -%4d ",z->start[i],z->end[i]);
-            if (i<*numProts)
-            {
-               printf(": ");
-            }
-         }
-	 printf("\n");
-      }
-   }
+   free(filename);
 }
 
 
@@ -1486,22 +1084,50 @@ void WriteTextOutput(ZONE *zones, int *numProts)
   06.12.96 V1.1
   23.01.97 V1.2
   05.11.25 V1.8
+  16.10.26 V1.9
+  16.10.26 V1.10
+  16.10.26 V1.11
+  16.10.26 V1.12
+  16.10.26 V1.13
+  16.10.26 V1.14
+  16.10.26 V1.15
+  16.10.26 V1.16 Added -f
+  16.10.26 V1.17 Added -r and -c
+  16.10.26 V1.18
+  16.10.26 V1.19 Added -t
+  16.10.26 V1.20
+  16.10.26 V1.21 Added -m
+  16.10.26 V1.22 Added -g
+  16.10.26 V1.23
+  16.10.26 V1.24
+  16.10.26 V1.25 -p takes no file name
+  16.10.26 V1.26
+  16.10.26 V1.27 Added -k
+  16.10.26 V1.28
+  16.10.26 V1.29 Added -b and -l
+  16.10.26 V1.30 Describes findcora's own options and input rather
+                 than findcore's
 */
 void Usage(void)
 {
-   fprintf(stderr,"\nFindCore V1.8 (c) 1996-2025, Prof. Andrew C.R. \
+   fprintf(stderr,"\nFindCore V1.30 (c) 1996-2026, Prof. Andrew C.R. \
 Martin, UCL.\n");
    fprintf(stderr,"Modifications for Cora by Gabby Marsden (nee Reeves) \
            1999-2002\n");
    
-   fprintf(stderr,"\nUsage: findcore [-p out1.pdb] [-q out2.pdb] [-d \
-dcut] [-v] [-i]\n");
-   fprintf(stderr,"                ssapfile in1.pdb in2.pdb \
-[output.lis]\n");
-   fprintf(stderr,"       -p       Write in1.pdb with core flagged in \
-B-value column\n");
-   fprintf(stderr,"       -q       Write in2.pdb with core flagged in \
-B-value column\n");
+   fprintf(stderr,"\nUsage: findcora [-p] [-d dcut] [-v] [-i] [-n] \
+[-f matfit|qcp] [-r] [-c]\n");
+   fprintf(stderr,"                [-m pairs|centroid] [-g] [-t \
+nthreads] [-k cachedir] corafile\n");
+   fprintf(stderr,"       findcora [-p] [-d dcut] [-v] [-i] [-n] \
+[-f matfit|qcp] [-r] [-c]\n");
+   fprintf(stderr,"                [-m pairs|centroid] [-g] [-t \
+nthreads] [-k cachedir]\n");
+   fprintf(stderr,"                [-l mbytes] -b manifest\n");
+   fprintf(stderr,"       -p       Write each PDB file with core \
+flagged in B-value column\n");
+   fprintf(stderr,"                to the same name with %s \
+appended\n", COREEXT);
    fprintf(stderr,"       -d       Specify distance cutoff for defining \
 core [%f]\n",DEFAULT_CUT);
    fprintf(stderr,"       -v       Verbose mode; shows intermediate \
@@ -1512,14 +1138,46 @@ remove any pairs\n");
    fprintf(stderr,"       -n       Include non-E/H regions which match \
 in the initial\n");
    fprintf(stderr,"                definition of core zones\n");
-   fprintf(stderr,"       ssapfile A vertical alignment file from \
-SSAP\n");
+   fprintf(stderr,"       -f       Fitting method: matfit (BiopLib \
+blMatfit(), the default)\n");
+   fprintf(stderr,"                or qcp (quaternion characteristic \
+polynomial)\n");
+   fprintf(stderr,"       -r       Reduced precision. Hold coordinates \
+and test distances in\n");
+   fprintf(stderr,"                single precision\n");
+   fprintf(stderr,"       -c       As -r but also find the core in \
+double precision and list\n");
+   fprintf(stderr,"                any zones which differ on \
+stderr\n");
+   fprintf(stderr,"       -m       Deviation test: pairs (every pair \
+of structures within\n");
+   fprintf(stderr,"                dcut, the default) or centroid \
+(every structure within\n");
+   fprintf(stderr,"                dcut of the centroid)\n");
+   fprintf(stderr,"       -g       Fit the structures to their mean \
+rather than to the\n");
+   fprintf(stderr,"                first structure\n");
+   fprintf(stderr,"       -t       Number of threads to use for \
+reading, fitting and\n");
+   fprintf(stderr,"                writing the structures [1]\n");
+   fprintf(stderr,"       -k       Keep the C-alphas of the PDB files in \
+a binary cache in\n");
+   fprintf(stderr,"                this directory, so later runs needn't \
+parse them\n");
+   fprintf(stderr,"       -b       Run each CORA file listed in this \
+file (- for stdin); see\n");
+   fprintf(stderr,"                below\n");
+   fprintf(stderr,"       -l       Memory for keeping structures between \
+batch jobs, in\n");
+   fprintf(stderr,"                Mbytes [%d]\n", STRCACHE_DEFAULTMB);
+   fprintf(stderr,"       corafile A multiple structure alignment file \
+from CORA\n");
    
    fprintf(stderr,"\nFindCora defines a protein structurally conserved \
 core according to the\n");
    fprintf(stderr,"method of Chothia (1996). Structurally equivalent \
 secondary structure\n");
-   fprintf(stderr,"regions (defined by SSAP) are fitted. Residues are \
+   fprintf(stderr,"regions (defined by CORA) are fitted. Residues are \
 added at the end\n");
    fprintf(stderr,"of each region while the CA-deviation is less than \
 dcut and the fitting\n");
@@ -1530,198 +1188,17 @@ insertion codes in\n");
    fprintf(stderr,"the PDB files. This is a limitation imposed by \
 SSAP.\n\n");
    
-   fprintf(stderr,"The PDB files should be given in the same order as \
-the columns appear\n");
-   fprintf(stderr,"in the SSAP file.\n\n");
-}
-
-
-/************************************************************************/
-/*>ZONE *MergeZones(ZONE *zones, int numProts)
-  -------------------------------------------
-  Merges zones in the zone linked list of they overlap and removes zones
-  which are subsets of other zones
-  
-  14.11.96 Original   By: ACRM
-  06.12.96 Removes zones marked for deletion
-  13.03.97 Added merging of abutting zones (required since change to
-           zone creation where residues not added to a zone if they
-           are already in another zone stops them from being subsets)
-  26.06.02 Generalized for multiple structures
-           Fixed bug in deleting zones
-*/
-ZONE *MergeZones(ZONE *zones, int numProts)
-{
-   ZONE *z, *zt;
-   BOOL finished = FALSE,
-        doit;
-   int  i;
-   
-   /* Remove null zones                                                 */
-   while(zones->start[0] < -9998)
-      zones = zones->next;
-   for(z=zones;z!=NULL;NEXT(z))
-   {
-      if(z->start[0] < -9998)
-      {
-         ZONE *prev;
-         
-         z->prev->next = z->next;
-         if(z->next != NULL)
-            z->next->prev = z->prev;
-         prev = z->prev;
-         free(z);
-         z = prev;
-      }
-   }
-   
-   /* First merge overlapping zones                                     */
-   while(!finished)
-   {
-      finished = TRUE;
-      for(z=zones; z->next!=NULL; NEXT(z))
-      {
-         /* For each structure, see if the end of a zone overlaps the 
-            start of a following zone
-         */
-         for(i=0, doit=FALSE; i<numProts; i++)
-         {
-            if(z->end[i] >= z->next->start[i])
-            {
-               doit = TRUE;
-               break;
-            }
-         }
-         
-         if(doit)  /* There was a zone overlap                          */
-         {
-            /* For each structure, check that the end of the zone doesn't
-               already equal the end of the following zone. If there
-               weren't any such cases, then we will merge zones.
-            */
-            for(i=0, doit=TRUE; i<numProts; i++)
-            {
-               if(z->end[i] == z->next->end[i])
-               {
-                  doit = FALSE;
-                  break;
-               }
-            }
-            
-            if(doit) /* The zone didn't already span the following zone */
-            {
-               finished = FALSE;
-               for(i=0; i<numProts; i++)
-               {
-                  z->end[i] = z->next->end[i];
-               }
-            }
-         }
-      }
-   }
-   
-   /* Now remove redundant zones                                        */
-   finished = FALSE;
-   while(!finished)
-   {
-      finished = TRUE;
-      for(z=zones; z!=NULL; NEXT(z))
-      {
-         if(SubsetZone(z, zones))
-         {
-            if(z==zones)
-            {
-               zones=zones->next;
-               zones->prev=NULL;
-            }
-            else
-            {
-               z->prev->next = z->next;
-               if(z->next != NULL)
-                  z->next->prev = z->prev;
-            }
-            zt=z->prev;
-            free(z);
-            z=zt;
-            
-            finished = FALSE;
-            break;
-         }
-      }
-   }
-   
-   /* Now merge abutting zones                                          */
-   finished = FALSE;
-   while(!finished)
-   {
-      finished = TRUE;
-      for(z=zones; z->next!=NULL; NEXT(z))
-      {
-         /* See if this zone abutts the next zone. Assume that it does,
-            then check through each structure to see if there is a 
-            mismatch
-         */
-         for(i=0, doit=TRUE; i<numProts; i++)
-         {
-            if(z->end[i]+1 != z->next->start[i])
-            {
-               doit = FALSE;
-               break;
-            }
-         }
-         
-         if(doit) /* If the zones were abutting                         */
-         {
-            /* Reset start of second zone to start of first zone        */
-            for(i=0; i<numProts; i++)
-            {
-               z->next->start[i] = z->start[i];
-            }
-            
-            /* Remove z from the linked list                            */
-            if(z==zones)
-            {
-               zones=zones->next;
-               zones->prev=NULL;
-            }
-            else
-            {
-               if(z->prev != NULL) z->prev->next = z->next;
-               if(z->next != NULL)
-                  z->next->prev = z->prev;
-            }
-            zt=z->prev;
-            free(z);
-            z=zt;
-            
-            finished = FALSE;
-         }
-      }
-   }
-   
-   return(zones);
-}
+   fprintf(stderr,"The PDB files are read from the structure names \
+given in the CORA file.\n\n");
 
-/************************************************************************/
-/*>BOOL SubsetZone(ZONE *z, ZONE *zones)
-  -------------------------------------
-  Sees whether a zones is a zubset of another zone
-  
-  14.11.96 Original   By: ACRM
-*/
-BOOL SubsetZone(ZONE *z, ZONE *zones)
-{
-   ZONE *z1;
-   
-   for(z1=zones; z1!=NULL; NEXT(z1))
-   {
-      if(z1 != z)
-      {
-         if((z->start[0] >= z1->start[0]) &&
-            (z->end[0]   <= z1->end[0]))
-            return(TRUE);
-      }
-   }
-   
-   return(FALSE);
+   fprintf(stderr,"With -b, each line of the manifest is a job:\n");
+   fprintf(stderr,"   corafile [dcut]\n");
+   fprintf(stderr,"A - for dcut gives the cutoff from -d. Blank lines \
+and lines starting with\n");
+   fprintf(stderr,"# are ignored. Each job's output is headed by \
+'Job n: corafile'. Structures\n");
+   fprintf(stderr,"are kept between jobs, within the memory given by \
+-l, and read again if\n");
+   fprintf(stderr,"the file changes. With -v the use made of them is \
+reported at the end.\n\n");
 }
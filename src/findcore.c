@@ -3,12 +3,12 @@
    Program:    findcore
    File:       findcore.c
    
-   Version:    V1.5
-   Date:       05.11.25
+   Version:    V1.24
+   Date:       16.10.26
    Function:   Find core from 2 structures given the SSAP alignment
                file as a staring point
    
-   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2025
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
    Author:     Prof. Andrew C. R. Martin
    Address:    Biomolecular Structure & Modelling Unit,
                Department of Biochemistry & Molecular Biology,
@@ -46,40 +46,203 @@
                   wasn't already in a zone.
    V1.4  26.06.02 Fixed bug in freeing zones in MergeZone()
    V1.5  05.11.25 Updated for new BiopLib
+   V1.6  16.10.26 Fitting now keeps running sums over the core pairs and
+                  updates them as pairs are added or removed rather than
+                  rebuilding the fitted set on every iteration
+   V1.7  16.10.26 The core loop works on compact arrays of C-alpha
+                  coordinates and core flags rather than walking copies
+                  of the PDB linked lists
+   V1.8  16.10.26 Zone boundaries are found through a residue number
+                  lookup table rather than by scanning the structure
+   V1.9  16.10.26 Zones are held in a contiguous array shared with findcora
+                  (zonelist.c). MergeZones() no longer restarts after
+                  every deletion and no longer crashes when the first
+                  zone is merged or when every zone has been cut
+   V1.10 16.10.26 Core membership is held as a bitset in the C-alpha
+                  store. Zone runs are checked and the core counted a
+                  word at a time
+   V1.11 16.10.26 Each fit just records a transform for the mobile
+                  C-alphas. Added -s to write in2.pdb fitted onto
+                  in1.pdb; the whole structure is moved once, at the end
+   V1.12 16.10.26 Distance checks when extending and cutting zones are
+                  done a block of positions at a time (distkern.c),
+                  using AVX-512 or AVX where the CPU has them
+   V1.13 16.10.26 Added -f to choose between blMatfit() and QCP for the
+                  fitting. Verbose mode reports the final core RMSD
+   V1.14 16.10.26 Added -r to hold the C-alpha coordinates and do the
+                  distance checks in single precision (the fitting sums
+                  are still double) and -c to also find the core in
+                  double precision and report any zones which differ
+   V1.15 16.10.26 The cut, zone extension and fitting are shared with
+                  findcora (coreeng.c)
+   V1.16 16.10.26 SetBValByZone() moved to zonelist.c for findcora
+   V1.17 16.10.26 The two PDB files are read at the same time (pdbload.c)
+   V1.18 16.10.26 Added -k to keep the C-alphas of the PDB files in a
+                  binary cache
+   V1.19 16.10.26 Added -b to run a manifest of jobs in one process and
+                  -t to run them on several threads
+   V1.20 16.10.26 Added -a to read a list of structures once and find
+                  the core of every pair, or of the pairs in a manifest
+   V1.21 16.10.26 Added -u to run as a server taking jobs over a Unix
+                  domain socket and keeping the structures it has read
+   V1.22 16.10.26 The SSAP reading and core definition are done by
+                  libfindcore. Settings used by the library are held
+                  in its options rather than in globals
+   V1.23 16.10.26 Batch jobs take their structures from an in-memory
+                  cache with a memory budget (strcache.c), which also
+                  replaces the server's own store of structures. Added
+                  -l to set the budget
+   V1.24 16.10.26 -d takes a list or range of cutoffs. The structures
+                  and SSAP zones are read once and the core is found
+                  for each cutoff in parallel. Added -w to start each
+                  from the core found at the cutoff below
 
 *************************************************************************/
 /* Includes
 */
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include "bioplib/SysDefs.h"
 #include "bioplib/MathType.h"
 #include "bioplib/pdb.h"
 #include "bioplib/general.h"
 #include "bioplib/macros.h"
 #include "bioplib/fit.h"
-#include "bioplib/fsscanf.h"
+#include "corefit.h"
+#include "castore.h"
+#include "zonelist.h"
+#include "coreeng.h"
+#include "distkern.h"
+#include "pdbload.h"
+#include "libfindcore.h"
+#include "strcache.h"
 
 /************************************************************************/
 /* Defines and macros
 */
-#define MAXITER 1000
 #define MAXBUFF 160
 #define DEFAULT_CUT ((REAL)3.0)
-typedef struct _zone
+
+#define BATCH_CHUNK  64      /* Batch jobs read and run at a time       */
+#define BATCH_LINE   1024    /* Longest manifest line                   */
+#define BATCH_FIELDS 7       /* Most fields in a manifest line          */
+#define BATCH_COPY   8192    /* Buffer for copying batch output         */
+
+#define SWEEP_MAXCUTS 100    /* Most cutoffs in a -d list or range      */
+
+/* One set of inputs and outputs. In batch mode the zones and errors go
+   to temporary files, nout and nerr bytes of which have been written.
+*/
+typedef struct
+{
+   int  id,                  /* Job number                              */
+        status;              /* Exit status of the job                  */
+   char ssapfile[MAXBUFF],
+        pdbfile1[MAXBUFF],
+        pdbfile2[MAXBUFF],
+        outfile[MAXBUFF],    /* Output listing file (or blank)          */
+        outpdb1[MAXBUFF],    /* Output PDB files (or blank)             */
+        outpdb2[MAXBUFF];
+   REAL dcut;
+   FILE *outfp,              /* Where the zones go without an outfile   */
+        *errfp;              /* Where errors go                         */
+   long nout,
+        nerr;
+   PDB  *shared[2];          /* Structures already read (or NULL)       */
+   STRCACHE *cache;          /* Where to get the structures (or NULL)   */
+   REAL seedcut;             /* Cutoff of the core the zones start from
+                                (0 for the SSAP zones)                  */
+}  COREJOB;
+
+/* Structures read once for an all-vs-all run                           */
+typedef struct
+{
+   char *name;               /* PDB file as given in the list           */
+   PDB  *pdb;
+}  STRUCTURE;
+
+typedef struct
+{
+   int       nstruc;
+   STRUCTURE *struc,         /* In list order                           */
+             **byName;       /* Sorted by name for FindStructure()      */
+}  STRUCTLIST;
+
+/* Where batch jobs come from: a manifest or, if fp is NULL, every
+   pair of structures in structs with their alignments in ssapdir
+*/
+typedef struct
+{
+   FILE       *fp;
+   char       *manifest;     /* Its name                                */
+   REAL       dcut;          /* Cutoff for jobs which don't give one    */
+   int        nline,         /* Lines read                              */
+              njobs;         /* Jobs read                               */
+   BOOL       bad;           /* A line couldn't be read as a job        */
+   STRUCTLIST *structs;      /* Structures already read (or NULL)       */
+   char       *structfile,   /* Where they were listed                  */
+              *ssapdir;      /* Directory of SSAP files for every pair  */
+   int        pair1, pair2;  /* Next pair                               */
+}  BATCHREAD;
+
+typedef struct
+{
+   int             listenfd;
+   REAL            dcut;     /* Cutoff for jobs which don't give one    */
+   BOOL            quit;
+   pthread_mutex_t lock;     /* Guards quit and the connections         */
+   STRCACHE        *cache;   /* Structures kept between jobs            */
+}  CORESERVER;
+
+/* A run over several cutoffs. order[] lists the jobs by increasing
+   cutoff and is split into nchain chains run in parallel, chain c
+   being order[start[c]] to order[start[c+1]-1]. With warm set each job
+   in a chain starts from the core found by the one before.
+*/
+typedef struct
+{
+   COREJOB  *jobs;           /* One job per cutoff                      */
+   PDB      *pdb[2];         /* The structures (shared by the jobs)     */
+   ZONELIST *seed;           /* Zones from the SSAP file                */
+   int      *order,
+            *start,
+            nchain;
+   BOOL     warm;
+}  CORESWEEP;
+
+/* A thread taking connections. connfd is the one it is serving (or -1)
+   so that it can be shut down when the server stops.
+*/
+typedef struct
 {
-   struct _zone *next, *prev;
-   int start[2], 
-       end[2];
-}  ZONE;
+   CORESERVER *server;
+   pthread_t  thread;
+   int        connfd;
+}  SERVERTHREAD;
 
 /************************************************************************/
 /* Globals
 */
 BOOL gVerbose      = FALSE,
-     gInitialCut   = FALSE,
-     gDoRandomCoil = FALSE;
+     gSuperpose    = FALSE,
+     gCheckSingle  = FALSE,
+     gWarmStart    = FALSE;
+int  gThreads      = 1,
+     gCacheMB      = STRCACHE_DEFAULTMB,
+     gNCuts        = 1;
+REAL gCuts[SWEEP_MAXCUTS];   /* Cutoffs given with -d                   */
+FCOPTIONS gOptions;          /* Settings for libfindcore                */
 
 /************************************************************************/
 /* Prototypes
@@ -87,23 +250,40 @@ BOOL gVerbose      = FALSE,
 int main(int argc, char **argv);
 BOOL ParseCmdLine(int argc, char **argv, char *ssapfile, char *pdbfile1,
                   char *pdbfile2, char *outfile, char *outpdb1, 
-                  char *outpdb2, REAL *dcut);
-int strlen_nospace(char *str);
-ZONE *ReadSSAP(FILE *fp);
-BOOL DefineCore(FILE *outfp, PDB *pdb1, PDB *pdb2, ZONE *zones, REAL dcut);
-void UpdateBValues(PDB **idx1, int natom1, PDB **idx2, int natom2,
-                   ZONE *zones, REAL cutsq);
-void SetBValByZone(PDB *pdb, ZONE *zones, int which);
-BOOL FitCaPDBBFlag(PDB *ref_pdb, PDB *fit_pdb, REAL rm[3][3]);
-int CountCore(PDB *pdb);
-PDB *DupeCAByBVal(PDB *pdb);
+                  char *outpdb2, REAL *dcut, char *manifest,
+                  char *structfile, char *socketpath);
+int RunJob(COREJOB *job, THREADPOOL *pool);
+int FindJobCore(COREJOB *job, FILE *outfp, PDB **pdb, ZONELIST *zones);
+int RunSweep(COREJOB *job, REAL *cuts, int ncut);
+void SweepTask(void *arg, int c);
+int ParseCutoffs(char *arg, REAL *cuts, int maxcuts);
+int RunBatch(char *manifest, char *structfile, char *ssapdir,
+             REAL dcut);
+int ReadJobs(BATCHREAD *br, COREJOB *jobs, int maxjobs);
+BOOL ParseJob(char **field, int nfield, COREJOB *job, REAL dcut);
+int PairJobs(BATCHREAD *br, COREJOB *jobs, int maxjobs);
+int SplitLine(char *buffer, char **field, int maxfield);
+STRUCTLIST *ReadStructList(char *structfile, THREADPOOL *pool);
+void FreeStructList(STRUCTLIST *sl);
+PDB *FindStructure(STRUCTLIST *sl, char *name);
+int CompareStructNames(const void *a, const void *b);
+void JobTask(void *arg, int i);
+void CopyJobOutput(COREJOB *job);
+void CopyBytes(FILE *from, long nbytes, FILE *to);
+int RunServer(char *socketpath, REAL dcut);
+int OpenServerSocket(char *socketpath);
+BOOL StaleSocket(struct sockaddr_un *addr);
+void *ServerThread(void *arg);
+void ServeClient(CORESERVER *server, int fd, FILE *outfp, FILE *errfp);
+int RunCachedJob(COREJOB *job);
+BOOL DefineCore(FILE *outfp, FILE *errfp, PDB *pdb1, PDB *pdb2,
+                ZONELIST *zones, REAL dcut, BOOL single, BOOL verbose,
+                BOOL superpose);
+void ReportCut(void *arg, ZONELIST *zones);
 void Usage(void);
-void WriteTextOutput(FILE *fp, ZONE *zones);
-BOOL SubsetZone(ZONE *z, ZONE *zones);
-ZONE *MergeZones(ZONE *zones);
-BOOL DoCut(PDB **idx1, int natom1, PDB **idx2, int natom2,
-           ZONE *zones, REAL cutsq);
-
+void WriteTextOutput(FILE *fp, ZONELIST *zones);
+ZONELIST *DoubleCore(FILE *errfp, PDB *pdb1, PDB *pdb2, ZONELIST *zones,
+                     REAL dcut);
 
 
 /************************************************************************/
@@ -112,122 +292,52 @@ BOOL DoCut(PDB **idx1, int natom1, PDB **idx2, int natom2,
    Main program for core defining
 
    14.11.96 Original   By: ACRM
+   16.10.26 Added the single precision check
+   16.10.26 The PDB files are read in parallel
+   16.10.26 The work is done by RunJob(). Added batch mode
+   16.10.26 Added all-vs-all mode
+   16.10.26 Added server mode
+   16.10.26 Sets up the library options
+   16.10.26 Runs a sweep for more than one cutoff
 */
 int main(int argc, char **argv)
 {
-   char ssapfile[MAXBUFF],
-        pdbfile1[MAXBUFF],
-        pdbfile2[MAXBUFF],
-        outfile[MAXBUFF],
-        outpdb1[MAXBUFF],
-        outpdb2[MAXBUFF];
-   FILE *ssapfp,
-        *pdb1fp,
-        *pdb2fp,
-        *outfp = stdout;
-   REAL dcut = DEFAULT_CUT;
-   PDB  *pdb1,
-        *pdb2;
-   int  natoms;
-   ZONE *zones;
-
-   if(ParseCmdLine(argc, argv, ssapfile,pdbfile1,pdbfile2,outfile,
-                   outpdb1,outpdb2,&dcut))
-   {
-      /* Open files                                                     */
-      if((ssapfp=fopen(ssapfile,"r"))==NULL)
-      {
-         fprintf(stderr,"Unable to open %s for reading\n",ssapfile);
-         return(1);
-      }
-      if((pdb1fp=fopen(pdbfile1,"r"))==NULL)
-      {
-         fprintf(stderr,"Unable to open %s for reading\n",pdbfile1);
-         return(1);
-      }
-      if((pdb2fp=fopen(pdbfile2,"r"))==NULL)
-      {
-         fprintf(stderr,"Unable to open %s for reading\n",pdbfile2);
-         return(1);
-      }
-      if(outfile[0])
-      {
-         if((outfp = fopen(outfile,"w"))==NULL)
-         {
-            fprintf(stderr,"Unable to open %s for writing\n",outfile);
-            return(1);
-         }
-      }
+   COREJOB    job;
+   THREADPOOL *pool;
+   char       manifest[MAXBUFF],
+              structfile[MAXBUFF],
+              socketpath[MAXBUFF];
+   int        status;
+
+   job.dcut = DEFAULT_CUT;
+   fcDefaultOptions(&gOptions);
+   if(ParseCmdLine(argc, argv, job.ssapfile, job.pdbfile1, job.pdbfile2,
+                   job.outfile, job.outpdb1, job.outpdb2, &job.dcut,
+                   manifest, structfile, socketpath))
+   {
+      if(socketpath[0])
+         return(RunServer(socketpath, job.dcut));
 
-      /* Read data from the files                                       */
-      if((pdb1 = blReadPDB(pdb1fp,&natoms)) == NULL)
-      {
-         fprintf(stderr,"No atoms read from PDB file: %s\n",pdbfile1);
-         return(1);
-      }
-      fclose(pdb1fp);
-      if((pdb2 = blReadPDB(pdb2fp,&natoms)) == NULL)
-      {
-         fprintf(stderr,"No atoms read from PDB file: %s\n",pdbfile2);
-         return(1);
-      }
-      fclose(pdb2fp);
-      if((zones = ReadSSAP(ssapfp))==NULL)
-      {
-         fprintf(stderr,"No zones read from SSAP file: %s\n",ssapfile);
-         return(1);
-      }
-      fclose(ssapfp);
+      /* With -a and no manifest, ssapfile is the SSAP directory        */
+      if(manifest[0] || structfile[0])
+         return(RunBatch(manifest, structfile, job.ssapfile, job.dcut));
 
-      /* Print the current zones if required                            */
-      if(gVerbose)
-      {
-         fprintf(outfp,"SSAP Zones:\n");
-         WriteTextOutput(outfp, zones);
-      }
+      job.id        = 1;
+      job.outfp     = stdout;
+      job.errfp     = stderr;
+      job.shared[0] = job.shared[1] = NULL;
+      job.cache     = NULL;
+      job.seedcut   = (REAL)0.0;
 
-      /* Now call the routine to do the core definition                 */
-      DefineCore(outfp, pdb1, pdb2, zones, dcut);
-      
-      if(gVerbose)
-      {
-         fprintf(outfp,"\nCore before zone merging:\n");
-         WriteTextOutput(outfp, zones);
-      }
-      
-      /* Now remove any zones which are subsets of other zones and merge
-         overlapping zones
-      */
-      zones = MergeZones(zones);
-      
-      /* Finally write the output file which lists residues in the 
-         structural core and optionally write PDB files with the cores
-         flagged
-      */
-      if(gVerbose)
-         fprintf(outfp,"\nFinal Zones:\n");
-      WriteTextOutput(outfp, zones);
+      if(gNCuts > 1)
+         return(RunSweep(&job, gCuts, gNCuts));
 
-      if(outpdb1[0])
-      {
-         if((pdb1fp=fopen(outpdb1,"w"))==NULL)
-         {
-            fprintf(stderr,"Unable to open %s for writing\n",outpdb1);
-            return(1);
-         }
-         SetBValByZone(pdb1, zones, 0);
-         blWritePDB(pdb1fp, pdb1);
-      }
-      if(outpdb2[0])
-      {
-         if((pdb2fp=fopen(outpdb2,"w"))==NULL)
-         {
-            fprintf(stderr,"Unable to open %s for writing\n",outpdb2);
-            return(1);
-         }
-         SetBValByZone(pdb2, zones, 1);
-         blWritePDB(pdb2fp, pdb2);
-      }
+      /* Read the two structures at the same time                       */
+      pool   = NewThreadPool(2);
+      status = RunJob(&job, pool);
+      FreeThreadPool(pool);
+
+      return(status);
    }
    else
    {
@@ -239,774 +349,1983 @@ int main(int argc, char **argv)
 
 
 /************************************************************************/
-/*>BOOL ParseCmdLine(int argc, char **argv, char *ssapfile, 
-                     char *pdbfile1, char *pdbfile2, char *outfile, 
-                     char *outpdb1, char *outpdb2, REAL *dcut)
-   ----------------------------------------------------------------
-   Input:   int    argc         Argument count
-            char   **argv       Argument array
-   Output:  char   *ssapfile    Input SSAP file               
-            char   *pdbfile1    First input PDB file
-            char   *pdbfile2    Second input PDB file
-            char   *outfile     Output listing file (or blank string)
-            char   *outpdb1     Output first PDB file (or blank string)
-            char   *outpdb2     Output second PDB file (or blank string)
-            REAL   *dcut        Cutoff for defining core
-   Returns: BOOL                Success?
-
-   Parse the command line
-   
-   14.11.96 Original    By: ACRM
-   06.12.96 Added -i
-   23.01.97 Added -n
+/*>int RunJob(COREJOB *job, THREADPOOL *pool)
+   ------------------------------------------
+   Input:   COREJOB    *job     The job
+            THREADPOOL *pool    Threads for reading the PDB files (may
+                                be NULL)
+   Returns: int                 Exit status (0 for success)
+
+   Reads the files for one job, finds the core and writes it out.
+   Everything the job opens or reads is freed again. Structures in
+   job->shared are used instead of reading the PDB files.
+
+   16.10.26 Original (from main())   By: ACRM
+   16.10.26 Added job->shared
 */
-BOOL ParseCmdLine(int argc, char **argv, char *ssapfile, char *pdbfile1,
-                  char *pdbfile2, char *outfile, char *outpdb1, 
-                  char *outpdb2, REAL *dcut)
+int RunJob(COREJOB *job, THREADPOOL *pool)
 {
-   argc--;
-   argv++;
-
-   ssapfile[0] = pdbfile1[0] = pdbfile2[0] = 
-      outfile[0] = outpdb1[0] = outpdb2[0] = '\0';
+   FILE     *ssapfp,
+            *outfp = job->outfp;
+   char     *pdbfiles[2];
+   PDB      *pdb[2];
+   int      natoms[2],
+            i,
+            status = 0;
+   ZONELIST *zones = NULL;
+
+   /* Open files                                                        */
+   if((ssapfp=fopen(job->ssapfile,"r"))==NULL)
+   {
+      fprintf(job->errfp,"Unable to open %s for reading\n",
+              job->ssapfile);
+      return(1);
+   }
+   if(job->outfile[0])
+   {
+      if((outfp = fopen(job->outfile,"w"))==NULL)
+      {
+         fprintf(job->errfp,"Unable to open %s for writing\n",
+                 job->outfile);
+         fclose(ssapfp);
+         return(1);
+      }
+   }
 
-   if(argc==0)
-      return(FALSE);
-   
-   while(argc)
+   /* Read the structures. Only the C-alphas are needed unless the
+      structures are being written out.
+   */
+   pdbfiles[0] = job->pdbfile1;
+   pdbfiles[1] = job->pdbfile2;
+   if(job->shared[0] != NULL)
    {
-      if(argv[0][0] == '-')
+      pdb[0]    = job->shared[0];
+      pdb[1]    = job->shared[1];
+      natoms[0] = natoms[1] = 0;
+   }
+   else
+   {
+      LoadPDBFiles(pdbfiles, 2, (!job->outpdb1[0] && !job->outpdb2[0]),
+                   gOptions.cachedir, pdb, natoms, pool);
+   }
+   for(i=0; (i<2) && !status; i++)
+   {
+      if(natoms[i] == PDBLOAD_NOFILE)
       {
-         switch(argv[0][1])
-         {
-         case 'd':
-            argc--;
-            argv++;
-            sscanf(argv[0],"%lf",dcut);
-            break;
-         case 'p':
-            argc--;
-            argv++;
-            strcpy(outpdb1, argv[0]);
-            break;
-         case 'q':
-            argc--;
-            argv++;
-            strcpy(outpdb2, argv[0]);
-            break;
-         case 'v':
-            gVerbose = TRUE;
-            break;
-         case 'i':
-            gInitialCut = TRUE;
-            break;
-         case 'n':
-            gDoRandomCoil = TRUE;
-            break;
-         default:
-            return(FALSE);
-            break;
-         }
+         fprintf(job->errfp,"Unable to open %s for reading\n",
+                 pdbfiles[i]);
+         status = 1;
       }
-      else
+      else if(pdb[i] == NULL)
       {
-         /* Check that there are only 3 or 4 arguments left             */
-         if(argc < 3 || argc > 4)
-            return(FALSE);
-         
-         /* Copy the first three                                        */
-         strcpy(ssapfile, argv[0]);
-         strcpy(pdbfile1, argv[1]);
-         strcpy(pdbfile2, argv[2]);
-         
-         /* If there's another, copy it to outfile                      */
-         argc -= 3;
-         argv += 3;
-         if(argc)
-            strcpy(outfile, argv[0]);
-            
-         return(TRUE);
+         fprintf(job->errfp,"No atoms read from PDB file: %s\n",
+                 pdbfiles[i]);
+         status = 1;
       }
-      argc--;
-      argv++;
    }
-   
-   return(TRUE);
-}
-
-
-/************************************************************************/
-/*>int strlen_nospace(char *str)
-   -----------------------------
-   Find the length of a string without any leading or trailing spaces
-
-   14.11.96 Original   By: ACRM
-*/
-int strlen_nospace(char *str)
-{
-   char *s,
-        *e;
-   int  str_len;
-   
-   for(s=str; *s==' ' || *s=='\t'; s++);
-   str_len = strlen(s);
-   for(e=s+str_len-1; *e==' ' || *e=='\t'; e--)
-      str_len--;
-   return(str_len);
-}
-
-   
-/************************************************************************/
-/*>ZONE *ReadSSAP(FILE *fp)
-   ------------------------
-   Read a SSAP alignment file into a set of zones showing residue
-   equivalences
-
-   14.11.96 Original   By: ACRM
-   23.01.97 Added gDoRandomCoil checking; swapped the logic round for
-            checking secondary structure matches to make this easier.
-*/
-ZONE *ReadSSAP(FILE *fp)
-{
-   ZONE *zones = NULL,
-        *z;
-   int  resnum1, resnum2,
-        score,
-        start1 = 0, start2 = 0,
-        end1 = 0,   end2 = 0;
-   char buffer[MAXBUFF],
-        aa1, aa2, str1, str2;
-   
 
-   while(fgets(buffer,MAXBUFF,fp))
+   /* Read data from the SSAP file                                      */
+   if(!status && (fcReadSSAP(&gOptions, ssapfp, &zones) != FC_OK))
    {
-      TERMINATE(buffer);
-      if(strlen_nospace(buffer))
-      {
-/* For older SSAP with no insert codes
-         fsscanf(buffer,"%3d%1x%c%1x%c%2x%3d%2x%c%1x%c%1x%3d",
-                 &resnum1, &str1, &aa1,
-                 &score,
-                 &aa2, &str2, &resnum2);
-*/
-         fsscanf(buffer,"%3d%1x%c%3x%c%2x%3d%2x%c%3x%c%1x%3d",
-                 &resnum1, &str1, &aa1,
-                 &score,
-                 &aa2, &str2, &resnum2);
+      fprintf(job->errfp,"No zones read from SSAP file: %s\n",
+              job->ssapfile);
+      status = 1;
+   }
 
+   if(!status)
+      status = FindJobCore(job, outfp, pdb, zones);
 
-         /* If neither residue is an insert and both are E or both are H 
-            or the -n flag has been set and neither are E or H then we
-            are in a zone so record this fact
-         */
-         if((aa1 != ' ') && (aa2 != ' ') &&
-            (((str1 == 'E') && (str2 == 'E')) ||
-             ((str1 == 'H') && (str2 == 'H')) ||
-             (gDoRandomCoil &&
-              (str1 != 'E') && (str2 != 'E') &&
-              (str1 != 'H') && (str2 != 'H'))))
-         {
-            if(!start1 || !start2)
-            {
-               start1 = resnum1;
-               start2 = resnum2;
-            }
-            end1 = resnum1;
-            end2 = resnum2;
-         }
-         else /* We've come out of a zone; store the last one           */
-         {
-            if(start1 && start2)
-            {
-               if(zones==NULL)
-               {
-                  INITPREV(zones,ZONE);
-                  z=zones;
-               }
-               else
-               {
-                  ALLOCNEXTPREV(z,ZONE);
-               }
-               if(z==NULL)
-               {
-                  FREELIST(zones,ZONE);
-                  return(NULL);
-               }
-
-               z->start[0] = start1;
-               z->start[1] = start2;
-               z->end[0]   = end1;
-               z->end[1]   = end2;
-
-               start1 = start2 = 0;
-            }
-         }
-      }
+   fclose(ssapfp);
+   if(outfp != job->outfp)
+      fclose(outfp);
+   if(job->shared[0] == NULL)
+   {
+      for(i=0; i<2; i++)
+         FREELIST(pdb[i], PDB);
    }
+   if(zones != NULL)
+      FreeZoneList(zones);
 
-   return(zones);
+   return(status);
 }
 
 
 /************************************************************************/
-/*>BOOL DefineCore(FILE *outfp, PDB *pdb1, PDB *pdb2, ZONE *zones, 
-                   REAL dcut)
-   -----------------------------------------------------------------------
-   Main routine to do core definition
-
-   14.11.96 Original   By: ACRM
-   06.12.96 Added handling of gInitialCut
+/*>int FindJobCore(COREJOB *job, FILE *outfp, PDB **pdb,
+                   ZONELIST *zones)
+   -----------------------------------------------------
+   Input:   COREJOB    *job     The job
+            FILE       *outfp   Output file for the zones
+   I/O:     PDB        **pdb    The two structures
+            ZONELIST   *zones   Starting zones; the core on return
+   Returns: int                 Exit status (0 for success)
+
+   Finds the core and writes the zones and any PDB files
+
+   16.10.26 Original (from main())   By: ACRM
+   16.10.26 Labels zones which came from another cutoff
+   16.10.26 Fails if the core couldn't be found
 */
-BOOL DefineCore(FILE *outfp, PDB *pdb1, PDB *pdb2, ZONE *zones, REAL dcut)
+int FindJobCore(COREJOB *job, FILE *outfp, PDB **pdb, ZONELIST *zones)
 {
-   int  count = 0,
-        last  = 0,
-        iter  = 0,
-        natom1,
-        natom2;
-   REAL rm[3][3];
-   PDB  *pdbca1,
-        *pdbca2,
-        **idx1,
-        **idx2;
-   
-   /* Duplicate the PDB linked lists                                    */
-   if((pdbca1 = blDupePDB(pdb1)) == NULL)
-      return(FALSE);
-   if((pdbca2 = blDupePDB(pdb2)) == NULL)
+   ZONELIST *dzones = NULL;
+   FILE     *pdbfp;
+
+   /* Print the current zones if required                               */
+   if(gVerbose)
    {
-      FREELIST(pdbca1,PDB);
-      return(FALSE);
+      if(job->seedcut > (REAL)0.0)
+         fprintf(outfp,"Zones from cutoff %g:\n", job->seedcut);
+      else
+         fprintf(outfp,"SSAP Zones:\n");
+      WriteTextOutput(outfp, zones);
    }
-   
-   /* Reduce to CA only                                                 */
-   pdbca1 = blSelectCaPDB(pdbca1);
-   pdbca2 = blSelectCaPDB(pdbca2);
-   
-   SetBValByZone(pdbca1,zones,0);
-   SetBValByZone(pdbca2,zones,1);
 
-   count = CountCore(pdbca1);
+   /* If single precision is being checked, first find the core
+      from the same starting zones in double precision
+   */
+   if(gCheckSingle)
+   {
+      if((dzones = DoubleCore(job->errfp, pdb[0], pdb[1], zones,
+                              job->dcut))==NULL)
+         return(1);
+   }
 
-   if((idx1 = blIndexPDB(pdbca1, &natom1))==NULL)
+   /* Now call the routine to do the core definition. Only move the
+      second structure if it is being written out
+   */
+   if(!DefineCore(outfp, job->errfp, pdb[0], pdb[1], zones, job->dcut,
+                  gOptions.single, gVerbose,
+                  (gSuperpose && job->outpdb2[0])))
    {
-      FREELIST(pdbca1,PDB);
-      FREELIST(pdbca2,PDB);
-      return(FALSE);
+      if(dzones != NULL)
+         FreeZoneList(dzones);
+      return(1);
    }
-   if((idx2 = blIndexPDB(pdbca2, &natom2))==NULL)
+      
+   if(gVerbose)
    {
-      FREELIST(pdbca1,PDB);
-      FREELIST(pdbca2,PDB);
-      free(idx1);
-      return(FALSE);
+      fprintf(outfp,"\nCore before zone merging:\n");
+      WriteTextOutput(outfp, zones);
    }
-
-   if(gInitialCut)
+      
+   /* Now remove any zones which are subsets of other zones and merge
+      overlapping zones
+   */
+   if(!MergeZones(zones))
    {
-      FitCaPDBBFlag(pdbca1, pdbca2, rm);
-      if(!DoCut(idx1, natom1, idx2, natom2, zones, dcut*dcut))
-         return(FALSE);
-      count = CountCore(pdbca1);
+      fprintf(job->errfp,"No memory for merging zones\n");
+      if(dzones != NULL)
+         FreeZoneList(dzones);
+      return(1);
+   }
+      
+   /* Finally write the output file which lists residues in the 
+      structural core and optionally write PDB files with the cores
+      flagged
+   */
+   if(gVerbose)
+      fprintf(outfp,"\nFinal Zones:\n");
+   WriteTextOutput(outfp, zones);
+
+   if(dzones != NULL)
+   {
+      if(!ReportZoneDiffs(job->errfp, zones, "Single", dzones, "Double"))
+         fprintf(job->errfp,"Single precision zones match double \
+precision\n");
+      FreeZoneList(dzones);
+   }
 
-      if(gVerbose)
+   if(job->outpdb1[0])
+   {
+      if((pdbfp=fopen(job->outpdb1,"w"))==NULL)
       {
-         fprintf(outfp,"\nCore after removing residues > 3.0A:\n");
-         WriteTextOutput(outfp, zones);
+         fprintf(job->errfp,"Unable to open %s for writing\n",
+                 job->outpdb1);
+         return(1);
       }
+      SetBValByZone(pdb[0], zones, 0);
+      blWritePDB(pdbfp, pdb[0]);
+      fclose(pdbfp);
    }
-   
-   iter=0;
-   while(last != count)
-   {
-      FitCaPDBBFlag(pdbca1, pdbca2, rm);
-      UpdateBValues(idx1, natom1, idx2, natom2, zones, dcut*dcut);
-      last = count;
-      count = CountCore(pdbca1);
-      if(++iter > MAXITER)
+   if(job->outpdb2[0])
+   {
+      if((pdbfp=fopen(job->outpdb2,"w"))==NULL)
       {
-         fprintf(stderr,"Warning: Maximum number of iterations (%d) \
-exceeded!\n",MAXITER);
-         break;
+         fprintf(job->errfp,"Unable to open %s for writing\n",
+                 job->outpdb2);
+         return(1);
       }
+      SetBValByZone(pdb[1], zones, 1);
+      blWritePDB(pdbfp, pdb[1]);
+      fclose(pdbfp);
    }
-   
-   free(idx1);
-   free(idx2);
 
-   return(TRUE);
+   return(0);
 }
 
-/************************************************************************/
-/*>BOOL DoCut(PDB **idx1, int natom1, PDB **idx2, int natom2,
-              ZONE *zones, REAL cutsq)
-   ----------------------------------------------------------
-   Performs the initial cut of pairs which deviate by >3.0A
 
-   06.12.96 Original   By: ACRM
+/************************************************************************/
+/*>int RunSweep(COREJOB *job, REAL *cuts, int ncut)
+   ------------------------------------------------
+   Input:   COREJOB    *job     The job (its dcut is ignored)
+            REAL       *cuts    Cutoffs to find the core at
+            int        ncut     Number of cutoffs
+   Returns: int                 Exit status (0 if every cutoff worked)
+
+   Finds the core at each cutoff. The structures and the SSAP zones are
+   read once and shared; each cutoff is then a job of its own, run
+   gThreads at a time with its zones and errors going to temporary
+   files. These are copied out in the order the cutoffs were given,
+   each block headed by 'Cutoff dcut:'.
+
+   With gWarmStart the cutoffs are taken in increasing order in up to
+   gThreads chains and each starts from the core found at the one
+   before it in its chain rather than from the SSAP zones. Every chain
+   has at least two cutoffs, since the first in a chain starts cold.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Warm start chains have at least two cutoffs, so that -w
+            does something however many threads there are
 */
-BOOL DoCut(PDB **idx1, int natom1, PDB **idx2, int natom2,
-           ZONE *zones, REAL cutsq)
+int RunSweep(COREJOB *job, REAL *cuts, int ncut)
 {
-   ZONE *z, *zend, *znext;
-   int  i, j,
-        start1, end1,
-        start2, end2;
-   BOOL split,
-        ok;
-   
-   for(z=zones; z!=NULL; NEXT(z))
+   FILE       *ssapfp,
+              *outfp  = job->outfp,
+              *from[2],
+              *to[2];
+   CORESWEEP  sweep;
+   THREADPOOL *pool;
+   char       *pdbfiles[2];
+   long       nbytes[2];
+   int        natoms[2],
+              i, j, t,
+              status  = 0;
+
+   /* Read the structures and zones once                                */
+   if((ssapfp=fopen(job->ssapfile,"r"))==NULL)
+   {
+      fprintf(job->errfp,"Unable to open %s for reading\n",
+              job->ssapfile);
+      return(1);
+   }
+
+   sweep.seed   = NULL;
+   sweep.pdb[0] = sweep.pdb[1] = NULL;
+   sweep.warm   = gWarmStart;
+   sweep.order  = sweep.start = NULL;
+   if(((sweep.jobs  = (COREJOB *)calloc(ncut, sizeof(COREJOB)))==NULL) ||
+      ((sweep.order = (int *)malloc(ncut * sizeof(int)))==NULL) ||
+      ((sweep.start = (int *)malloc((ncut+1) * sizeof(int)))==NULL))
    {
-      /* Look for the start of the zone                                 */
-      for(start1=0; start1<natom1; start1++)
+      fprintf(job->errfp,"No memory for %d cutoffs\n", ncut);
+      FREE(sweep.jobs);
+      FREE(sweep.order);
+      fclose(ssapfp);
+      return(1);
+   }
+   pdbfiles[0] = job->pdbfile1;
+   pdbfiles[1] = job->pdbfile2;
+   pool = NewThreadPool(2);
+   LoadPDBFiles(pdbfiles, 2, TRUE, gOptions.cachedir, sweep.pdb, natoms,
+                pool);
+   FreeThreadPool(pool);
+   for(i=0; (i<2) && !status; i++)
+   {
+      if(natoms[i] == PDBLOAD_NOFILE)
       {
-         if(idx1[start1]->resnum == z->start[0])
-            break;
+         fprintf(job->errfp,"Unable to open %s for reading\n",
+                 pdbfiles[i]);
+         status = 1;
       }
-      for(start2=0; start2<natom2; start2++)
+      else if(sweep.pdb[i] == NULL)
       {
-         if(idx2[start2]->resnum == z->start[1])
-            break;
+         fprintf(job->errfp,"No atoms read from PDB file: %s\n",
+                 pdbfiles[i]);
+         status = 1;
       }
+   }
+   if(!status && (fcReadSSAP(&gOptions, ssapfp, &sweep.seed) != FC_OK))
+   {
+      fprintf(job->errfp,"No zones read from SSAP file: %s\n",
+              job->ssapfile);
+      status = 1;
+   }
+   fclose(ssapfp);
 
-      /* Loop for the end of the zone                                   */
-      for(end1=0; end1<natom1; end1++)
+   if(!status && job->outfile[0])
+   {
+      if((outfp = fopen(job->outfile,"w"))==NULL)
       {
-         if(idx1[end1]->resnum == z->end[0])
-            break;
+         fprintf(job->errfp,"Unable to open %s for writing\n",
+                 job->outfile);
+         status = 1;
       }
-      for(end2=0; end2<natom2; end2++)
+   }
+
+   /* One job per cutoff                                                */
+   for(i=0; (i<ncut) && !status; i++)
+   {
+      sweep.jobs[i]         = *job;
+      sweep.jobs[i].id      = i+1;
+      sweep.jobs[i].dcut    = cuts[i];
+      sweep.jobs[i].seedcut = (REAL)0.0;
+      sweep.jobs[i].outfile[0] = '\0';
+      sweep.jobs[i].errfp   = NULL;
+      if(((sweep.jobs[i].outfp = tmpfile())==NULL) ||
+         ((sweep.jobs[i].errfp = tmpfile())==NULL))
       {
-         if(idx2[end2]->resnum == z->end[1])
-            break;
+         fprintf(job->errfp,"Unable to create temporary files for \
+sweep output\n");
+         status = 1;
       }
+   }
 
-      
-      /* Step through the zone to see if we are within the cutoff       */
-      split = FALSE;
-      for(i=start1, j=start2; i<=end1 && j<=end2; i++, j++)
+   if(!status)
+   {
+      /* Sort the cutoffs and split them into chains                    */
+      for(i=0; i<ncut; i++)
       {
-         if(DISTSQ(idx1[i], idx2[j]) > cutsq)
-         {
-            split = TRUE;
-            idx1[i]->bval = idx2[j]->bval = (REAL)0.0;
-         }
+         for(j=i; (j>0) && (cuts[sweep.order[j-1]] > cuts[i]); j--)
+            sweep.order[j] = sweep.order[j-1];
+         sweep.order[j] = i;
       }
+      /* A warm chain with one cutoff would start from the SSAP zones */
+      sweep.nchain = (sweep.warm ? MIN(gThreads, ncut/2) : ncut);
+      for(i=0; i<=sweep.nchain; i++)
+         sweep.start[i] = (i * ncut) / sweep.nchain;
 
-      /* See if there were any bits out of range which need the zones
-         to be split
-      */
-      if(split)
+      if((pool = NewThreadPool(gThreads))==NULL)
       {
-         /* See if the whole zone was out of range                      */
-         ok = FALSE;
-         for(i=start1, j=start2; i<=end1 && j<=end2; i++, j++)
-         {
-            if((idx1[i]->bval == (REAL)10.0) ||
-               (idx2[j]->bval == (REAL)10.0))
-            {
-               ok = TRUE;
-               break;
-            }
-         }
-         /* If the zone contains no pairs within 3.0A, mark it for
-            deletion by setting all values to -9999
-         */
-         if(!ok)
+         fprintf(job->errfp,"Unable to start %d threads\n", gThreads);
+         status = 1;
+      }
+   }
+
+   if(!status)
+   {
+      RunPool(pool, SweepTask, (void *)&sweep, sweep.nchain);
+      FreeThreadPool(pool);
+
+      for(i=0; i<ncut; i++)
+      {
+         from[0] = sweep.jobs[i].outfp;  to[0] = outfp;
+         from[1] = sweep.jobs[i].errfp;  to[1] = job->errfp;
+         nbytes[0] = sweep.jobs[i].nout;
+         nbytes[1] = sweep.jobs[i].nerr;
+         for(t=0; t<2; t++)
          {
-            z->start[0] = z->start[1] = 
-               z->end[0] = z->end[1] = (-9999);
+            if(nbytes[t] <= 0)
+               continue;
+            fprintf(to[t],"Cutoff %g:\n", cuts[i]);
+            CopyBytes(from[t], nbytes[t], to[t]);
          }
-         else
-         {
-            /* There were some parts which are still required, but it's
-               been modified, so we need to split the zones up
-         
-               First see if we've lost residues from the start of the
-               zone
-            */
-            while((idx1[start1]->bval == (REAL)0.0) ||
-                  (idx2[start2]->bval == (REAL)0.0))
-            {
-               start1++;
-               start2++;
-               z->start[0] = idx1[start1]->resnum;
-               z->start[1] = idx2[start2]->resnum;
-            }
-            /* Now remove residues from the end of the zone in the same
-               way
-            */
-            while((idx1[end1]->bval == (REAL)0.0) ||
-                  (idx2[end2]->bval == (REAL)0.0))
-            {
-               end1--;
-               end2--;
-               z->end[0] = idx1[end1]->resnum;
-               z->end[1] = idx2[end2]->resnum;
-            }
+         if(sweep.jobs[i].status)
+            status = 1;
+      }
+   }
 
-            /* See if the new zone is split                             */
-            split = FALSE;
-            for(i=start1, j=start2; i<=end1 && j<=end2; i++, j++)
-            {
-               if((idx1[i]->bval == (REAL)0.0) ||
-                  (idx2[j]->bval == (REAL)0.0))
-               {
-                  split = TRUE;
-                  break;
-               }
-            }
-            while(split)
+   for(i=0; i<ncut; i++)
+   {
+      if(sweep.jobs[i].outfp != NULL)
+         fclose(sweep.jobs[i].outfp);
+      if(sweep.jobs[i].errfp != NULL)
+         fclose(sweep.jobs[i].errfp);
+   }
+   if((outfp != NULL) && (outfp != job->outfp))
+      fclose(outfp);
+   for(i=0; i<2; i++)
+      FREELIST(sweep.pdb[i], PDB);
+   if(sweep.seed != NULL)
+      FreeZoneList(sweep.seed);
+   free(sweep.jobs);
+   free(sweep.order);
+   free(sweep.start);
+
+   return(status);
+}
+
+
+/************************************************************************/
+/*>void SweepTask(void *arg, int c)
+   --------------------------------
+   Input:   void       *arg     CORESWEEP
+            int        c        Chain to run
+
+   Pool task for RunSweep(). Runs the jobs in one chain in order of
+   cutoff, each from its own copy of the zones.
+
+   16.10.26 Original   By: ACRM
+*/
+void SweepTask(void *arg, int c)
+{
+   CORESWEEP *sweep = (CORESWEEP *)arg;
+   COREJOB   *job;
+   ZONELIST  *zones,
+             *prev    = NULL;
+   REAL      prevcut  = (REAL)0.0;
+   int       k;
+
+   for(k=sweep->start[c]; k<sweep->start[c+1]; k++)
+   {
+      job = &(sweep->jobs[sweep->order[k]]);
+      rewind(job->outfp);
+      rewind(job->errfp);
+
+      job->seedcut = prevcut;
+      if((zones = DupZoneList((prev != NULL) ? prev : sweep->seed))
+         == NULL)
+      {
+         fprintf(job->errfp,"No memory for zones\n");
+         job->status = 1;
+      }
+      else
+      {
+         job->status = FindJobCore(job, job->outfp, sweep->pdb, zones);
+      }
+      job->nout = ftell(job->outfp);
+      job->nerr = ftell(job->errfp);
+
+      /* Carry the core on to the next cutoff                          */
+      if(prev != NULL)
+         FreeZoneList(prev);
+      prev    = NULL;
+      prevcut = (REAL)0.0;
+      if(sweep->warm && (zones != NULL) && !job->status)
+      {
+         prev    = zones;
+         prevcut = job->dcut;
+      }
+      else if(zones != NULL)
+      {
+         FreeZoneList(zones);
+      }
+   }
+
+   if(prev != NULL)
+      FreeZoneList(prev);
+}
+
+
+/************************************************************************/
+/*>int ParseCutoffs(char *arg, REAL *cuts, int maxcuts)
+   ----------------------------------------------------
+   Input:   char   *arg         Cutoff, list or range
+            int    maxcuts      Size of cuts[]
+   Output:  REAL   *cuts        The cutoffs
+   Returns: int                 Number of cutoffs (0 if arg is bad)
+
+   Reads the -d argument. This is a single cutoff, a comma separated
+   list (1.5,2.0,3.0) or a range first:last:step (1.5:4.0:0.5)
+
+   16.10.26 Original   By: ACRM
+*/
+int ParseCutoffs(char *arg, REAL *cuts, int maxcuts)
+{
+   REAL first, last, step;
+   char *p;
+   int  ncut = 0,
+        n;
+
+   if(strchr(arg, ':') != NULL)
+   {
+      if((sscanf(arg, "%lf:%lf:%lf%n", &first, &last, &step, &n) != 3) ||
+         arg[n] || (first <= (REAL)0.0) || (step <= (REAL)0.0) ||
+         (last < first))
+         return(0);
+
+      /* Allow for rounding in the step                                 */
+      while((first + ncut*step <= last + step/1000) && (ncut < maxcuts))
+      {
+         cuts[ncut] = first + ncut*step;
+         ncut++;
+      }
+      return((first + ncut*step <= last + step/1000) ? 0 : ncut);
+   }
+
+   for(p=arg; ; p++)
+   {
+      if(ncut == maxcuts)
+         return(0);
+      if(sscanf(p, "%lf%n", &(cuts[ncut]), &n) != 1)
+         return(0);
+      if(cuts[ncut++] <= (REAL)0.0)
+         return(0);
+      p += n;
+      if(*p != ',')
+         break;
+   }
+
+   return(*p ? 0 : ncut);
+}
+
+
+/************************************************************************/
+/*>int RunBatch(char *manifest, char *structfile, char *ssapdir,
+                REAL dcut)
+   -------------------------------------------------------------
+   Input:   char       *manifest    Manifest file (- for stdin, blank
+                                    for every pair in structfile)
+            char       *structfile  List of structures to read once and
+                                    share between jobs (or blank)
+            char       *ssapdir     Directory of SSAP files for every
+                                    pair
+            REAL       dcut         Cutoff for jobs which don't give one
+   Returns: int                     Exit status (0 if every job worked)
+
+   Runs the jobs listed in a manifest, or for every pair of structures,
+   gThreads at a time. Jobs are made and run BATCH_CHUNK at a time;
+   each writes its zones and errors to its own temporary files, which
+   are then copied to stdout and stderr in job order.
+
+   Unless the structures have all been read from structfile, jobs get
+   them from a cache of gCacheMB Mbytes, so a structure used by many
+   jobs is usually only read once.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Added structfile and ssapdir
+   16.10.26 Added the structure cache
+*/
+int RunBatch(char *manifest, char *structfile, char *ssapdir,
+             REAL dcut)
+{
+   FILE       *fp = NULL;
+   COREJOB    *jobs;
+   THREADPOOL *pool;
+   STRCACHE   *cache = NULL;
+   BATCHREAD  br;
+   int        njobs,
+              i,
+              status = 0;
+
+   if(!strcmp(manifest, "-"))
+   {
+      fp = stdin;
+   }
+   else if(manifest[0] && ((fp=fopen(manifest,"r"))==NULL))
+   {
+      fprintf(stderr,"Unable to open %s for reading\n",manifest);
+      return(1);
+   }
+
+   if((jobs = (COREJOB *)calloc(BATCH_CHUNK, sizeof(COREJOB)))==NULL)
+   {
+      fprintf(stderr,"No memory for batch jobs\n");
+      return(1);
+   }
+   for(i=0; i<BATCH_CHUNK; i++)
+   {
+      if(((jobs[i].outfp = tmpfile())==NULL) ||
+         ((jobs[i].errfp = tmpfile())==NULL))
+      {
+         fprintf(stderr,"Unable to create temporary files for batch \
+output\n");
+         return(1);
+      }
+   }
+
+   if((pool = NewThreadPool(gThreads))==NULL)
+   {
+      fprintf(stderr,"Unable to start %d threads\n", gThreads);
+      return(1);
+   }
+
+   br.fp         = fp;
+   br.manifest   = manifest;
+   br.dcut       = dcut;
+   br.nline      = 0;
+   br.njobs      = 0;
+   br.bad        = FALSE;
+   br.structs    = NULL;
+   br.structfile = structfile;
+   br.ssapdir    = ssapdir;
+   br.pair1      = 0;
+   br.pair2      = 1;
+
+   /* Read every structure once, or keep them as they are read        */
+   if(structfile[0])
+   {
+      if((br.structs = ReadStructList(structfile, pool))==NULL)
+         return(1);
+   }
+   else
+   {
+      if((cache = NewStructCache((unsigned long)gCacheMB * 1048576UL,
+                                 gOptions.cachedir))==NULL)
+      {
+         fprintf(stderr,"No memory for structure cache\n");
+         return(1);
+      }
+      for(i=0; i<BATCH_CHUNK; i++)
+         jobs[i].cache = cache;
+   }
+
+   while((njobs = ReadJobs(&br, jobs, BATCH_CHUNK)) > 0)
+   {
+      RunPool(pool, JobTask, (void *)jobs, njobs);
+
+      for(i=0; i<njobs; i++)
+      {
+         CopyJobOutput(&(jobs[i]));
+         if(jobs[i].status)
+            status = 1;
+      }
+   }
+   if(br.bad)
+      status = 1;
+
+   FreeThreadPool(pool);
+   for(i=0; i<BATCH_CHUNK; i++)
+   {
+      fclose(jobs[i].outfp);
+      fclose(jobs[i].errfp);
+   }
+   free(jobs);
+   if((fp != NULL) && (fp != stdin))
+      fclose(fp);
+   if(br.structs != NULL)
+      FreeStructList(br.structs);
+   if(cache != NULL)
+   {
+      if(gVerbose)
+         ReportStructCache(stderr, cache);
+      FreeStructCache(cache);
+   }
+
+   return(status);
+}
+
+
+/************************************************************************/
+/*>int ReadJobs(BATCHREAD *br, COREJOB *jobs, int maxjobs)
+   -------------------------------------------------------
+   I/O:     BATCHREAD  *br      Manifest being read
+   Output:  COREJOB    *jobs    Jobs read (the output files are left
+                                alone)
+   Input:   int        maxjobs  Maximum number of jobs to read
+   Returns: int                 Number of jobs read
+
+   Reads the next jobs from a batch manifest. Each line is
+      ssapfile in1.pdb in2.pdb [dcut [output.lis [out1.pdb [out2.pdb]]]]
+   where - for dcut gives the default and - for a file name means no
+   file. Blank lines and lines starting with # are skipped. Bad lines
+   are reported, skipped and flagged in br->bad.
+
+   If structures have been read already, in1.pdb and in2.pdb must be
+   among them and out1.pdb and out2.pdb can't be given. Without a
+   manifest the jobs are made by PairJobs().
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Added br->structs
+   16.10.26 The fields are read by ParseJob()
+*/
+int ReadJobs(BATCHREAD *br, COREJOB *jobs, int maxjobs)
+{
+   char    buffer[BATCH_LINE],
+           *field[BATCH_FIELDS];
+   int     njobs = 0,
+           nfield,
+           i;
+   BOOL    ok,
+           whole;
+   COREJOB *job;
+
+   if(br->fp == NULL)
+      return(PairJobs(br, jobs, maxjobs));
+
+   while((njobs < maxjobs) && fgets(buffer, BATCH_LINE, br->fp))
+   {
+      br->nline++;
+      job = &(jobs[njobs]);
+
+      whole  = (strchr(buffer, '\n') != NULL) || feof(br->fp);
+      nfield = SplitLine(buffer, field, BATCH_FIELDS);
+
+      /* Skip blank lines and comments                                 */
+      if(whole && !nfield)
+         continue;
+
+      ok = whole && ParseJob(field, nfield, job, br->dcut);
+
+      if(ok && (br->structs != NULL))
+      {
+         /* Shared structures mustn't be changed for writing out       */
+         ok = (!job->outpdb1[0] && !job->outpdb2[0]);
+         for(i=0; ok && (i<2); i++)
+         {
+            if((job->shared[i] = FindStructure(br->structs,
+                                               field[i+1]))==NULL)
             {
-               /* Move the last sub-zone into a separate zone           */
-               znext = z->next;
-               INIT(zend, ZONE);
-               if(zend==NULL)
-               {
-                  fprintf(stderr,"No memory for new zones!\n");
-                  return(FALSE);
-               }
-               z->next     = zend;
-               zend->prev  = z;
-               zend->next  = znext;
-               znext->prev = zend;
-               
-               zend->end[0] = z->end[0];
-               zend->end[1] = z->end[1];
-               /* Step back through the zone to find the start of this
-                  subzone
-               */
-               while((idx1[end1]->bval == (REAL)10.0) &&
-                     (idx2[end2]->bval == (REAL)10.0))
-               {
-                  end1--;
-                  end2--;
-                  zend->start[0] = idx1[end1]->resnum;
-                  zend->start[1] = idx2[end2]->resnum;
-               }
-               /* Now step back to the end of the previous subzone      */
-               while((idx1[end1]->bval == (REAL)0.0) ||
-                     (idx2[end2]->bval == (REAL)0.0))
-               {
-                  end1--;
-                  end2--;
-                  z->end[0] = idx1[end1]->resnum;
-                  z->end[1] = idx2[end2]->resnum;
-               }
-
-               /* Test again to see if it's split                       */
-               split = FALSE;
-               for(i=start1, j=start2; i<=end1 && j<=end2; i++, j++)
-               {
-                  if((idx1[i]->bval == (REAL)0.0) ||
-                     (idx2[j]->bval == (REAL)0.0))
-                  {
-                     split = TRUE;
-                     break;
-                  }
-               }
+               fprintf(stderr,"%s on line %d of %s is not in %s\n",
+                       field[i+1], br->nline, br->manifest,
+                       br->structfile);
+               ok = FALSE;
             }
          }
       }
+
+      if(!ok)
+      {
+         fprintf(stderr,"Bad job on line %d of %s\n", br->nline,
+                 br->manifest);
+         br->bad = TRUE;
+
+         /* Skip the rest of an over-long line                          */
+         while(!whole && fgets(buffer, BATCH_LINE, br->fp))
+            whole = (strchr(buffer, '\n') != NULL);
+         continue;
+      }
+
+      job->id = ++(br->njobs);
+      njobs++;
    }
-      
+
+   return(njobs);
+}
+
+
+/************************************************************************/
+/*>BOOL ParseJob(char **field, int nfield, COREJOB *job, REAL dcut)
+   ----------------------------------------------------------------
+   Input:   char       **field  Fields of a manifest line
+            int        nfield   Number of fields (-1 for too many)
+            REAL       dcut     Cutoff if the job doesn't give one
+   Output:  COREJOB    *job     The job's files and cutoff (the output
+                                files and id are left alone)
+   Returns: BOOL                The fields make a job
+
+   16.10.26 Original (from ReadJobs())   By: ACRM
+*/
+BOOL ParseJob(char **field, int nfield, COREJOB *job, REAL dcut)
+{
+   int i;
+
+   if(nfield < 3)
+      return(FALSE);
+   for(i=0; i<nfield; i++)
+   {
+      if(strlen(field[i]) >= MAXBUFF)
+         return(FALSE);
+   }
+
+   job->dcut = dcut;
+   if((nfield > 3) && strcmp(field[3], "-") &&
+      (sscanf(field[3], "%lf", &(job->dcut)) != 1))
+      return(FALSE);
+
+   strcpy(job->ssapfile, field[0]);
+   strcpy(job->pdbfile1, field[1]);
+   strcpy(job->pdbfile2, field[2]);
+   job->outfile[0] = job->outpdb1[0] = job->outpdb2[0] = '\0';
+   if((nfield > 4) && strcmp(field[4], "-"))
+      strcpy(job->outfile, field[4]);
+   if((nfield > 5) && strcmp(field[5], "-"))
+      strcpy(job->outpdb1, field[5]);
+   if((nfield > 6) && strcmp(field[6], "-"))
+      strcpy(job->outpdb2, field[6]);
+   job->shared[0] = job->shared[1] = NULL;
+
    return(TRUE);
 }
 
+
+/************************************************************************/
+/*>int PairJobs(BATCHREAD *br, COREJOB *jobs, int maxjobs)
+   -------------------------------------------------------
+   I/O:     BATCHREAD  *br      Pairs of structures; br->pair1 and
+                                br->pair2 are the next pair
+   Output:  COREJOB    *jobs    Jobs made (the output files are left
+                                alone)
+   Input:   int        maxjobs  Maximum number of jobs to make
+   Returns: int                 Number of jobs made
+
+   Makes the jobs for the next pairs of br->structs, taking each pair
+   once in list order. The SSAP file for a pair is
+   ssapdir/stem1_stem2.ssap where the stems are the structures' file
+   names without directory or extension.
+
+   16.10.26 Original   By: ACRM
+*/
+int PairJobs(BATCHREAD *br, COREJOB *jobs, int maxjobs)
+{
+   STRUCTURE *s1, *s2;
+   COREJOB   *job;
+   char      *stem[2],
+             *c;
+   int       njobs = 0,
+             len[2],
+             i;
+
+   while((njobs < maxjobs) && (br->pair1 < br->structs->nstruc - 1))
+   {
+      s1  = &(br->structs->struc[br->pair1]);
+      s2  = &(br->structs->struc[br->pair2]);
+      job = &(jobs[njobs]);
+
+      if(++(br->pair2) == br->structs->nstruc)
+      {
+         br->pair1++;
+         br->pair2 = br->pair1 + 1;
+      }
+
+      /* Find the stem of each file name                               */
+      for(i=0; i<2; i++)
+      {
+         stem[i] = (i ? s2 : s1)->name;
+         if((c = strrchr(stem[i], '/')) != NULL)
+            stem[i] = c+1;
+         len[i] = ((c = strrchr(stem[i], '.')) != NULL) ?
+                  (int)(c - stem[i]) : (int)strlen(stem[i]);
+      }
+
+      if(strlen(br->ssapdir) + len[0] + len[1] + 8 > MAXBUFF)
+      {
+         fprintf(stderr,"SSAP file name too long for %s and %s\n",
+                 s1->name, s2->name);
+         br->bad = TRUE;
+         continue;
+      }
+
+      sprintf(job->ssapfile, "%s/%.*s_%.*s.ssap", br->ssapdir,
+              len[0], stem[0], len[1], stem[1]);
+      strcpy(job->pdbfile1, s1->name);
+      strcpy(job->pdbfile2, s2->name);
+      job->outfile[0] = job->outpdb1[0] = job->outpdb2[0] = '\0';
+      job->dcut      = br->dcut;
+      job->shared[0] = s1->pdb;
+      job->shared[1] = s2->pdb;
+      job->id        = ++(br->njobs);
+      njobs++;
+   }
+
+   return(njobs);
+}
+
+
+/************************************************************************/
+/*>int SplitLine(char *buffer, char **field, int maxfield)
+   -------------------------------------------------------
+   I/O:     char       *buffer    Line of a manifest or structure list;
+                                  the white space is blanked out
+   Output:  char       **field    Start of each field
+   Input:   int        maxfield   Size of field[]
+   Returns: int                   Number of fields (0 for a blank line
+                                  or comment, -1 if there are more than
+                                  maxfield)
+
+   16.10.26 Original (from ReadJobs())   By: ACRM
+*/
+int SplitLine(char *buffer, char **field, int maxfield)
+{
+   char *c;
+   int  nfield = 0;
+
+   for(c=buffer; *c; )
+   {
+      while(isspace((int)*c))
+         *(c++) = '\0';
+      if(!*c || (*c == '#' && !nfield))
+         break;
+      if(nfield == maxfield)
+         return(-1);
+      field[nfield++] = c;
+      while(*c && !isspace((int)*c))
+         c++;
+   }
+
+   return(nfield);
+}
+
+
+/************************************************************************/
+/*>STRUCTLIST *ReadStructList(char *structfile, THREADPOOL *pool)
+   --------------------------------------------------------------
+   Input:   char       *structfile  File listing PDB files, one per
+                                    line
+            THREADPOOL *pool        Threads for reading them
+   Returns: STRUCTLIST *            The structures (NULL if any
+                                    couldn't be read or no memory)
+
+   Reads every structure in a list once so that jobs can share them.
+   Only the C-alphas are kept. Blank lines and lines starting with #
+   are skipped.
+
+   16.10.26 Original   By: ACRM
+*/
+STRUCTLIST *ReadStructList(char *structfile, THREADPOOL *pool)
+{
+   FILE       *fp;
+   STRUCTLIST *sl;
+   STRUCTURE  *struc;
+   char       buffer[BATCH_LINE],
+              *field[1],
+              **names;
+   PDB        **pdb;
+   int        *natoms,
+              maxstruc = 0,
+              nline    = 0,
+              i;
+   BOOL       ok       = TRUE;
+
+   if((fp=fopen(structfile,"r"))==NULL)
+   {
+      fprintf(stderr,"Unable to open %s for reading\n",structfile);
+      return(NULL);
+   }
+   if((sl = (STRUCTLIST *)malloc(sizeof(STRUCTLIST)))==NULL)
+   {
+      fprintf(stderr,"No memory for structure list\n");
+      fclose(fp);
+      return(NULL);
+   }
+   sl->nstruc = 0;
+   sl->struc  = NULL;
+   sl->byName = NULL;
+
+   while(ok && fgets(buffer, BATCH_LINE, fp))
+   {
+      nline++;
+      if((i = SplitLine(buffer, field, 1)) == 0)
+         continue;
+
+      if((i < 0) || (strlen(field[0]) >= MAXBUFF))
+      {
+         fprintf(stderr,"Bad structure on line %d of %s\n", nline,
+                 structfile);
+         ok = FALSE;
+         break;
+      }
+
+      if(sl->nstruc == maxstruc)
+      {
+         maxstruc = (maxstruc ? 2 * maxstruc : 64);
+         if((struc = (STRUCTURE *)realloc(sl->struc, maxstruc *
+                                          sizeof(STRUCTURE)))==NULL)
+         {
+            fprintf(stderr,"No memory for structure list\n");
+            ok = FALSE;
+            break;
+         }
+         sl->struc = struc;
+      }
+      if((sl->struc[sl->nstruc].name =
+          (char *)malloc(strlen(field[0]) + 1))==NULL)
+      {
+         fprintf(stderr,"No memory for structure list\n");
+         ok = FALSE;
+         break;
+      }
+      strcpy(sl->struc[sl->nstruc].name, field[0]);
+      sl->struc[sl->nstruc].pdb = NULL;
+      sl->nstruc++;
+   }
+   fclose(fp);
+
+   if(ok && (sl->nstruc < 2))
+   {
+      fprintf(stderr,"Fewer than two structures in %s\n",structfile);
+      ok = FALSE;
+   }
+
+   /* Read the structures on the thread pool                            */
+   names  = NULL;
+   pdb    = NULL;
+   natoms = NULL;
+   if(ok &&
+      (((names  = (char **)malloc(sl->nstruc * sizeof(char *)))==NULL) ||
+       ((pdb    = (PDB **)malloc(sl->nstruc * sizeof(PDB *)))==NULL)   ||
+       ((natoms = (int *)malloc(sl->nstruc * sizeof(int)))==NULL)      ||
+       ((sl->byName = (STRUCTURE **)malloc(sl->nstruc *
+                                           sizeof(STRUCTURE *)))==NULL)))
+   {
+      fprintf(stderr,"No memory for %d structures\n", sl->nstruc);
+      ok = FALSE;
+   }
+   if(ok)
+   {
+      for(i=0; i<sl->nstruc; i++)
+         names[i] = sl->struc[i].name;
+      LoadPDBFiles(names, sl->nstruc, TRUE, gOptions.cachedir, pdb,
+                   natoms, pool);
+
+      for(i=0; i<sl->nstruc; i++)
+      {
+         if((sl->struc[i].pdb = pdb[i]) == NULL)
+         {
+            if(natoms[i] == PDBLOAD_NOFILE)
+               fprintf(stderr,"Unable to open %s for reading\n",
+                       names[i]);
+            else
+               fprintf(stderr,"No atoms read from PDB file: %s\n",
+                       names[i]);
+            ok = FALSE;
+         }
+         sl->byName[i] = &(sl->struc[i]);
+      }
+      qsort(sl->byName, sl->nstruc, sizeof(STRUCTURE *),
+            CompareStructNames);
+   }
+   FREE(names);
+   FREE(pdb);
+   FREE(natoms);
+
+   if(!ok)
+   {
+      FreeStructList(sl);
+      return(NULL);
+   }
+   return(sl);
+}
+
+
+/************************************************************************/
+/*>void FreeStructList(STRUCTLIST *sl)
+   -----------------------------------
+   I/O:     STRUCTLIST *sl      Structures to free
+
+   16.10.26 Original   By: ACRM
+*/
+void FreeStructList(STRUCTLIST *sl)
+{
+   int i;
+
+   for(i=0; i<sl->nstruc; i++)
+   {
+      FREE(sl->struc[i].name);
+      FREELIST(sl->struc[i].pdb, PDB);
+   }
+   FREE(sl->struc);
+   FREE(sl->byName);
+   free(sl);
+}
+
+
+/************************************************************************/
+/*>PDB *FindStructure(STRUCTLIST *sl, char *name)
+   ----------------------------------------------
+   Input:   STRUCTLIST *sl      Structures
+            char       *name    PDB file as given in the list
+   Returns: PDB        *        The structure (NULL if not in the list)
+
+   16.10.26 Original   By: ACRM
+*/
+PDB *FindStructure(STRUCTLIST *sl, char *name)
+{
+   STRUCTURE key,
+             *pkey = &key,
+             **found;
+
+   key.name = name;
+   found = (STRUCTURE **)bsearch(&pkey, sl->byName, sl->nstruc,
+                                 sizeof(STRUCTURE *),
+                                 CompareStructNames);
+   return((found == NULL) ? NULL : (*found)->pdb);
+}
+
+
+/************************************************************************/
+/*>int CompareStructNames(const void *a, const void *b)
+   ----------------------------------------------------
+   Input:   const void *a       Pointer to a STRUCTURE pointer
+            const void *b       Pointer to a STRUCTURE pointer
+   Returns: int                 strcmp() of their names
+
+   qsort()/bsearch() comparison for STRUCTLIST byName[]
+
+   16.10.26 Original   By: ACRM
+*/
+int CompareStructNames(const void *a, const void *b)
+{
+   return(strcmp((*(STRUCTURE **)a)->name, (*(STRUCTURE **)b)->name));
+}
+
+
+/************************************************************************/
+/*>void JobTask(void *arg, int i)
+   ------------------------------
+   Input:   void       *arg     Array of COREJOBs
+            int        i        Job to run
+
+   Pool task for RunBatch(). Runs a job into its temporary files and
+   records how much it wrote to them.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Jobs may use the structure cache
+*/
+void JobTask(void *arg, int i)
+{
+   COREJOB *job = (COREJOB *)arg + i;
+
+   rewind(job->outfp);
+   rewind(job->errfp);
+   if(job->cache != NULL)
+      job->status = RunCachedJob(job);
+   else
+      job->status = RunJob(job, NULL);
+   job->nout   = ftell(job->outfp);
+   job->nerr   = ftell(job->errfp);
+}
+
+
+/************************************************************************/
+/*>void CopyJobOutput(COREJOB *job)
+   --------------------------------
+   Input:   COREJOB    *job     Job which has been run
+
+   Copies what a batch job wrote to its temporary files to stdout and
+   stderr, each headed by the job number and its files
+
+   16.10.26 Original   By: ACRM
+   16.10.26 The copying is done by CopyBytes()
+*/
+void CopyJobOutput(COREJOB *job)
+{
+   FILE *from[2],
+        *to[2];
+   long nbytes[2];
+   int  i;
+
+   from[0] = job->outfp;  to[0] = stdout;  nbytes[0] = job->nout;
+   from[1] = job->errfp;  to[1] = stderr;  nbytes[1] = job->nerr;
+
+   for(i=0; i<2; i++)
+   {
+      if(nbytes[i] <= 0)
+         continue;
+
+      fprintf(to[i],"Job %d: %s %s %s\n", job->id,
+              job->ssapfile, job->pdbfile1, job->pdbfile2);
+      CopyBytes(from[i], nbytes[i], to[i]);
+   }
+}
+
+
+/************************************************************************/
+/*>void CopyBytes(FILE *from, long nbytes, FILE *to)
+   -------------------------------------------------
+   Input:   FILE       *from    File to copy from its start
+            long       nbytes   Number of bytes to copy
+            FILE       *to      File to copy to
+
+   16.10.26 Original (from CopyJobOutput())   By: ACRM
+*/
+void CopyBytes(FILE *from, long nbytes, FILE *to)
+{
+   char buffer[BATCH_COPY];
+   long n;
+
+   rewind(from);
+   while(nbytes > 0)
+   {
+      n = (nbytes < BATCH_COPY) ? nbytes : BATCH_COPY;
+      if((n = (long)fread(buffer, 1, (size_t)n, from)) <= 0)
+         break;
+      fwrite(buffer, 1, (size_t)n, to);
+      nbytes -= n;
+   }
+}
+
+
+/************************************************************************/
+/*>int RunServer(char *socketpath, REAL dcut)
+   ------------------------------------------
+   Input:   char       *socketpath  Unix domain socket to listen on
+            REAL       dcut         Cutoff for jobs which don't give
+                                    one
+   Returns: int                     Exit status (0 if stopped by a
+                                    signal)
+
+   Runs findcore as a server until it gets SIGINT or SIGTERM. gThreads
+   threads each take a connection and run the jobs sent on it in turn
+   (see ServeClient()). Structures are kept between jobs in a cache
+   of gCacheMB Mbytes, so a job whose structures have been seen before
+   only has to read the SSAP file and find the core.
+
+   Signals are only taken by this thread. On stopping, the threads
+   finish the job they are running, then everything is freed and the
+   socket removed.
+
+   16.10.26 Original   By: ACRM
+*/
+int RunServer(char *socketpath, REAL dcut)
+{
+   CORESERVER   server;
+   SERVERTHREAD *threads;
+   sigset_t     sigs;
+   int          nthreads = 0,
+                status   = 0,
+                i,
+                sig;
+
+   server.dcut  = dcut;
+   server.quit  = FALSE;
+
+   if(((server.cache = NewStructCache((unsigned long)gCacheMB * 1048576UL,
+                                      gOptions.cachedir))==NULL) ||
+      ((threads = (SERVERTHREAD *)malloc(gThreads *
+                                         sizeof(SERVERTHREAD)))==NULL))
+   {
+      fprintf(stderr,"No memory for server\n");
+      FreeStructCache(server.cache);
+      return(1);
+   }
+
+   if((server.listenfd = OpenServerSocket(socketpath)) < 0)
+   {
+      FreeStructCache(server.cache);
+      free(threads);
+      return(1);
+   }
+
+   /* Block the signals in every thread and wait for them here. A client
+      going away mustn't stop the server
+   */
+   sigemptyset(&sigs);
+   sigaddset(&sigs, SIGINT);
+   sigaddset(&sigs, SIGTERM);
+   pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+   signal(SIGPIPE, SIG_IGN);
+
+   pthread_mutex_init(&(server.lock), NULL);
+   for(nthreads=0; nthreads<gThreads; nthreads++)
+   {
+      threads[nthreads].server = &server;
+      threads[nthreads].connfd = -1;
+      if(pthread_create(&(threads[nthreads].thread), NULL, ServerThread,
+                        &(threads[nthreads])))
+      {
+         fprintf(stderr,"Unable to start %d threads\n", gThreads);
+         status = 1;
+         break;
+      }
+   }
+
+   if(!status)
+      sigwait(&sigs, &sig);
+
+   /* Stop taking connections and end any waiting for a job            */
+   pthread_mutex_lock(&(server.lock));
+   server.quit = TRUE;
+   shutdown(server.listenfd, SHUT_RDWR);
+   for(i=0; i<nthreads; i++)
+   {
+      if(threads[i].connfd >= 0)
+         shutdown(threads[i].connfd, SHUT_RD);
+   }
+   pthread_mutex_unlock(&(server.lock));
+
+   for(i=0; i<nthreads; i++)
+      pthread_join(threads[i].thread, NULL);
+
+   close(server.listenfd);
+   unlink(socketpath);
+
+   pthread_mutex_destroy(&(server.lock));
+   if(gVerbose)
+      ReportStructCache(stderr, server.cache);
+   FreeStructCache(server.cache);
+   free(threads);
+
+   return(status);
+}
+
+
+/************************************************************************/
+/*>int OpenServerSocket(char *socketpath)
+   --------------------------------------
+   Input:   char       *socketpath  Unix domain socket to listen on
+   Returns: int                     The listening socket (-1 on error)
+
+   A socket left by a server which has stopped is replaced. Anything
+   else already at socketpath is an error.
+
+   16.10.26 Original   By: ACRM
+*/
+int OpenServerSocket(char *socketpath)
+{
+   struct sockaddr_un addr;
+   int                fd;
+
+   if(strlen(socketpath) >= sizeof(addr.sun_path))
+   {
+      fprintf(stderr,"Socket name too long: %s\n",socketpath);
+      return(-1);
+   }
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strcpy(addr.sun_path, socketpath);
+
+   if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+   {
+      fprintf(stderr,"Unable to create a socket\n");
+      return(-1);
+   }
+
+   if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)))
+   {
+      if((errno != EADDRINUSE) || !StaleSocket(&addr) ||
+         unlink(socketpath) ||
+         bind(fd, (struct sockaddr *)&addr, sizeof(addr)))
+      {
+         fprintf(stderr,"Unable to create socket %s\n",socketpath);
+         close(fd);
+         return(-1);
+      }
+   }
+
+   if(listen(fd, SOMAXCONN))
+   {
+      fprintf(stderr,"Unable to listen on %s\n",socketpath);
+      close(fd);
+      unlink(socketpath);
+      return(-1);
+   }
+
+   return(fd);
+}
+
+
+/************************************************************************/
+/*>BOOL StaleSocket(struct sockaddr_un *addr)
+   ------------------------------------------
+   Input:   struct sockaddr_un *addr   Socket address
+   Returns: BOOL                       There is a socket at the address
+                                       but nothing is listening on it
+
+   16.10.26 Original   By: ACRM
+*/
+BOOL StaleSocket(struct sockaddr_un *addr)
+{
+   struct stat st;
+   int         fd;
+   BOOL        stale;
+
+   if(stat(addr->sun_path, &st) || !S_ISSOCK(st.st_mode))
+      return(FALSE);
+   if((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+      return(FALSE);
+
+   stale = (connect(fd, (struct sockaddr *)addr, sizeof(*addr)) &&
+            (errno == ECONNREFUSED));
+   close(fd);
+
+   return(stale);
+}
+
+
+/************************************************************************/
+/*>void *ServerThread(void *arg)
+   -----------------------------
+   Input:   void       *arg     The thread's SERVERTHREAD
+
+   Thread function for RunServer(). Takes connections one at a time
+   until the server stops. The output of each job goes to the thread's
+   own temporary files before being sent.
+
+   16.10.26 Original   By: ACRM
+*/
+void *ServerThread(void *arg)
+{
+   SERVERTHREAD *st     = (SERVERTHREAD *)arg;
+   CORESERVER   *server = st->server;
+   FILE         *outfp,
+                *errfp  = NULL;
+   int          fd,
+                err;
+
+   if(((outfp = tmpfile())==NULL) || ((errfp = tmpfile())==NULL))
+   {
+      fprintf(stderr,"Unable to create temporary files for server \
+output\n");
+      if(outfp != NULL)
+         fclose(outfp);
+      return(NULL);
+   }
+
+   for(;;)
+   {
+      fd  = accept(server->listenfd, NULL, NULL);
+      err = errno;
+
+      pthread_mutex_lock(&(server->lock));
+      if(server->quit)
+      {
+         pthread_mutex_unlock(&(server->lock));
+         if(fd >= 0)
+            close(fd);
+         break;
+      }
+      st->connfd = fd;
+      pthread_mutex_unlock(&(server->lock));
+
+      if(fd < 0)
+      {
+         if((err == EINTR) || (err == ECONNABORTED))
+            continue;
+         fprintf(stderr,"Unable to accept connections\n");
+         break;
+      }
+
+      ServeClient(server, fd, outfp, errfp);
+
+      pthread_mutex_lock(&(server->lock));
+      st->connfd = -1;
+      pthread_mutex_unlock(&(server->lock));
+      close(fd);
+   }
+
+   fclose(outfp);
+   fclose(errfp);
+
+   return(NULL);
+}
+
+
+/************************************************************************/
+/*>void ServeClient(CORESERVER *server, int fd, FILE *outfp,
+                    FILE *errfp)
+   ---------------------------------------------------------
+   I/O:     CORESERVER *server  The server
+   Input:   int        fd       Connection to a client (left open)
+   I/O:     FILE       *outfp   Temporary file for job output
+            FILE       *errfp   Temporary file for job errors
+
+   Runs the jobs a client sends until it closes the connection. Each
+   line is a job as in a batch manifest; blank lines and comments are
+   skipped. The reply to a job is the line
+      status nout nerr
+   followed by the nout bytes of its output and the nerr bytes of its
+   error messages.
+
+   16.10.26 Original   By: ACRM
+*/
+void ServeClient(CORESERVER *server, int fd, FILE *outfp, FILE *errfp)
+{
+   FILE    *in,
+           *out;
+   COREJOB job;
+   char    buffer[BATCH_LINE],
+           *field[BATCH_FIELDS];
+   int     nfield,
+           fd2;
+   BOOL    whole;
+
+   if((fd2 = dup(fd)) < 0)
+      return;
+   if((in = fdopen(fd2, "r"))==NULL)
+   {
+      close(fd2);
+      return;
+   }
+   if(((fd2 = dup(fd)) < 0) || ((out = fdopen(fd2, "w"))==NULL))
+   {
+      if(fd2 >= 0)
+         close(fd2);
+      fclose(in);
+      return;
+   }
+
+   job.id    = 1;
+   job.outfp = outfp;
+   job.errfp = errfp;
+   job.cache = server->cache;
+   job.seedcut = (REAL)0.0;
+
+   while(fgets(buffer, BATCH_LINE, in))
+   {
+      whole  = (strchr(buffer, '\n') != NULL) || feof(in);
+      nfield = SplitLine(buffer, field, BATCH_FIELDS);
+      if(whole && !nfield)
+         continue;
+
+      rewind(outfp);
+      rewind(errfp);
+      if(whole && ParseJob(field, nfield, &job, server->dcut))
+      {
+         job.status = RunCachedJob(&job);
+      }
+      else
+      {
+         fprintf(errfp,"Bad job\n");
+         job.status = 1;
+
+         /* Skip the rest of an over-long line                          */
+         while(!whole && fgets(buffer, BATCH_LINE, in))
+            whole = (strchr(buffer, '\n') != NULL);
+      }
+      job.nout = ftell(outfp);
+      job.nerr = ftell(errfp);
+
+      fprintf(out,"%d %ld %ld\n", job.status, job.nout, job.nerr);
+      CopyBytes(outfp, job.nout, out);
+      CopyBytes(errfp, job.nerr, out);
+      if(fflush(out) == EOF)
+         break;
+   }
+
+   fclose(in);
+   fclose(out);
+}
+
+
+/************************************************************************/
+/*>int RunCachedJob(COREJOB *job)
+   ------------------------------
+   I/O:     COREJOB    *job     The job
+   Returns: int                 Exit status (0 for success)
+
+   Runs a job on structures from job->cache. Structures which are to be
+   written out are changed, so the job gets its own copies of every
+   atom. If either structure can't be read, RunJob() reads them again
+   to report why.
+
+   16.10.26 Original (RunServerJob())   By: ACRM
+   16.10.26 Renamed and uses the structure cache. Used for batch jobs
+            too. Structures to be written out come from the cache
+*/
+int RunCachedJob(COREJOB *job)
+{
+   STRENTRY *entry[2];
+   PDB      *pdb[2];
+   char     *pdbfiles[2];
+   int      natoms,
+            status,
+            i;
+   BOOL     full = (job->outpdb1[0] || job->outpdb2[0]),
+            copy = FALSE;
+
+   pdbfiles[0] = job->pdbfile1;
+   pdbfiles[1] = job->pdbfile2;
+   for(i=0; i<2; i++)
+      entry[i] = GetCachedStructure(job->cache, pdbfiles[i], full,
+                                    &(pdb[i]), &natoms);
+
+   if((entry[0] != NULL) && (entry[1] != NULL))
+   {
+      if(full)
+      {
+         job->shared[0] = blDupePDB(pdb[0]);
+         job->shared[1] = blDupePDB(pdb[1]);
+         if((job->shared[0] == NULL) || (job->shared[1] == NULL))
+         {
+            for(i=0; i<2; i++)
+               FREELIST(job->shared[i], PDB);
+         }
+         else
+         {
+            copy = TRUE;
+         }
+      }
+      else
+      {
+         job->shared[0] = pdb[0];
+         job->shared[1] = pdb[1];
+      }
+   }
+
+   status = RunJob(job, NULL);
+
+   for(i=0; i<2; i++)
+   {
+      if(copy)
+         FREELIST(job->shared[i], PDB);
+      if(entry[i] != NULL)
+         ReleaseCachedStructure(job->cache, entry[i]);
+   }
+   job->shared[0] = job->shared[1] = NULL;
+
+   return(status);
+}
+
+
 /************************************************************************/
-/*>void UpdateBValues(PDB **idx1, int natom1, PDB **idx2, int natom2,
-                      ZONE *zones, REAL cutsq)
-   ------------------------------------------------------------------
-   Update the B-values and the current zones by extending out from
-   the secondary structure regions
+/*>BOOL ParseCmdLine(int argc, char **argv, char *ssapfile, 
+                     char *pdbfile1, char *pdbfile2, char *outfile, 
+                     char *outpdb1, char *outpdb2, REAL *dcut,
+                     char *manifest, char *structfile,
+                     char *socketpath)
+   ----------------------------------------------------------------
+   Input:   int    argc         Argument count
+            char   **argv       Argument array
+   Output:  char   *ssapfile    Input SSAP file (or the directory of
+                                SSAP files with -a)
+            char   *pdbfile1    First input PDB file
+            char   *pdbfile2    Second input PDB file
+            char   *outfile     Output listing file (or blank string)
+            char   *outpdb1     Output first PDB file (or blank string)
+            char   *outpdb2     Output second PDB file (or blank string)
+            REAL   *dcut        Cutoff for defining core
+            char   *manifest    Batch manifest (or blank string)
+            char   *structfile  Structure list for all-vs-all (or
+                                blank string)
+            char   *socketpath  Socket for server mode (or blank
+                                string)
+   Returns: BOOL                Success?
 
-   14.11.96 Original   By: ACRM
-   13.03.97 Now checks that residues are not already in a zone before
-            adding them to the current zone. Fixes a problem at the
-            zone-merge stage where the merged zones could end up with
-            different numbers of residues.
+   Parse the command line
+   
+   14.11.96 Original    By: ACRM
+   06.12.96 Added -i
+   23.01.97 Added -n
+   16.10.26 Added -s
+   16.10.26 Added -f
+   16.10.26 Added -r and -c
+   16.10.26 Added -k
+   16.10.26 Added -b and -t
+   16.10.26 Added -a
+   16.10.26 Added -u
+   16.10.26 Added -l. -k sets the cache directory in gOptions
+   16.10.26 -d takes a list or range. Added -w
+   16.10.26 Options missing their argument are rejected
 */
-void UpdateBValues(PDB **idx1, int natom1, PDB **idx2, int natom2,
-                   ZONE *zones, REAL cutsq)
+BOOL ParseCmdLine(int argc, char **argv, char *ssapfile, char *pdbfile1,
+                  char *pdbfile2, char *outfile, char *outpdb1, 
+                  char *outpdb2, REAL *dcut, char *manifest,
+                  char *structfile, char *socketpath)
 {
-   ZONE *z;
-   int  i, j;
+   argc--;
+   argv++;
+
+   ssapfile[0] = pdbfile1[0] = pdbfile2[0] = 
+      outfile[0] = outpdb1[0] = outpdb2[0] = manifest[0] =
+      structfile[0] = socketpath[0] = '\0';
 
+   if(argc==0)
+      return(FALSE);
    
-   for(z=zones; z!=NULL; NEXT(z))
+   while(argc)
    {
-      if(z->start[0] < -9998)
-         continue;
-      
-      /* Look for the start of the zone                                 */
-      for(i=0; i<natom1; i++)
+      if(argv[0][0] == '-')
       {
-         if(idx1[i]->resnum == z->start[0])
+         switch(argv[0][1])
+         {
+         case 'd':
+            argc--;
+            argv++;
+            if(!argc ||
+               !(gNCuts = ParseCutoffs(argv[0], gCuts, SWEEP_MAXCUTS)))
+               return(FALSE);
+            *dcut = gCuts[0];
             break;
-      }
-      for(j=0; j<natom2; j++)
-      {
-         if(idx2[j]->resnum == z->start[1])
+         case 'w':
+            gWarmStart = TRUE;
             break;
-      }
-      
-      /* Step back from the start seeing if we are within the cutoff    */
-      i--; j--;
-      while(i>=0 && j>=0)
-      {
-         if((DISTSQ(idx1[i], idx2[j]) > cutsq) ||
-            (idx1[i]->bval > (REAL)5.0)        ||
-            (idx2[j]->bval > (REAL)5.0))
+         case 'p':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            strcpy(outpdb1, argv[0]);
             break;
-         else
-            idx1[i]->bval = idx2[j]->bval = (REAL)10.0;
-            
-         i--; j--;
-      }
-      i++; j++;
-
-      z->start[0] = idx1[i]->resnum;
-      z->start[1] = idx2[j]->resnum;
-      
-      /* Look for the end of the zone                                   */
-      for(i=0; i<natom1; i++)
-      {
-         if(idx1[i]->resnum == z->end[0])
+         case 'q':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            strcpy(outpdb2, argv[0]);
+            break;
+         case 'v':
+            gVerbose = TRUE;
+            break;
+         case 'i':
+            gOptions.initialCut = TRUE;
+            break;
+         case 'n':
+            gOptions.randomCoil = TRUE;
+            break;
+         case 's':
+            gSuperpose = TRUE;
+            break;
+         case 'f':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            if(!strcmp(argv[0], "qcp"))
+               gOptions.backend = FITBACKEND_QCP;
+            else if(!strcmp(argv[0], "matfit"))
+               gOptions.backend = FITBACKEND_MATFIT;
+            else
+               return(FALSE);
+            break;
+         case 'r':
+            gOptions.single = TRUE;
+            break;
+         case 'c':
+            gOptions.single = gCheckSingle = TRUE;
+            break;
+         case 'k':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            gOptions.cachedir = argv[0];
+            break;
+         case 'l':
+            argc--;
+            argv++;
+            if(!argc || !sscanf(argv[0],"%d",&gCacheMB) || (gCacheMB < 0))
+               return(FALSE);
+            break;
+         case 'b':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            strcpy(manifest, argv[0]);
+            break;
+         case 'a':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            strcpy(structfile, argv[0]);
+            break;
+         case 'u':
+            argc--;
+            argv++;
+            if(!argc)
+               return(FALSE);
+            strcpy(socketpath, argv[0]);
+            break;
+         case 't':
+            argc--;
+            argv++;
+            if(!argc || !sscanf(argv[0],"%d",&gThreads) || (gThreads < 1))
+               return(FALSE);
+            break;
+         default:
+            return(FALSE);
             break;
+         }
       }
-      for(j=0; j<natom2; j++)
+      else if(structfile[0] && !manifest[0])
       {
-         if(idx2[j]->resnum == z->end[1])
-            break;
+         /* All-vs-all takes just the SSAP directory                    */
+         if((argc != 1) || (gNCuts > 1))
+            return(FALSE);
+         strcpy(ssapfile, argv[0]);
+         return(!outpdb1[0] && !outpdb2[0] && !socketpath[0]);
       }
-      
-      /* Step forward from the end seeing if we are within the cutoff   */
-      i++; j++;
-      while(i<natom1 && j<natom2)
+      else
       {
-         if((DISTSQ(idx1[i], idx2[j]) > cutsq) ||
-            (idx1[i]->bval > (REAL)5.0)        ||
-            (idx2[j]->bval > (REAL)5.0))
-            break;
-         else
-            idx1[i]->bval = idx2[j]->bval = (REAL)10.0;
-         i++; j++;
+         /* Check that there are only 3 or 4 arguments left. A sweep
+            over several cutoffs can't write PDB files
+         */
+         if(argc < 3 || argc > 4 || manifest[0] || structfile[0] ||
+            socketpath[0] ||
+            ((gNCuts > 1) && (outpdb1[0] || outpdb2[0])))
+            return(FALSE);
+         
+         /* Copy the first three                                        */
+         strcpy(ssapfile, argv[0]);
+         strcpy(pdbfile1, argv[1]);
+         strcpy(pdbfile2, argv[2]);
+         
+         /* If there's another, copy it to outfile                      */
+         argc -= 3;
+         argv += 3;
+         if(argc)
+            strcpy(outfile, argv[0]);
+            
+         return(TRUE);
       }
-      i--; j--;
-      
-      z->end[0] = idx1[i]->resnum;
-      z->end[1] = idx2[j]->resnum;
+      argc--;
+      argv++;
    }
+   
+   /* All-vs-all needs the SSAP directory or a manifest. In batch and
+      server mode the output PDB files are given for each job and there
+      is only one cutoff
+   */
+   if(gNCuts > 1)
+      return(FALSE);
+   if(socketpath[0])
+      return(!manifest[0] && !structfile[0] &&
+             !outpdb1[0] && !outpdb2[0]);
+   if(structfile[0] && !manifest[0])
+      return(FALSE);
+   return(!manifest[0] || (!outpdb1[0] && !outpdb2[0]));
 }
 
+
 /************************************************************************/
-/*>void SetBValByZone(PDB *pdb, ZONE *zones, int which)
-   ----------------------------------------------------
-   Set B-values to 10 if in the zones, otherwise to 0.0
+/*>BOOL DefineCore(FILE *outfp, FILE *errfp, PDB *pdb1, PDB *pdb2,
+                   ZONELIST *zones, REAL dcut, BOOL single,
+                   BOOL verbose, BOOL superpose)
+   ---------------------------------------------------------------
+   Input:   FILE      *outfp     Output file for verbose reports
+            FILE      *errfp     Output file for errors and warnings
+            PDB       *pdb1      First structure
+            PDB       *pdb2      Second structure (moved if superpose)
+            ZONELIST  *zones     Starting zones; the core on return
+            REAL      dcut       Cutoff for defining core
+            BOOL      single     Work in single precision
+            BOOL      verbose    Report intermediate zones
+            BOOL      superpose  Fit pdb2 onto pdb1 using the core
+   Returns: BOOL                 Success
+
+   Main routine to do core definition
 
    14.11.96 Original   By: ACRM
+   06.12.96 Added handling of gInitialCut
+   16.10.26 Fitting is done from running sums which are updated as pairs
+            enter or leave the core. Falls back to rebuilding the sums
+            each time if the flagged residues can't be paired off
+            through the zones. Now frees its working copies.
+   16.10.26 Works on C-alpha stores rather than copies of the PDB lists
+   16.10.26 Applies the final fit to pdb2 if gSuperpose is set
+   16.10.26 Reports the core RMSD in verbose mode
+   16.10.26 Builds single precision stores if gSingle is set
+   16.10.26 The work is done by the shared core engine
+   16.10.26 Takes single, verbose and superpose rather than using the
+            globals so that batch jobs can run at the same time
+   16.10.26 The work is done by fcDefineCore()
+   16.10.26 Takes errfp so that batch job messages go to the job
+   16.10.26 Fails if a zone end has no C-alpha
+   16.10.26 Gives no RMSD for an empty core
 */
-void SetBValByZone(PDB *pdb, ZONE *zones, int which)
+BOOL DefineCore(FILE *outfp, FILE *errfp, PDB *pdb1, PDB *pdb2,
+                ZONELIST *zones, REAL dcut, BOOL single, BOOL verbose,
+                BOOL superpose)
 {
-   PDB  *p;
-   ZONE *z;
-
-   for(p=pdb; p!=NULL; NEXT(p))
-      p->bval = (REAL)0.0;
-   
-   for(p=pdb; p!=NULL; NEXT(p))
+   FCOPTIONS opts;
+   PDB       *pdb[2];
+   REAL      rmsd[2];
+   int       npairs[2],
+             status;
+
+   opts           = gOptions;
+   opts.single    = single;
+   opts.superpose = superpose;
+   if(verbose)
    {
-      for(z=zones; z!=NULL; NEXT(z))
-      {
-         if((p->resnum >= z->start[which]) &&
-            (p->resnum <= z->end[which]))
-            p->bval = (REAL)10.0;
-      }
+      opts.cutReport = ReportCut;
+      opts.reportArg = (void *)outfp;
    }
-}
-
-
-/************************************************************************/
-/*>BOOL FitCaPDBBFlag(PDB *ref_pdb, PDB *fit_pdb, REAL rm[3][3])
-   -------------------------------------------------------------
-   Input:   PDB  *ref_pdb     Reference PDB linked list
-   I/O:     PDB  *fit_pdb     Mobile PDB linked list
-   Output:  REAL rm[3][3]     Rotation matrix (May be input as NULL).
-   Returns: BOOL              Success
 
-   Fits two PDB linked lists using only the CA atoms of residues
-   flagged in the BVal column with a non-zero BValue (atoms not to be 
-   fitted have BVal set to 0).
+   pdb[0] = pdb1;
+   pdb[1] = pdb2;
+   if((status = fcDefineCore(&opts, pdb, 2, zones, dcut, rmsd, npairs))
+      == FC_NOMEM)
+   {
+      fprintf(errfp,"No memory for finding the core\n");
+      return(FALSE);
+   }
+   if(status == FC_BADZONE)
+   {
+      fprintf(errfp,"SSAP zone starts or ends at a residue with no \
+C-alpha\n");
+      return(FALSE);
+   }
 
-   Actually fits fit_pdb onto ref_pdb and also returns the rotation 
-   matrix. This may be NULL if these data are not required.
+   if(status == FC_MAXITER)
+      fprintf(errfp,"Warning: Maximum number of iterations (%d) \
+exceeded!\n",CORE_MAXITER);
 
-   14.11.96 Original based on FitCaPDB()   By: ACRM
-*/
-BOOL FitCaPDBBFlag(PDB *ref_pdb, PDB *fit_pdb, REAL rm[3][3])
-{
-   REAL  RotMat[3][3];
-   COOR  *ref_coor   = NULL,
-         *fit_coor   = NULL;
-   VEC3F ref_ca_CofG,
-         fit_ca_CofG,
-         tvect;
-   int   NCoor       = 0,
-         i, j;
-   BOOL  RetVal;
-   PDB   *ref_ca_pdb = NULL,
-         *fit_ca_pdb = NULL;
-
-   /* First extract only the CA atoms of residues where BVal > 0.5      */
-   if((ref_ca_pdb = DupeCAByBVal(ref_pdb))==NULL)
-      RetVal = FALSE;
-   if((fit_ca_pdb = DupeCAByBVal(fit_pdb))==NULL)
-      RetVal = FALSE;
-   
-   /* If we succeeded in building our CA PDB linked lists...            */
-   if(RetVal)
+   if(verbose)
    {
-      /* Get the CofG of the CA structures and the original mobile      */
-      blGetCofGPDB(ref_ca_pdb, &ref_ca_CofG);
-      blGetCofGPDB(fit_ca_pdb, &fit_ca_CofG);
-      
-      /* Move them both to the origin                                   */
-      blOriginPDB(ref_ca_pdb);
-      blOriginPDB(fit_ca_pdb);
-      
-      /* Create coordinate arrays, checking numbers match               */
-      NCoor = blGetPDBCoor(ref_ca_pdb, &ref_coor);
-      if(blGetPDBCoor(fit_ca_pdb, &fit_coor) != NCoor)
-      {
-         RetVal = FALSE;
-      }
+      if(npairs[1])
+         fprintf(outfp,"\nCore RMSD: %.3f over %d pairs\n",
+                 rmsd[1], npairs[1]);
       else
-      {
-         /* Can't fit with fewer than 3 coordinates                     */
-         if(NCoor < 3)
-         {
-            RetVal = FALSE;
-         }
-         else
-         {
-            /* Everything OK, go ahead with the fitting                 */
-            if(!blMatfit(ref_coor,fit_coor,RotMat,NCoor,NULL,FALSE))
-            {
-               RetVal = FALSE;
-            }
-            else
-            {
-               /* Apply the operations to the true coordinates          */
-               tvect.x = (-fit_ca_CofG.x);
-               tvect.y = (-fit_ca_CofG.y);
-               tvect.z = (-fit_ca_CofG.z);
-               blTranslatePDB(fit_pdb, tvect);
-               blApplyMatrixPDB(fit_pdb, RotMat);
-               blTranslatePDB(fit_pdb, ref_ca_CofG);
-            }
-         }
-      }
-   }
-   
-   /* Free the coordinate arrays and CA PDB linked lists                */
-   if(ref_coor)   free(ref_coor);
-   if(fit_coor)   free(fit_coor);
-   if(ref_ca_pdb) FREELIST(ref_ca_pdb, PDB);
-   if(fit_ca_pdb) FREELIST(fit_ca_pdb, PDB);
-         
-   /* Fill in the rotation matrix for output, if required               */
-   if(RetVal && (rm!=NULL))
-   {
-      for(i=0; i<3; i++)
-         for(j=0; j<3; j++)
-            rm[i][j] = RotMat[i][j];
+         fprintf(outfp,"\nCore RMSD: none, the core is empty\n");
    }
 
-   return(RetVal);
+   return(TRUE);
 }
 
 
 /************************************************************************/
-/*>int CountCore(PDB *pdb)
-   -----------------------
-   Count how many residues are in the core regions
+/*>void ReportCut(void *arg, ZONELIST *zones)
+   ------------------------------------------
+   Input:   void     *arg       Output file
+            ZONELIST *zones     Zones after the initial cut
 
-   14.11.96 Original   By: ACRM
+   Verbose report from fcDefineCore() after the initial cut
+
+   06.12.96 Original (as part of DefineCore())   By: ACRM
+   16.10.26 Split out as a libfindcore callback
 */
-int CountCore(PDB *pdb)
+void ReportCut(void *arg, ZONELIST *zones)
 {
-   PDB *p;
-   int count = 0;
-   
-   for(p=pdb; p!=NULL; NEXT(p))
-      if(p->bval > (REAL)0.0)
-         count++;
-   
-   return(count);
+   FILE *outfp = (FILE *)arg;
+
+   fprintf(outfp,"\nCore after removing residues > 3.0A:\n");
+   WriteTextOutput(outfp, zones);
 }
 
 
 /************************************************************************/
-/*>PDB *DupeCAByBVal(PDB *pdb)
-   ---------------------------
-   Extract the CAs with BVal > 0.0 from a PDB linked list into a new
-   linked list
-
-   14.11.96 Original   By: ACRM
+/*>ZONELIST *DoubleCore(FILE *errfp, PDB *pdb1, PDB *pdb2,
+                        ZONELIST *zones, REAL dcut)
+   ------------------------------------------------------
+   Input:   FILE      *errfp    Output file for errors
+            PDB       *pdb1     First structure
+            PDB       *pdb2     Second structure
+            ZONELIST  *zones    Starting zones (not changed)
+            REAL      dcut      Cutoff for defining core
+   Returns: ZONELIST  *         Merged core zones found in double
+                                precision (NULL on failure)
+
+   Finds the core from a copy of the starting zones in double precision
+   so the single precision result can be checked against it. Only
+   errors are printed and neither structure is moved.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Passes its settings to DefineCore() rather than changing
+            the globals
+   16.10.26 Reports its own errors to errfp and fails if the core
+            couldn't be found
 */
-PDB *DupeCAByBVal(PDB *pdb)
+ZONELIST *DoubleCore(FILE *errfp, PDB *pdb1, PDB *pdb2, ZONELIST *zones,
+                     REAL dcut)
 {
-   PDB *out = NULL, 
-       *p, *q;
-   
-   for(p=pdb; p!=NULL; NEXT(p))
+   ZONELIST *dzones;
+
+   if((dzones = DupZoneList(zones))==NULL)
    {
-      if(!strncmp(p->atnam,"CA  ",3) && (p->bval > (REAL)0.0))
-      {
-         if(out==NULL)
-         {
-            INIT(out,PDB);
-            q=out;
-         }
-         else
-         {
-            ALLOCNEXT(q,PDB);
-         }
-         if(q==NULL)
-         {
-            FREELIST(out,PDB);
-            return(NULL);
-         }
-         
-         blCopyPDB(q,p);
-      }
+      fprintf(errfp,"No memory for double precision check\n");
+      return(NULL);
    }
 
-   return(out);
-}
+   if(!DefineCore(stdout, errfp, pdb1, pdb2, dzones, dcut, FALSE, FALSE,
+                  FALSE))
+   {
+      FreeZoneList(dzones);
+      return(NULL);
+   }
 
+   if(!MergeZones(dzones))
+   {
+      fprintf(errfp,"No memory for double precision check\n");
+      FreeZoneList(dzones);
+      return(NULL);
+   }
 
+   return(dzones);
+}
 
 
 /************************************************************************/
-/*>void WriteTextOutput(FILE *fp, ZONE *zones)
-   -------------------------------------------
+/*>void WriteTextOutput(FILE *fp, ZONELIST *zones)
+   -----------------------------------------------
    Writes the zones out in text format
 
    14.11.96 Original   By: ACRM
    06.12.96 Added check that zones have not been blanked out
 */
-void WriteTextOutput(FILE *fp, ZONE *zones)
+void WriteTextOutput(FILE *fp, ZONELIST *zones)
 {
-   ZONE *z;
+   int  z;
    
-   for(z=zones; z!=NULL; NEXT(z))
+   for(z=0; z<zones->nzones; z++)
    {
-      if(z->start[0] > -9999)
+      if(!ZONEDELETED(zones, z))
       {
          fprintf(fp,"%d-%d : %d-%d\n",
-                 z->start[0],z->end[0],
-                 z->start[1],z->end[1]);
+                 ZSTART(zones, z, 0),ZEND(zones, z, 0),
+                 ZSTART(zones, z, 1),ZEND(zones, z, 1));
       }
    }
 }
@@ -1022,22 +2341,63 @@ void WriteTextOutput(FILE *fp, ZONE *zones)
    23.01.97 V1.2
    26.06.02 V1.4
    05.11.25 V1.5
+   16.10.26 V1.6
+   16.10.26 V1.7
+   16.10.26 V1.8
+   16.10.26 V1.9
+   16.10.26 V1.10
+   16.10.26 V1.11 Added -s
+   16.10.26 V1.12
+   16.10.26 V1.13 Added -f
+   16.10.26 V1.14 Added -r and -c
+   16.10.26 V1.15
+   16.10.26 V1.18 Added -k
+   16.10.26 V1.19 Added -b and -t
+   16.10.26 V1.20 Added -a
+   16.10.26 V1.21 Added -u
+   16.10.26 V1.22
+   16.10.26 V1.23 Added -l
+   16.10.26 V1.24 Added -w. -d takes a list or range
 */
 void Usage(void)
 {
-   fprintf(stderr,"\nFindCore V1.5 (c) 1996-2025, Prof. Andrew C.R. Martin, \
+   fprintf(stderr,"\nFindCore V1.24 (c) 1996-2026, Prof. Andrew C.R. Martin, \
 UCL.\n");
 
    fprintf(stderr,"\nUsage: findcore [-p out1.pdb] [-q out2.pdb] [-d \
-dcut] [-v] [-i]\n");
+dcut] [-v] [-i] [-s]\n");
+   fprintf(stderr,"                [-f matfit|qcp] [-r] [-c] [-k \
+cachedir]\n");
    fprintf(stderr,"                ssapfile in1.pdb in2.pdb \
 [output.lis]\n");
+   fprintf(stderr,"       findcore -d dcuts [-w] [-t nthreads] [-v] \
+[-i] [-f matfit|qcp] [-r] [-c]\n");
+   fprintf(stderr,"                [-k cachedir] ssapfile in1.pdb \
+in2.pdb [output.lis]\n");
+   fprintf(stderr,"       findcore [-d dcut] [-v] [-i] [-s] [-f \
+matfit|qcp] [-r] [-c]\n");
+   fprintf(stderr,"                [-k cachedir] [-l mbytes] [-t \
+nthreads] -b manifest\n");
+   fprintf(stderr,"       findcore [-d dcut] [-v] [-i] [-f matfit|qcp] \
+[-r] [-c] [-k cachedir]\n");
+   fprintf(stderr,"                [-t nthreads] -a structures.lst \
+[-b manifest | ssapdir]\n");
+   fprintf(stderr,"       findcore [-d dcut] [-v] [-i] [-f matfit|qcp] \
+[-r] [-c] [-k cachedir]\n");
+   fprintf(stderr,"                [-l mbytes] [-t nthreads] -u \
+socket\n");
    fprintf(stderr,"       -p       Write in1.pdb with core flagged in \
 B-value column\n");
    fprintf(stderr,"       -q       Write in2.pdb with core flagged in \
 B-value column\n");
    fprintf(stderr,"       -d       Specify distance cutoff for defining \
 core [%f]\n",DEFAULT_CUT);
+   fprintf(stderr,"                or a list (1.5,2.0,3.0) or range \
+(1.5:4.0:0.5) of them;\n");
+   fprintf(stderr,"                see below\n");
+   fprintf(stderr,"       -w       Warm start. Start the core at each \
+cutoff of a list from\n");
+   fprintf(stderr,"                the core at the cutoff below\n");
    fprintf(stderr,"       -v       Verbose mode; shows intermediate \
 zones\n");
    fprintf(stderr,"       -i       Initial cut. Do an initial fit and \
@@ -1046,11 +2406,45 @@ remove any pairs\n");
    fprintf(stderr,"       -n       Include non-E/H regions which match \
 in the initial\n");
    fprintf(stderr,"                definition of core zones\n");
+   fprintf(stderr,"       -s       Superpose. The file written by -q is \
+fitted onto in1.pdb\n");
+   fprintf(stderr,"                using the final core\n");
+   fprintf(stderr,"       -f       Fitting method: matfit (BiopLib \
+blMatfit(), the default)\n");
+   fprintf(stderr,"                or qcp (quaternion characteristic \
+polynomial)\n");
+   fprintf(stderr,"       -r       Reduced precision. Hold coordinates \
+and test distances in\n");
+   fprintf(stderr,"                single precision\n");
+   fprintf(stderr,"       -c       As -r but also find the core in \
+double precision and list\n");
+   fprintf(stderr,"                any zones which differ on \
+stderr\n");
+   fprintf(stderr,"       -k       Keep the C-alphas of the PDB files in \
+a binary cache in\n");
+   fprintf(stderr,"                this directory, so later runs needn't \
+parse them\n");
+   fprintf(stderr,"       -b       Batch mode. Run each job in the \
+manifest file (- for\n");
+   fprintf(stderr,"                standard input); see below\n");
+   fprintf(stderr,"       -t       Number of batch, server or cutoff \
+jobs to run at once [1]\n");
+   fprintf(stderr,"       -a       All-vs-all. Read each PDB file in \
+structures.lst once\n");
+   fprintf(stderr,"                and find the core of every pair, or \
+of each job in the\n");
+   fprintf(stderr,"                manifest; see below\n");
+   fprintf(stderr,"       -u       Server mode. Take jobs on this Unix \
+domain socket; see\n");
+   fprintf(stderr,"                below\n");
+   fprintf(stderr,"       -l       Memory for keeping structures between \
+batch or server\n");
+   fprintf(stderr,"                jobs, in Mbytes [%d]\n",
+           STRCACHE_DEFAULTMB);
    fprintf(stderr,"       ssapfile A vertical alignment file from \
 SSAP\n");
 
 
-
    fprintf(stderr,"\nFindCore defines a protein structurally conserved \
 core according to the\n");
    fprintf(stderr,"method of Chothia (1996). Structurally equivalent \
@@ -1069,158 +2463,61 @@ SSAP.\n\n");
    fprintf(stderr,"The PDB files should be given in the same order as \
 the columns appear\n");
    fprintf(stderr,"in the SSAP file.\n\n");
-}
-
-
-
-/************************************************************************/
-/*>ZONE *MergeZones(ZONE *zones)
-   -----------------------------
-   Merges zones in the zone linked list of they overlap and removes zones
-   which are subsets of other zones
-
-   14.11.96 Original   By: ACRM
-   06.12.96 Removes zones marked for deletion
-   13.03.97 Added merging of abutting zones (required since change to
-            zone creation where residues not added to a zone if they
-            are already in another zone stops them from being subsets)
-   26.06.02 Fixed bug in deleting zones
-*/
-ZONE *MergeZones(ZONE *zones)
-{
-   ZONE *z, *zt;
-   BOOL finished = FALSE;
-
-   /* Remove null zones                                                 */
-   while(zones->start[0] < -9998)
-      zones = zones->next;
-   for(z=zones;z!=NULL;NEXT(z))
-   {
-      if(z->start[0] < -9998)
-      {
-         ZONE *prev;
-         
-         z->prev->next = z->next;
-         if(z->next != NULL)
-            z->next->prev = z->prev;
-         prev = z->prev;
-         free(z);
-         z = prev;
-      }
-   }
-
-   /* First merge overlapping zones                                     */
-   while(!finished)
-   {
-      finished = TRUE;
-      for(z=zones; z->next!=NULL; NEXT(z))
-      {
-         if((z->end[0] >= z->next->start[0]) ||
-            (z->end[1] >= z->next->start[1]))
-         {
-            if((z->end[0] != z->next->end[0]) &&
-               (z->end[1] != z->next->end[1]))
-            {
-               finished = FALSE;
-               z->end[0] = z->next->end[0];
-               z->end[1] = z->next->end[1];
-            }
-         }
-      }
-   }
-
-   /* Now remove redundant zones                                        */
-   finished = FALSE;
-   while(!finished)
-   {
-      finished = TRUE;
-      for(z=zones; z!=NULL; NEXT(z))
-      {
-         if(SubsetZone(z, zones))
-         {
-            if(z==zones)
-            {
-               zones=zones->next;
-               zones->prev=NULL;
-            }
-            else
-            {
-               z->prev->next = z->next;
-               if(z->next != NULL)
-                  z->next->prev = z->prev;
-            }
-            zt=z->prev;
-            free(z);
-            z=zt;
-
-            finished = FALSE;
-            break;
-         }
-      }
-   }
-
-   /* Now merge abutting zones                                          */
-   finished = FALSE;
-   while(!finished)
-   {
-      finished = TRUE;
-      for(z=zones; z->next!=NULL; NEXT(z))
-      {
-         /* If these two zones are both abutting                        */
-         if((z->end[0]+1 == z->next->start[0]) &&
-            (z->end[1]+1 == z->next->start[1]))
-         {
-            /* Reset start of second zone to start of first zone        */
-            z->next->start[0] = z->start[0];
-            z->next->start[1] = z->start[1];
-            
-            /* Remove z from the linked list                            */
-            if(z==zones)
-            {
-               zones=zones->next;
-               zones->prev=NULL;
-            }
-            else
-            {
-               z->prev->next = z->next;
-               if(z->next != NULL)
-                  z->next->prev = z->prev;
-            }
-            zt=z->prev;
-            free(z);
-            z=zt;
-
-            finished = FALSE;
-         }
-      }
-      
-   }
-   
-   return(zones);
-}
-
-/************************************************************************/
-/*>BOOL SubsetZone(ZONE *z, ZONE *zones)
-   -------------------------------------
-   Sees whether a zones is a zubset of another zone
-
-   14.11.96 Original   By: ACRM
-*/
-BOOL SubsetZone(ZONE *z, ZONE *zones)
-{
-   ZONE *z1;
-   
-   for(z1=zones; z1!=NULL; NEXT(z1))
-   {
-      if(z1 != z)
-      {
-         if((z->start[0] >= z1->start[0]) &&
-            (z->end[0]   <= z1->end[0]))
-            return(TRUE);
-      }
-   }
 
-   return(FALSE);
+   fprintf(stderr,"With more than one cutoff, the structures and SSAP \
+file are read once and\n");
+   fprintf(stderr,"the core is found at each cutoff, -t at a time. The \
+zones are written in\n");
+   fprintf(stderr,"the order the cutoffs were given, each block headed \
+by 'Cutoff dcut:'. With\n");
+   fprintf(stderr,"-w the cutoffs are split into up to -t runs of \
+increasing cutoff, each of at\n");
+   fprintf(stderr,"least two, and each starts from the core found at \
+the one before, which is\n");
+   fprintf(stderr,"quicker but may give a different core from starting \
+with the SSAP zones. -p\n");
+   fprintf(stderr,"and -q can't be used with a list.\n\n");
+
+   fprintf(stderr,"In batch mode each line of the manifest is a \
+job:\n");
+   fprintf(stderr,"   ssapfile in1.pdb in2.pdb [dcut [output.lis \
+[out1.pdb [out2.pdb]]]]\n");
+   fprintf(stderr,"A - for dcut gives the cutoff from -d and a - for \
+a file means no file.\n");
+   fprintf(stderr,"Blank lines and lines starting with # are ignored. \
+Zones of jobs with no\n");
+   fprintf(stderr,"output.lis are written to standard output in \
+manifest order, each headed\n");
+   fprintf(stderr,"by 'Job n: ssapfile in1.pdb in2.pdb'. Errors are \
+headed the same way.\n");
+   fprintf(stderr,"Structures are kept between jobs, within the memory \
+given by -l, and read\n");
+   fprintf(stderr,"again if the file changes. With -v the use made of \
+them is reported at\n");
+   fprintf(stderr,"the end.\n\n");
+
+   fprintf(stderr,"With -a, structures.lst gives one PDB file per line. \
+Without a manifest\n");
+   fprintf(stderr,"each pair is taken once in list order, with its \
+alignment in\n");
+   fprintf(stderr,"ssapdir/stem1_stem2.ssap where the stems are the PDB \
+file names without\n");
+   fprintf(stderr,"directory or extension. With a manifest, in1.pdb and \
+in2.pdb must be in\n");
+   fprintf(stderr,"structures.lst and out1.pdb and out2.pdb can't be \
+given.\n\n");
+
+   fprintf(stderr,"With -u, findcore runs until sent SIGINT or SIGTERM. \
+Each line sent on a\n");
+   fprintf(stderr,"connection is a job as in a manifest (file names are \
+relative to the\n");
+   fprintf(stderr,"server's directory). The reply is a line 'status nout \
+nerr' followed by\n");
+   fprintf(stderr,"nout bytes of zones, as findcore would write them, and \
+nerr bytes of\n");
+   fprintf(stderr,"error messages. Structures are kept between jobs as \
+in batch mode. The\n");
+   fprintf(stderr,"options apply to every job.\n\n");
 }
 
 
@@ -0,0 +1,624 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       libfindcore.c
+
+   Version:    V1.2
+   Date:       16.10.26
+   Function:   Core finding library for linking into other programs
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Description:
+   ============
+   The steps of findcore and findcora for programs which want to find
+   cores without running them: read the structures, seed the zones
+   from a SSAP, CORA or ProFit alignment, find the core and get the
+   zones back.
+
+   Nothing here prints, exits or keeps any state between calls. All
+   the settings are in an FCOPTIONS passed in, and problems are
+   returned as FC_... status codes (fcStatusMessage() gives the text),
+   so the routines may be called from any number of threads at once
+   as long as each has its own zones.
+
+   The one exception is BiopLib's blReadPDB(), which sets globals as
+   it reads. fcLoadStructures() only calls it through ReadPDBSerial()
+   (pdbload.c), which holds a lock, so a program reading PDB files
+   itself while other threads load structures must use that too.
+
+**************************************************************************
+
+   Usage:
+   ======
+   FCOPTIONS opts;
+   PDB       *pdb[2];
+   ZONELIST  *zones;
+   int       bad;
+
+   fcDefaultOptions(&opts);
+   if(((status = fcLoadStructures(&opts, files, 2, TRUE, pdb, &bad))
+       == FC_OK) &&
+      ((status = fcReadSSAP(&opts, ssapfp, &zones)) == FC_OK))
+   {
+      status = fcFindCore(&opts, pdb, 2, zones, 3.0, NULL, NULL);
+      ...
+   }
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original. The SSAP reading is taken from findcore
+                  V1.21 and the core definition from findcore and
+                  findcora
+   V1.1  16.10.26 fcDefineCore() rejects zones which start or end at a
+                  residue with no C-alpha
+   V1.2  16.10.26 fcDefineCore() gives no pairs for an empty core
+                  rather than the RMSD of the starting zones
+
+*************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+#include "bioplib/pdb.h"
+#include "bioplib/macros.h"
+#include "bioplib/fsscanf.h"
+#include "coreeng.h"
+#include "castore.h"
+#include "pdbload.h"
+#include "libfindcore.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define MAXBUFF 160
+
+/************************************************************************/
+/* Prototypes
+*/
+static int strlen_nospace(char *str);
+static int *CAResnums(PDB *pdb, int *nca);
+
+
+/************************************************************************/
+/*>void fcDefaultOptions(FCOPTIONS *opts)
+   --------------------------------------
+   Output:  FCOPTIONS *opts     Options as findcore uses with no flags
+
+   16.10.26 Original   By: ACRM
+*/
+void fcDefaultOptions(FCOPTIONS *opts)
+{
+   opts->initialCut = FALSE;
+   opts->randomCoil = FALSE;
+   opts->single     = FALSE;
+   opts->consensus  = FALSE;
+   opts->superpose  = FALSE;
+   opts->backend    = FITBACKEND_MATFIT;
+   opts->test       = CATEST_PAIRS;
+   opts->cachedir   = NULL;
+   opts->pool       = NULL;
+   opts->cutReport  = NULL;
+   opts->reportArg  = NULL;
+}
+
+
+/************************************************************************/
+/*>char *fcStatusMessage(int status)
+   ---------------------------------
+   Input:   int    status       FC_... status code
+   Returns: char   *            What it means
+
+   16.10.26 Original   By: ACRM
+*/
+char *fcStatusMessage(int status)
+{
+   switch(status)
+   {
+   case FC_OK:
+      return("Success");
+   case FC_NOMEM:
+      return("No memory");
+   case FC_NOFILE:
+      return("Unable to open file");
+   case FC_NOATOMS:
+      return("No atoms read from PDB file");
+   case FC_NOZONES:
+      return("No zones read from alignment");
+   case FC_BADZONE:
+      return("Zone end has no C-alpha in the structure");
+   case FC_MAXITER:
+      return("Maximum number of iterations exceeded");
+   }
+   return("Unknown status");
+}
+
+
+/************************************************************************/
+/*>int fcLoadStructures(FCOPTIONS *opts, char **filenames, int nstruc,
+                        BOOL caOnly, PDB **pdb, int *bad)
+   -------------------------------------------------------------------
+   Input:   FCOPTIONS *opts       Options (for the cache and threads)
+            char      **filenames PDB files
+            int       nstruc      Number of files
+            BOOL      caOnly      Only the C-alphas are needed
+   Output:  PDB       **pdb       The structures
+            int       *bad        File which couldn't be read (or -1)
+   Returns: int                   FC_OK, FC_NOMEM, FC_NOFILE or
+                                  FC_NOATOMS
+
+   Reads the structures on opts->pool. If any file couldn't be read
+   the first is given in *bad and every structure is freed again.
+
+   16.10.26 Original   By: ACRM
+*/
+int fcLoadStructures(FCOPTIONS *opts, char **filenames, int nstruc,
+                     BOOL caOnly, PDB **pdb, int *bad)
+{
+   int *natoms,
+       status = FC_OK,
+       s;
+
+   *bad = -1;
+   if((natoms = (int *)malloc(nstruc * sizeof(int)))==NULL)
+      return(FC_NOMEM);
+
+   if(!LoadPDBFiles(filenames, nstruc, caOnly, opts->cachedir, pdb,
+                    natoms, opts->pool))
+   {
+      for(s=0; s<nstruc; s++)
+      {
+         if(natoms[s] == PDBLOAD_NOFILE)
+            status = FC_NOFILE;
+         else if(pdb[s] == NULL)
+            status = FC_NOATOMS;
+         if(status != FC_OK)
+         {
+            *bad = s;
+            break;
+         }
+      }
+      fcFreeStructures(pdb, nstruc);
+   }
+
+   free(natoms);
+   return(status);
+}
+
+
+/************************************************************************/
+/*>void fcFreeStructures(PDB **pdb, int nstruc)
+   --------------------------------------------
+   I/O:     PDB    **pdb        Structures to free (each set to NULL)
+   Input:   int    nstruc       Number of structures
+
+   16.10.26 Original   By: ACRM
+*/
+void fcFreeStructures(PDB **pdb, int nstruc)
+{
+   int s;
+
+   for(s=0; s<nstruc; s++)
+      FREELIST(pdb[s], PDB);
+}
+
+
+/************************************************************************/
+/*>static int strlen_nospace(char *str)
+   ------------------------------------
+   Find the length of a string without any leading or trailing spaces
+
+   14.11.96 Original   By: ACRM
+   16.10.26 Moved from findcore
+*/
+static int strlen_nospace(char *str)
+{
+   char *s,
+        *e;
+   int  str_len;
+
+   for(s=str; *s==' ' || *s=='\t'; s++);
+   str_len = strlen(s);
+   for(e=s+str_len-1; *e==' ' || *e=='\t'; e--)
+      str_len--;
+   return(str_len);
+}
+
+
+/************************************************************************/
+/*>int fcReadSSAP(FCOPTIONS *opts, FILE *fp, ZONELIST **zones)
+   -----------------------------------------------------------
+   Input:   FCOPTIONS *opts     Options (randomCoil)
+            FILE      *fp       SSAP alignment file
+   Output:  ZONELIST  **zones   Zones of the two structures (NULL on
+                                failure)
+   Returns: int                 FC_OK, FC_NOMEM or FC_NOZONES
+
+   Read a SSAP alignment file into a set of zones showing residue
+   equivalences
+
+   14.11.96 Original (ReadSSAP() in findcore)   By: ACRM
+   23.01.97 Added gDoRandomCoil checking; swapped the logic round for
+            checking secondary structure matches to make this easier.
+   16.10.26 Zones are stored in a ZONELIST
+   16.10.26 Moved from findcore. Takes the options and returns a status
+*/
+int fcReadSSAP(FCOPTIONS *opts, FILE *fp, ZONELIST **zones)
+{
+   int  z,
+        resnum1, resnum2,
+        score,
+        start1 = 0, start2 = 0,
+        end1 = 0,   end2 = 0;
+   char buffer[MAXBUFF],
+        aa1, aa2, str1, str2;
+
+   if((*zones = NewZoneList(2))==NULL)
+      return(FC_NOMEM);
+
+
+   while(fgets(buffer,MAXBUFF,fp))
+   {
+      TERMINATE(buffer);
+      if(strlen_nospace(buffer))
+      {
+/* For older SSAP with no insert codes
+         fsscanf(buffer,"%3d%1x%c%1x%c%2x%3d%2x%c%1x%c%1x%3d",
+                 &resnum1, &str1, &aa1,
+                 &score,
+                 &aa2, &str2, &resnum2);
+*/
+         fsscanf(buffer,"%3d%1x%c%3x%c%2x%3d%2x%c%3x%c%1x%3d",
+                 &resnum1, &str1, &aa1,
+                 &score,
+                 &aa2, &str2, &resnum2);
+
+
+         /* If neither residue is an insert and both are E or both are H
+            or the -n flag has been set and neither are E or H then we
+            are in a zone so record this fact
+         */
+         if((aa1 != ' ') && (aa2 != ' ') &&
+            (((str1 == 'E') && (str2 == 'E')) ||
+             ((str1 == 'H') && (str2 == 'H')) ||
+             (opts->randomCoil &&
+              (str1 != 'E') && (str2 != 'E') &&
+              (str1 != 'H') && (str2 != 'H'))))
+         {
+            if(!start1 || !start2)
+            {
+               start1 = resnum1;
+               start2 = resnum2;
+            }
+            end1 = resnum1;
+            end2 = resnum2;
+         }
+         else /* We've come out of a zone; store the last one           */
+         {
+            if(start1 && start2)
+            {
+               z = (*zones)->nzones;
+               if(!InsertZone(*zones, z))
+               {
+                  FreeZoneList(*zones);
+                  *zones = NULL;
+                  return(FC_NOMEM);
+               }
+
+               ZSTART(*zones, z, 0) = start1;
+               ZSTART(*zones, z, 1) = start2;
+               ZEND(*zones, z, 0)   = end1;
+               ZEND(*zones, z, 1)   = end2;
+
+               start1 = start2 = 0;
+            }
+         }
+      }
+   }
+
+   if((*zones)->nzones == 0)
+   {
+      FreeZoneList(*zones);
+      *zones = NULL;
+      return(FC_NOZONES);
+   }
+
+   return(FC_OK);
+}
+
+
+/************************************************************************/
+/*>int fcReadCORA(FCOPTIONS *opts, FILE *fp, Malign **aln,
+                  ZONELIST **zones)
+   -------------------------------------------------------
+   Input:   FCOPTIONS *opts     Options (randomCoil)
+            FILE      *fp       CORA alignment file
+   Output:  Malign    **aln     The alignment, which names the PDB
+                                files (NULL on failure)
+            ZONELIST  **zones   Zones of every structure (NULL on
+                                failure)
+   Returns: int                 FC_OK, FC_NOMEM or FC_NOZONES
+
+   16.10.26 Original   By: ACRM
+*/
+int fcReadCORA(FCOPTIONS *opts, FILE *fp, Malign **aln,
+               ZONELIST **zones)
+{
+   *zones = NULL;
+   if((*aln = ReadCORA(fp)) == NULL)
+      return(FC_NOZONES);
+
+   if((*zones = calcZone(*aln, opts->randomCoil)) == NULL)
+   {
+      FreeMalign(*aln);
+      *aln = NULL;
+      return(FC_NOMEM);
+   }
+
+   return(FC_OK);
+}
+
+
+/************************************************************************/
+/*>static int *CAResnums(PDB *pdb, int *nca)
+   -----------------------------------------
+   Input:   PDB    *pdb         Structure
+   Output:  int    *nca         Number of C-alphas
+   Returns: int    *            Residue number of each C-alpha in turn
+                                (NULL if no memory)
+
+   16.10.26 Original   By: ACRM
+*/
+static int *CAResnums(PDB *pdb, int *nca)
+{
+   PDB *p;
+   int *resnum,
+       i = 0;
+
+   *nca = 0;
+   for(p=pdb; p!=NULL; NEXT(p))
+   {
+      if(!strncmp(p->atnam, "CA  ", 4))
+         (*nca)++;
+   }
+
+   if((resnum = (int *)malloc((*nca + 1) * sizeof(int)))==NULL)
+      return(NULL);
+
+   for(p=pdb; p!=NULL; NEXT(p))
+   {
+      if(!strncmp(p->atnam, "CA  ", 4))
+         resnum[i++] = p->resnum;
+   }
+
+   return(resnum);
+}
+
+
+/************************************************************************/
+/*>int fcReadProFit(FILE *fp, PDB **pdb, ZONELIST **zones)
+   -------------------------------------------------------
+   Input:   FILE      *fp       Zones cut from the ProFit status
+                                message
+            PDB       **pdb     The two structures
+   Output:  ZONELIST  **zones   Zones of the two structures (NULL on
+                                failure)
+   Returns: int                 FC_OK, FC_NOMEM, FC_NOZONES or
+                                FC_BADZONE
+
+   ProFit gives zones by sequential C-alpha number, counting from 1;
+   these are turned into residue numbers in each structure as the core
+   is found from those.
+
+   16.10.26 Original (from ReadProFitZones() and MapZones() in
+            profitcore)   By: ACRM
+*/
+int fcReadProFit(FILE *fp, PDB **pdb, ZONELIST **zones)
+{
+   char buffer[MAXBUFF],
+        junk[MAXBUFF];
+   int  *resnum[2],
+        nca[2],
+        pos[4],
+        status = FC_OK,
+        s, z;
+
+   *zones = NULL;
+   resnum[0] = CAResnums(pdb[0], &nca[0]);
+   resnum[1] = CAResnums(pdb[1], &nca[1]);
+   if((resnum[0] == NULL) || (resnum[1] == NULL) ||
+      ((*zones = NewZoneList(2))==NULL))
+   {
+      FREE(resnum[0]);
+      FREE(resnum[1]);
+      return(FC_NOMEM);
+   }
+
+   while((status == FC_OK) && fgets(buffer, MAXBUFF, fp))
+   {
+      if(sscanf(buffer, "%d %s %d %s %d %s %d",
+                &pos[0], junk, &pos[1], junk,
+                &pos[2], junk, &pos[3]) == 7)
+      {
+         for(s=0; s<4; s++)
+         {
+            if((pos[s] < 1) || (pos[s] > nca[s/2]))
+               status = FC_BADZONE;
+         }
+         if(status != FC_OK)
+            break;
+
+         z = (*zones)->nzones;
+         if(!InsertZone(*zones, z))
+         {
+            status = FC_NOMEM;
+            break;
+         }
+         for(s=0; s<2; s++)
+         {
+            ZSTART(*zones, z, s) = resnum[s][pos[2*s]   - 1];
+            ZEND(*zones, z, s)   = resnum[s][pos[2*s+1] - 1];
+         }
+      }
+   }
+
+   if((status == FC_OK) && ((*zones)->nzones == 0))
+      status = FC_NOZONES;
+   if(status != FC_OK)
+   {
+      FreeZoneList(*zones);
+      *zones = NULL;
+   }
+
+   free(resnum[0]);
+   free(resnum[1]);
+   return(status);
+}
+
+
+/************************************************************************/
+/*>int fcDefineCore(FCOPTIONS *opts, PDB **pdb, int nstruc,
+                    ZONELIST *zones, REAL dcut, REAL *rmsd,
+                    int *npairs)
+   --------------------------------------------------------
+   Input:   FCOPTIONS *opts     Options
+            PDB       **pdb     The structures (moved if
+                                opts->superpose is set)
+            int       nstruc    Number of structures
+            REAL      dcut      Cutoff for defining core
+   I/O:     ZONELIST  *zones    Starting zones; the core on return
+   Output:  REAL      *rmsd     Core RMSD of each structure from the
+                                first (or the mean). May be NULL
+            int       *npairs   Pairs fitted for each. May be NULL
+   Returns: int                 FC_OK, FC_NOMEM, FC_BADZONE or
+                                FC_MAXITER
+
+   Finds the core. The zones aren't merged, so some may overlap or be
+   marked as deleted; fcFindCore() also merges them. With FC_MAXITER
+   the zones, RMSDs and any superposition are from the last iteration.
+   Every zone must start and end at a residue with a C-alpha in each
+   structure; if not, FC_BADZONE is returned with the zones unchanged.
+   If the initial cut leaves no core, every npairs and rmsd is 0 and
+   nothing is moved.
+
+   14.11.96 Original (DefineCore() in findcore and findcora)   By: ACRM
+   06.12.96 Added handling of gInitialCut
+   16.10.26 Moved here from findcore and findcora. Takes the options
+            and returns a status
+   16.10.26 Checks the zone ends are C-alphas
+   16.10.26 An empty core has no pairs. Its sums weren't refitted after
+            the cut, so they were those of the starting zones
+*/
+int fcDefineCore(FCOPTIONS *opts, PDB **pdb, int nstruc,
+                 ZONELIST *zones, REAL dcut, REAL *rmsd, int *npairs)
+{
+   COREENGINE *ce;
+   int        status = FC_OK,
+              s;
+   BOOL       empty;
+
+   /* Copy the C-alphas into compact stores and set up the fitting     */
+   if((ce = NewCoreEngine(pdb, nstruc, zones, opts->single)) == NULL)
+      return(FC_NOMEM);
+   ce->pool      = opts->pool;
+   ce->consensus = opts->consensus;
+   ce->backend   = opts->backend;
+   ce->test      = opts->test;
+
+   /* The cut and extension look up the zone ends by residue number    */
+   for(s=0; s<nstruc; s++)
+   {
+      if(!ZoneEndsInStore(ce->cas[s], zones, s))
+      {
+         FreeCoreEngine(ce);
+         return(FC_BADZONE);
+      }
+   }
+
+   if(opts->initialCut)
+   {
+      FitAllCores(ce);
+      if(!DoCut(ce, zones, dcut*dcut))
+      {
+         FreeCoreEngine(ce);
+         return(FC_NOMEM);
+      }
+      if(opts->cutReport != NULL)
+         (*opts->cutReport)(opts->reportArg, zones);
+   }
+
+   if(!IterateCore(ce, zones, dcut*dcut))
+      status = FC_MAXITER;
+
+   /* Structures are fitted from 1 onto the first, or all onto the mean.
+      If nothing is left in the core there is no fit
+   */
+   empty = (CountCACore(ce->cas[0]) == 0);
+   for(s=0; s<nstruc; s++)
+   {
+      if(empty || ((s == 0) && !opts->consensus))
+      {
+         if(rmsd != NULL)
+            rmsd[s] = (REAL)0.0;
+         if(npairs != NULL)
+            npairs[s] = 0;
+         continue;
+      }
+      if(rmsd != NULL)
+         rmsd[s] = FitSumsRMSD(&(ce->sums[s]));
+      if(npairs != NULL)
+         npairs[s] = ce->sums[s].npairs;
+
+      /* Move the whole structure if the fitted coordinates are wanted
+      */
+      if(opts->superpose)
+         ApplyCAFitPDB(ce->cas[s], pdb[s]);
+   }
+
+   FreeCoreEngine(ce);
+
+   return(status);
+}
+
+
+/************************************************************************/
+/*>int fcFindCore(FCOPTIONS *opts, PDB **pdb, int nstruc,
+                  ZONELIST *zones, REAL dcut, REAL *rmsd, int *npairs)
+   -------------------------------------------------------------------
+   As fcDefineCore(), but then removes any zones which are subsets of
+   others and merges overlapping ones, so that zones is the final core.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Doesn't merge zones which were rejected
+*/
+int fcFindCore(FCOPTIONS *opts, PDB **pdb, int nstruc, ZONELIST *zones,
+               REAL dcut, REAL *rmsd, int *npairs)
+{
+   int status;
+
+   status = fcDefineCore(opts, pdb, nstruc, zones, dcut, rmsd, npairs);
+   if(((status == FC_OK) || (status == FC_MAXITER)) &&
+      !MergeZones(zones))
+      status = FC_NOMEM;
+
+   return(status);
+}
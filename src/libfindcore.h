@@ -0,0 +1,111 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       libfindcore.h
+
+   Version:    V1.1
+   Date:       16.10.26
+   Function:   Core finding library for linking into other programs
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 FC_BADZONE is also given for a zone which starts or
+                  ends at a residue with no C-alpha
+
+*************************************************************************/
+#ifndef _LIBFINDCORE_H
+#define _LIBFINDCORE_H
+
+/************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+#include "bioplib/pdb.h"
+#include "corefit.h"
+#include "distkern.h"
+#include "zonelist.h"
+#include "corafile.h"
+#include "pool.h"
+#include "pdbload.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+/* Status codes returned by the fc...() routines                        */
+#define FC_OK        0
+#define FC_NOMEM     1       /* Out of memory                           */
+#define FC_NOFILE    2       /* A file couldn't be opened               */
+#define FC_NOATOMS   3       /* No atoms were read from a PDB file      */
+#define FC_NOZONES   4       /* No zones were read from an alignment    */
+#define FC_BADZONE   5       /* A zone end has no C-alpha               */
+#define FC_MAXITER   6       /* The core hadn't settled after
+                                CORE_MAXITER iterations (the zones
+                                are still usable)                       */
+
+/* How the core is found. Everything a caller can set is here rather
+   than in globals, so any number of threads can each find cores with
+   their own options. Fill it in with fcDefaultOptions() and change
+   what's needed.
+
+   If cutReport is set it is called with reportArg and the zones
+   after the initial cut.
+*/
+typedef struct
+{
+   BOOL       initialCut,    /* Cut at the cutoff before extending      */
+              randomCoil,    /* Also take zones outside strands and
+                                helices from the alignment              */
+              single,        /* C-alphas in single precision            */
+              consensus,     /* Fit to the mean structure               */
+              superpose;     /* Move each structure onto the first (or
+                                the mean) by its final fit              */
+   int        backend,       /* FITBACKEND_MATFIT or _QCP               */
+              test;          /* CATEST_PAIRS or _CENTROID               */
+   char       *cachedir;     /* C-alpha cache for reading (or NULL)     */
+   THREADPOOL *pool;         /* Threads for reading and fitting
+                                (or NULL)                               */
+   void       (*cutReport)(void *reportArg, ZONELIST *zones);
+   void       *reportArg;
+}  FCOPTIONS;
+
+/************************************************************************/
+/* Prototypes
+
+   BiopLib's blReadPDB() isn't reentrant. fcLoadStructures() reads
+   through ReadPDBSerial() (pdbload.h), and a program which reads PDB
+   files in other threads at the same time must do so too.
+*/
+void fcDefaultOptions(FCOPTIONS *opts);
+char *fcStatusMessage(int status);
+int fcLoadStructures(FCOPTIONS *opts, char **filenames, int nstruc,
+                     BOOL caOnly, PDB **pdb, int *bad);
+void fcFreeStructures(PDB **pdb, int nstruc);
+int fcReadSSAP(FCOPTIONS *opts, FILE *fp, ZONELIST **zones);
+int fcReadCORA(FCOPTIONS *opts, FILE *fp, Malign **aln,
+               ZONELIST **zones);
+int fcReadProFit(FILE *fp, PDB **pdb, ZONELIST **zones);
+int fcDefineCore(FCOPTIONS *opts, PDB **pdb, int nstruc,
+                 ZONELIST *zones, REAL dcut, REAL *rmsd, int *npairs);
+int fcFindCore(FCOPTIONS *opts, PDB **pdb, int nstruc, ZONELIST *zones,
+               REAL dcut, REAL *rmsd, int *npairs);
+
+#endif
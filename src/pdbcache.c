@@ -0,0 +1,651 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       pdbcache.c
+
+   Version:    V1.1
+   Date:       16.10.26
+   Function:   Binary cache of the C-alphas of PDB files
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Description:
+   ============
+   Unless PDB files are being written, all that is used of a structure
+   is its C-alphas, yet every run parses the whole PDB file. When the
+   same structures go through many runs, the parsing can take longer
+   than finding the cores.
+
+   The C-alphas of each file read (every atom named CA, as selected by
+   BuildCAStore()) can therefore be kept in a binary cache file in a
+   cache directory. The cache file for a PDB file is named after the
+   file's base name and a hash of the path it was given by; it holds
+   that path and the size and modification time (to the nanosecond) of
+   the PDB file, and is only used if all three still match.
+
+   A cache file is written by ReadPDBToCache() the first time a PDB
+   file is read, and ReadCAPDBCache() memory maps it on later runs to
+   build a PDB linked list of just the C-alphas. Cache files are
+   written under a temporary name and renamed, so runs sharing a cache
+   directory never see half written files. Failing to write a cache
+   file is not an error; the PDB file is just parsed again next time.
+
+   A cache file is only for the machine that wrote it; one written
+   with a different byte order or type sizes is ignored and replaced.
+
+   Cache file layout (every section starts on a CACHE_ALIGN boundary)
+      CACHEHEADER
+      char  path[pathlen]             Path the PDB file was read by
+      REAL  x[ncas], y[ncas], z[ncas] Coordinates
+      long  offset[ncas]              Byte offset of the C-alpha's atom
+                                      line in the PDB file (-1 if not
+                                      found)
+      int   resnum[ncas]              Residue numbers
+      char  str[ncas][CACHE_NSTR][CACHE_STRLEN]
+                                      Record type, atom name, residue
+                                      name, chain and insert code
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 Cache files are written under a name made by
+                  mkstemp(), so threads writing the same cache file
+                  can't mix their writes. The modification time is
+                  kept to the nanosecond
+
+*************************************************************************/
+/* Includes
+*/
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+#include "bioplib/pdb.h"
+#include "bioplib/macros.h"
+#include "pdbload.h"
+#include "pdbcache.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define CACHE_MAGIC   "FCCACHE"   /* Identifies a cache file            */
+#define CACHE_VERSION 2
+#define CACHE_ORDER   0x01020304  /* Checks the byte order              */
+#define CACHE_EXT     ".cac"
+#define CACHE_TMPEXT  ".XXXXXX"   /* Temporary name for mkstemp()       */
+#define CACHE_ALIGN   8
+#define CACHE_STRLEN  8           /* Bytes kept of each string          */
+#define CACHE_NSTR    5           /* Strings kept for each C-alpha      */
+#define CACHE_LINE    160         /* Buffer for finding atom lines      */
+
+/* String fields in str[]                                               */
+#define CS_RECORD     0
+#define CS_ATNAM      1
+#define CS_RESNAM     2
+#define CS_CHAIN      3
+#define CS_INSERT     4
+
+#define CACHEALIGN(n) \
+   ((((n) + CACHE_ALIGN - 1) / CACHE_ALIGN) * CACHE_ALIGN)
+#define CACHESTR(lay, map, i, f) \
+   ((char *)(map) + (lay).str + ((i) * CACHE_NSTR + (f)) * CACHE_STRLEN)
+
+typedef struct
+{
+   char magic[8];
+   int  version,
+        order,
+        realSize,            /* sizeof(REAL)                            */
+        longSize,            /* sizeof(long)                            */
+        ncas,                /* Number of C-alphas                      */
+        pathlen;             /* Length of the path                      */
+   long size,                /* Size of the PDB file                    */
+        mtime,               /* Modification time of the PDB file       */
+        mtimeNsec;           /* and its nanoseconds                     */
+}  CACHEHEADER;
+
+/* Where each section starts in a cache file                            */
+typedef struct
+{
+   size_t path, x, y, z, offset, resnum, str,
+          total;             /* Size of the file                        */
+}  CACHELAYOUT;
+
+/************************************************************************/
+/* Prototypes
+*/
+static char *CacheFileName(char *cachedir, char *filename);
+static void CacheLayout(int ncas, int pathlen, CACHELAYOUT *lay);
+static CACHEHEADER *MapCache(char *cachefile, char *filename,
+                             struct stat *src, size_t *mapsize);
+static BOOL WriteCache(char *cachefile, char *filename, FILE *fp,
+                       PDB *pdb, struct stat *src);
+static void FindCALines(FILE *fp, PDB *pdb, long *offset);
+static BOOL SameAtom(char *line, PDB *p);
+static void PutCacheString(char *out, char *in);
+static void CopyCacheString(char *out, char *in, int size);
+
+
+/************************************************************************/
+/*>PDB *ReadCAPDBCache(char *cachedir, char *filename, int *natoms)
+   ----------------------------------------------------------------
+   Input:   char     *cachedir  Cache directory
+            char     *filename  PDB file
+   Output:  int      *natoms    Number of C-alphas
+   Returns: PDB      *          PDB linked list of the C-alphas (NULL
+                                if there is no up to date cache file
+                                or no memory)
+
+   16.10.26 Original   By: ACRM
+*/
+PDB *ReadCAPDBCache(char *cachedir, char *filename, int *natoms)
+{
+   struct stat src;
+   CACHEHEADER *hdr;
+   CACHELAYOUT lay;
+   size_t      mapsize;
+   char        *cachefile;
+   PDB         *pdb = NULL,
+               *p   = NULL;
+   REAL        *x, *y, *z;
+   int         *resnum,
+               i;
+
+   *natoms = 0;
+   if(stat(filename, &src))
+      return(NULL);
+   if((cachefile = CacheFileName(cachedir, filename)) == NULL)
+      return(NULL);
+   hdr = MapCache(cachefile, filename, &src, &mapsize);
+   free(cachefile);
+   if(hdr == NULL)
+      return(NULL);
+
+   CacheLayout(hdr->ncas, hdr->pathlen, &lay);
+   x      = (REAL *)((char *)hdr + lay.x);
+   y      = (REAL *)((char *)hdr + lay.y);
+   z      = (REAL *)((char *)hdr + lay.z);
+   resnum = (int  *)((char *)hdr + lay.resnum);
+
+   for(i=0; i<hdr->ncas; i++)
+   {
+      if(pdb == NULL)
+      {
+         INIT(pdb, PDB);
+         p = pdb;
+      }
+      else
+      {
+         ALLOCNEXT(p, PDB);
+      }
+      if(p == NULL)
+      {
+         FREELIST(pdb, PDB);
+         munmap((void *)hdr, mapsize);
+         return(NULL);
+      }
+
+      CLEAR_PDB(p);
+      CopyCacheString(p->record_type, CACHESTR(lay, hdr, i, CS_RECORD),
+                      sizeof(p->record_type));
+      CopyCacheString(p->atnam_raw,   CACHESTR(lay, hdr, i, CS_ATNAM),
+                      sizeof(p->atnam_raw));
+      CopyCacheString(p->resnam,      CACHESTR(lay, hdr, i, CS_RESNAM),
+                      sizeof(p->resnam));
+      CopyCacheString(p->chain,       CACHESTR(lay, hdr, i, CS_CHAIN),
+                      sizeof(p->chain));
+      CopyCacheString(p->insert,      CACHESTR(lay, hdr, i, CS_INSERT),
+                      sizeof(p->insert));
+      strcpy(p->atnam, "CA  ");
+      p->atnum  = i+1;
+      p->resnum = resnum[i];
+      p->x      = x[i];
+      p->y      = y[i];
+      p->z      = z[i];
+      p->occ    = (REAL)1.0;
+   }
+
+   *natoms = hdr->ncas;
+   munmap((void *)hdr, mapsize);
+   return(pdb);
+}
+
+
+/************************************************************************/
+/*>PDB *ReadPDBToCache(char *cachedir, char *filename, FILE *fp,
+                       int *natoms)
+   -------------------------------------------------------------
+   Input:   char     *cachedir  Cache directory
+            char     *filename  PDB file
+            FILE     *fp        PDB file opened for reading
+   Output:  int      *natoms    Number of atoms read
+   Returns: PDB      *          PDB linked list (NULL if no atoms)
+
+   Reads a PDB file with ReadPDBSerial() and writes its cache file if
+   there isn't an up to date one already
+
+   16.10.26 Original   By: ACRM
+*/
+PDB *ReadPDBToCache(char *cachedir, char *filename, FILE *fp,
+                    int *natoms)
+{
+   struct stat src;
+   CACHEHEADER *hdr;
+   size_t      mapsize;
+   char        *cachefile;
+   PDB         *pdb;
+   BOOL        keyed;
+
+   /* Take the size and time before reading so that a file changed
+      while it is read doesn't get a cache file of the old contents
+   */
+   keyed = !fstat(fileno(fp), &src);
+
+   if((pdb = ReadPDBSerial(fp, natoms)) == NULL)
+      return(NULL);
+
+   if(keyed && ((cachefile = CacheFileName(cachedir, filename)) != NULL))
+   {
+      if((hdr = MapCache(cachefile, filename, &src, &mapsize)) != NULL)
+         munmap((void *)hdr, mapsize);
+      else
+         WriteCache(cachefile, filename, fp, pdb, &src);
+      free(cachefile);
+   }
+
+   return(pdb);
+}
+
+
+/************************************************************************/
+/*>static char *CacheFileName(char *cachedir, char *filename)
+   ----------------------------------------------------------
+   Input:   char     *cachedir  Cache directory
+            char     *filename  PDB file
+   Returns: char     *          Cache file name (malloc'd; NULL if no
+                                memory)
+
+   The base name of the PDB file is kept to make the cache readable;
+   the FNV-1a hash of the whole path tells apart files with the same
+   base name.
+
+   16.10.26 Original   By: ACRM
+*/
+static char *CacheFileName(char *cachedir, char *filename)
+{
+   unsigned long hash = 2166136261UL;
+   char          *base,
+                 *name,
+                 *c;
+
+   for(c=filename; *c; c++)
+   {
+      hash ^= (unsigned char)*c;
+      hash  = (hash * 16777619UL) & 0xffffffffUL;
+   }
+
+   base = ((c = strrchr(filename, '/')) != NULL) ? c+1 : filename;
+
+   if((name = (char *)malloc(strlen(cachedir) + strlen(base) +
+                             strlen(CACHE_EXT) + 11)) == NULL)
+      return(NULL);
+   sprintf(name, "%s/%s.%08lx%s", cachedir, base, hash, CACHE_EXT);
+
+   return(name);
+}
+
+
+/************************************************************************/
+/*>static void CacheLayout(int ncas, int pathlen, CACHELAYOUT *lay)
+   ----------------------------------------------------------------
+   Input:   int         ncas     Number of C-alphas
+            int         pathlen  Length of the path
+   Output:  CACHELAYOUT *lay     Offsets of each section
+
+   16.10.26 Original   By: ACRM
+*/
+static void CacheLayout(int ncas, int pathlen, CACHELAYOUT *lay)
+{
+   lay->path   = CACHEALIGN(sizeof(CACHEHEADER));
+   lay->x      = CACHEALIGN(lay->path + pathlen);
+   lay->y      = CACHEALIGN(lay->x + ncas * sizeof(REAL));
+   lay->z      = CACHEALIGN(lay->y + ncas * sizeof(REAL));
+   lay->offset = CACHEALIGN(lay->z + ncas * sizeof(REAL));
+   lay->resnum = CACHEALIGN(lay->offset + ncas * sizeof(long));
+   lay->str    = CACHEALIGN(lay->resnum + ncas * sizeof(int));
+   lay->total  = lay->str + ncas * CACHE_NSTR * CACHE_STRLEN;
+}
+
+
+/************************************************************************/
+/*>static CACHEHEADER *MapCache(char *cachefile, char *filename,
+                                struct stat *src, size_t *mapsize)
+   --------------------------------------------------------------
+   Input:   char        *cachefile  Cache file
+            char        *filename   PDB file
+            struct stat *src        Status of the PDB file
+   Output:  size_t      *mapsize    Size of the mapping
+   Returns: CACHEHEADER *           The mapped cache file (NULL if it
+                                    doesn't exist or isn't for this
+                                    version of the PDB file)
+
+   The caller must munmap() the cache file
+
+   16.10.26 Original   By: ACRM
+*/
+static CACHEHEADER *MapCache(char *cachefile, char *filename,
+                             struct stat *src, size_t *mapsize)
+{
+   struct stat st;
+   CACHEHEADER *hdr;
+   CACHELAYOUT lay;
+   void        *map;
+   int         fd;
+   BOOL        ok;
+
+   if((fd = open(cachefile, O_RDONLY)) < 0)
+      return(NULL);
+   if(fstat(fd, &st) || (st.st_size < (off_t)sizeof(CACHEHEADER)))
+   {
+      close(fd);
+      return(NULL);
+   }
+
+   *mapsize = (size_t)st.st_size;
+   map = mmap(NULL, *mapsize, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if(map == MAP_FAILED)
+      return(NULL);
+
+   hdr = (CACHEHEADER *)map;
+   ok  = (!strncmp(hdr->magic, CACHE_MAGIC, sizeof(hdr->magic)) &&
+          (hdr->version  == CACHE_VERSION)     &&
+          (hdr->order    == CACHE_ORDER)       &&
+          (hdr->realSize == (int)sizeof(REAL)) &&
+          (hdr->longSize == (int)sizeof(long)) &&
+          (hdr->ncas     >  0)                 &&
+          (hdr->pathlen  == (int)strlen(filename)) &&
+          (hdr->size     == (long)src->st_size) &&
+          (hdr->mtime    == (long)src->st_mtim.tv_sec) &&
+          (hdr->mtimeNsec == (long)src->st_mtim.tv_nsec));
+   if(ok)
+   {
+      CacheLayout(hdr->ncas, hdr->pathlen, &lay);
+      ok = ((lay.total == *mapsize) &&
+            !strncmp((char *)map + lay.path, filename, hdr->pathlen));
+   }
+
+   if(!ok)
+   {
+      munmap(map, *mapsize);
+      return(NULL);
+   }
+   return(hdr);
+}
+
+
+/************************************************************************/
+/*>static BOOL WriteCache(char *cachefile, char *filename, FILE *fp,
+                          PDB *pdb, struct stat *src)
+   ----------------------------------------------------------------
+   Input:   char        *cachefile  Cache file
+            char        *filename   PDB file
+            FILE        *fp         PDB file opened for reading
+            PDB         *pdb        Structure read from it
+            struct stat *src        Status of the PDB file before it
+                                    was read
+   Returns: BOOL                    Cache file written
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Writes to a temporary file made by mkstemp()
+*/
+static BOOL WriteCache(char *cachefile, char *filename, FILE *fp,
+                       PDB *pdb, struct stat *src)
+{
+   CACHEHEADER *hdr;
+   CACHELAYOUT lay;
+   char        *buffer,
+               *tmpfile;
+   REAL        *x, *y, *z;
+   int         *resnum,
+               ncas = 0,
+               fd,
+               i;
+   PDB         *p;
+   FILE        *out;
+   BOOL        ok;
+
+   for(p=pdb; p!=NULL; NEXT(p))
+   {
+      if(!strncmp(p->atnam, "CA  ", 4))
+         ncas++;
+   }
+   if(ncas == 0)
+      return(FALSE);
+
+   CacheLayout(ncas, (int)strlen(filename), &lay);
+   if((buffer = (char *)calloc(lay.total, 1)) == NULL)
+      return(FALSE);
+   if((tmpfile = (char *)malloc(strlen(cachefile) +
+                                strlen(CACHE_TMPEXT) + 1)) == NULL)
+   {
+      free(buffer);
+      return(FALSE);
+   }
+   sprintf(tmpfile, "%s%s", cachefile, CACHE_TMPEXT);
+
+   hdr = (CACHEHEADER *)buffer;
+   strncpy(hdr->magic, CACHE_MAGIC, sizeof(hdr->magic));
+   hdr->version  = CACHE_VERSION;
+   hdr->order    = CACHE_ORDER;
+   hdr->realSize = (int)sizeof(REAL);
+   hdr->longSize = (int)sizeof(long);
+   hdr->ncas     = ncas;
+   hdr->pathlen  = (int)strlen(filename);
+   hdr->size     = (long)src->st_size;
+   hdr->mtime    = (long)src->st_mtim.tv_sec;
+   hdr->mtimeNsec = (long)src->st_mtim.tv_nsec;
+   memcpy(buffer + lay.path, filename, hdr->pathlen);
+
+   x      = (REAL *)(buffer + lay.x);
+   y      = (REAL *)(buffer + lay.y);
+   z      = (REAL *)(buffer + lay.z);
+   resnum = (int  *)(buffer + lay.resnum);
+   for(p=pdb, i=0; p!=NULL; NEXT(p))
+   {
+      if(!strncmp(p->atnam, "CA  ", 4))
+      {
+         x[i]      = p->x;
+         y[i]      = p->y;
+         z[i]      = p->z;
+         resnum[i] = p->resnum;
+         PutCacheString(CACHESTR(lay, buffer, i, CS_RECORD), p->record_type);
+         PutCacheString(CACHESTR(lay, buffer, i, CS_ATNAM), p->atnam_raw);
+         PutCacheString(CACHESTR(lay, buffer, i, CS_RESNAM), p->resnam);
+         PutCacheString(CACHESTR(lay, buffer, i, CS_CHAIN), p->chain);
+         PutCacheString(CACHESTR(lay, buffer, i, CS_INSERT), p->insert);
+         i++;
+      }
+   }
+   FindCALines(fp, pdb, (long *)(buffer + lay.offset));
+
+   /* The temporary file has a name of its own, so other threads and
+      processes writing the same cache file don't write into it
+   */
+   ok = FALSE;
+   if((fd = mkstemp(tmpfile)) >= 0)
+   {
+      if((out = fdopen(fd, "wb")) == NULL)
+      {
+         close(fd);
+         remove(tmpfile);
+         free(tmpfile);
+         free(buffer);
+         return(FALSE);
+      }
+      fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+      ok = (fwrite(buffer, 1, lay.total, out) == lay.total);
+      ok = !fclose(out) && ok;
+      ok = ok && !rename(tmpfile, cachefile);
+      if(!ok)
+         remove(tmpfile);
+   }
+
+   free(tmpfile);
+   free(buffer);
+   return(ok);
+}
+
+
+/************************************************************************/
+/*>static void FindCALines(FILE *fp, PDB *pdb, long *offset)
+   ---------------------------------------------------------
+   Input:   FILE     *fp        PDB file
+            PDB      *pdb       Structure read from it
+   Output:  long     *offset    Byte offset of each C-alpha's atom line
+                                (-1 if not found)
+
+   Rereads the file, matching each C-alpha in turn to the next atom
+   line with the same atom name and residue. Where there are
+   alternative positions this finds the first.
+
+   16.10.26 Original   By: ACRM
+*/
+static void FindCALines(FILE *fp, PDB *pdb, long *offset)
+{
+   char buffer[CACHE_LINE];
+   long pos     = 0;
+   int  i       = 0,
+        len;
+   BOOL atStart = TRUE;
+   PDB  *p;
+
+   for(p=pdb; p!=NULL; NEXT(p))
+   {
+      if(!strncmp(p->atnam, "CA  ", 4))
+         offset[i++] = -1L;
+   }
+
+   for(p=pdb; (p!=NULL) && strncmp(p->atnam, "CA  ", 4); NEXT(p));
+
+   if(fseek(fp, 0L, SEEK_SET))
+      return;
+
+   i = 0;
+   while((p != NULL) && fgets(buffer, CACHE_LINE, fp))
+   {
+      len = strlen(buffer);
+      if(atStart && SameAtom(buffer, p))
+      {
+         offset[i++] = pos;
+         for(NEXT(p); (p!=NULL) && strncmp(p->atnam, "CA  ", 4);
+             NEXT(p));
+      }
+      atStart = (len > 0) && (buffer[len-1] == '\n');
+      pos    += len;
+   }
+}
+
+
+/************************************************************************/
+/*>static BOOL SameAtom(char *line, PDB *p)
+   ----------------------------------------
+   Input:   char     *line      Line from a PDB file
+            PDB      *p         Atom
+   Returns: BOOL                The line is an atom line for this atom
+
+   Compares the atom name, chain, residue number and insert code
+
+   16.10.26 Original   By: ACRM
+*/
+static BOOL SameAtom(char *line, PDB *p)
+{
+   char field[8];
+   int  i, j;
+
+   if((strncmp(line, "ATOM  ", 6) && strncmp(line, "HETATM", 6)) ||
+      (strlen(line) < 27))
+      return(FALSE);
+
+   if((line[21] != p->chain[0]) ||
+      (line[26] != (p->insert[0] ? p->insert[0] : ' ')))
+      return(FALSE);
+
+   strncpy(field, line+22, 4);
+   field[4] = '\0';
+   if(atoi(field) != p->resnum)
+      return(FALSE);
+
+   /* Atom names are compared ignoring blanks at either end             */
+   for(i=12; (i<16) && (line[i] == ' '); i++);
+   for(j=0; (i<16) && (line[i] != ' '); i++, j++)
+   {
+      if(line[i] != p->atnam[j])
+         return(FALSE);
+   }
+   return((p->atnam[j] == ' ') || (p->atnam[j] == '\0'));
+}
+
+
+/************************************************************************/
+/*>static void PutCacheString(char *out, char *in)
+   -----------------------------------------------
+   Input:   char     *in        String
+   Output:  char     *out       Up to CACHE_STRLEN-1 characters of it
+                                in a zeroed cache file string
+
+   16.10.26 Original   By: ACRM
+*/
+static void PutCacheString(char *out, char *in)
+{
+   int i;
+
+   for(i=0; (i<CACHE_STRLEN-1) && in[i]; i++)
+      out[i] = in[i];
+}
+
+
+/************************************************************************/
+/*>static void CopyCacheString(char *out, char *in, int size)
+   ----------------------------------------------------------
+   Input:   char     *in        String from a cache file
+            int      size       Size of out
+   Output:  char     *out       Terminated copy
+
+   16.10.26 Original   By: ACRM
+*/
+static void CopyCacheString(char *out, char *in, int size)
+{
+   if(size > CACHE_STRLEN)
+      size = CACHE_STRLEN;
+   strncpy(out, in, size-1);
+   out[size-1] = '\0';
+}
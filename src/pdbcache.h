@@ -0,0 +1,48 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       pdbcache.h
+
+   Version:    V1.0
+   Date:       16.10.26
+   Function:   Binary cache of the C-alphas of PDB files
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+
+*************************************************************************/
+#ifndef _PDBCACHE_H
+#define _PDBCACHE_H
+
+/************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/pdb.h"
+
+/************************************************************************/
+/* Prototypes
+*/
+PDB *ReadCAPDBCache(char *cachedir, char *filename, int *natoms);
+PDB *ReadPDBToCache(char *cachedir, char *filename, FILE *fp,
+                    int *natoms);
+
+#endif
@@ -0,0 +1,262 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       pdbload.c
+
+   Version:    V1.3
+   Date:       16.10.26
+   Function:   Read a set of PDB files in parallel
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Description:
+   ============
+   Reading the structures one after another leaves the CPU waiting on
+   each file in turn, which is slow for large families on networked
+   file systems. LoadPDBFiles() instead reads them as tasks on a
+   thread pool, each on its own FILE with a PDBLOAD_BUFFER byte
+   buffer.
+
+   The files are also prefetched: before the reading starts the OS is
+   told the first PDBLOAD_AHEAD files will be needed, and each task
+   does the same for the file PDBLOAD_AHEAD further on. Since the pool
+   hands out files in order, the files just ahead of the ones being
+   parsed are being fetched in the background, while no more than a
+   fixed number are waiting in memory. The hints need POSIX
+   posix_fadvise(); without it files are just read as they come.
+
+   If a cache directory is given to LoadPDBFiles(), the files are
+   also kept in the binary C-alpha cache (pdbcache.c). Callers which
+   only need the C-alphas then get a list of just those, built from
+   the cache file without parsing the PDB file. The PDB files aren't
+   prefetched in that case, since usually they won't be read.
+
+   Every task writes only its own entries of pdb[] and natoms[], so
+   the result is the same however many threads there are. BiopLib's
+   blReadPDB() sets globals (gPDBPartialOcc and others) as it reads,
+   so it isn't safe to call from two threads at once. Every call goes
+   through ReadPDBSerial(), which holds a lock while it parses; the
+   opening, prefetching and cache reading are still done in parallel.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 Added the C-alpha cache
+   V1.2  16.10.26 Added LoadPDBFiles() which takes the cache directory
+   V1.3  16.10.26 Removed SetPDBCache() and ReadPDBFiles(), which kept
+                  the cache directory in a global
+
+*************************************************************************/
+/* Includes
+*/
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/pdb.h"
+#include "pool.h"
+#include "pdbcache.h"
+#include "pdbload.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define PDBLOAD_BUFFER 1048576  /* stdio buffer for each file            */
+#define PDBLOAD_AHEAD  16       /* Number of files prefetched            */
+
+/* What the load tasks need                                             */
+typedef struct
+{
+   char **filenames;
+   int  nfiles;
+   PDB  **pdb;
+   int  *natoms;
+   BOOL caOnly;
+   char *cachedir;
+}  PDBLOAD;
+
+/************************************************************************/
+/* Globals
+*/
+static pthread_mutex_t sReadLock = PTHREAD_MUTEX_INITIALIZER;
+
+/************************************************************************/
+/* Prototypes
+*/
+static void LoadTask(void *arg, int i);
+static void Prefetch(char *filename);
+
+
+/************************************************************************/
+/*>BOOL LoadPDBFiles(char **filenames, int nfiles, BOOL caOnly,
+                     char *cachedir, PDB **pdb, int *natoms,
+                     THREADPOOL *pool)
+   ------------------------------------------------------------
+   Input:   char       **filenames  Files to read
+            int        nfiles       Number of files
+            BOOL       caOnly       Only the C-alphas are needed
+            char       *cachedir    Directory for the C-alpha cache
+                                    (NULL for none)
+            THREADPOOL *pool        Thread pool (may be NULL)
+   Output:  PDB        **pdb        Structure read from each file (NULL
+                                    if it couldn't be read)
+            int        *natoms      Number of atoms read from each file
+                                    (PDBLOAD_NOFILE if it couldn't be
+                                    opened)
+   Returns: BOOL                    Every file gave a structure
+
+   Reads the files on the thread pool. With caOnly set, structures may
+   be returned as just their C-alphas.
+
+   16.10.26 Original (from ReadPDBFiles())   By: ACRM
+*/
+BOOL LoadPDBFiles(char **filenames, int nfiles, BOOL caOnly,
+                  char *cachedir, PDB **pdb, int *natoms,
+                  THREADPOOL *pool)
+{
+   PDBLOAD load;
+   int     i;
+
+   load.filenames = filenames;
+   load.nfiles    = nfiles;
+   load.pdb       = pdb;
+   load.natoms    = natoms;
+   load.cachedir  = cachedir;
+   load.caOnly    = (caOnly && (cachedir != NULL));
+
+   if(!load.caOnly)
+   {
+      for(i=0; (i<nfiles) && (i<PDBLOAD_AHEAD); i++)
+         Prefetch(filenames[i]);
+   }
+
+   RunPool(pool, LoadTask, (void *)&load, nfiles);
+
+   for(i=0; i<nfiles; i++)
+   {
+      if(pdb[i] == NULL)
+         return(FALSE);
+   }
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static void LoadTask(void *arg, int i)
+   --------------------------------------
+   Input:   void       *arg     PDBLOAD
+            int        i        File to read
+
+   Pool task for LoadPDBFiles(). Prefetches the file PDBLOAD_AHEAD
+   further on and reads file i.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Reads from and writes to the C-alpha cache
+*/
+static void LoadTask(void *arg, int i)
+{
+   PDBLOAD *load = (PDBLOAD *)arg;
+   FILE    *fp;
+
+   if(load->caOnly)
+   {
+      if((load->pdb[i] = ReadCAPDBCache(load->cachedir,
+                                        load->filenames[i],
+                                        &(load->natoms[i]))) != NULL)
+         return;
+   }
+   else if(i + PDBLOAD_AHEAD < load->nfiles)
+   {
+      Prefetch(load->filenames[i + PDBLOAD_AHEAD]);
+   }
+
+   load->pdb[i] = NULL;
+   if((fp = fopen(load->filenames[i], "r")) == NULL)
+   {
+      load->natoms[i] = PDBLOAD_NOFILE;
+      return;
+   }
+
+   setvbuf(fp, NULL, _IOFBF, PDBLOAD_BUFFER);
+#ifdef POSIX_FADV_SEQUENTIAL
+   posix_fadvise(fileno(fp), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+   if(load->cachedir != NULL)
+      load->pdb[i] = ReadPDBToCache(load->cachedir, load->filenames[i],
+                                    fp, &(load->natoms[i]));
+   else
+      load->pdb[i] = ReadPDBSerial(fp, &(load->natoms[i]));
+   fclose(fp);
+}
+
+
+/************************************************************************/
+/*>PDB *ReadPDBSerial(FILE *fp, int *natoms)
+   -----------------------------------------
+   Input:   FILE       *fp      PDB file
+   Output:  int        *natoms  Number of atoms read
+   Returns: PDB        *        PDB linked list (NULL if no atoms)
+
+   blReadPDB() holding a lock, since it isn't reentrant
+
+   16.10.26 Original   By: ACRM
+*/
+PDB *ReadPDBSerial(FILE *fp, int *natoms)
+{
+   PDB *pdb;
+
+   pthread_mutex_lock(&sReadLock);
+   pdb = blReadPDB(fp, natoms);
+   pthread_mutex_unlock(&sReadLock);
+
+   return(pdb);
+}
+
+
+/************************************************************************/
+/*>static void Prefetch(char *filename)
+   ------------------------------------
+   Input:   char       *filename  File which will be read soon
+
+   Asks the OS to start reading the file in the background. Errors are
+   ignored; they will be picked up when the file is read properly.
+
+   16.10.26 Original   By: ACRM
+*/
+static void Prefetch(char *filename)
+{
+#ifdef POSIX_FADV_WILLNEED
+   int fd;
+
+   if((fd = open(filename, O_RDONLY)) >= 0)
+   {
+      posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+      close(fd);
+   }
+#endif
+}
@@ -0,0 +1,59 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       pdbload.h
+
+   Version:    V1.3
+   Date:       16.10.26
+   Function:   Read a set of PDB files in parallel
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 Added the C-alpha cache
+   V1.2  16.10.26 Added LoadPDBFiles()
+   V1.3  16.10.26 Removed SetPDBCache() and ReadPDBFiles()
+
+*************************************************************************/
+#ifndef _PDBLOAD_H
+#define _PDBLOAD_H
+
+/************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/pdb.h"
+#include "pool.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+/* natoms[] value for a file which couldn't be opened                   */
+#define PDBLOAD_NOFILE (-1)
+
+/************************************************************************/
+/* Prototypes
+*/
+BOOL LoadPDBFiles(char **filenames, int nfiles, BOOL caOnly,
+                  char *cachedir, PDB **pdb, int *natoms,
+                  THREADPOOL *pool);
+PDB *ReadPDBSerial(FILE *fp, int *natoms);
+
+#endif
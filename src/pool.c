@@ -0,0 +1,293 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       pool.c
+
+   Version:    V1.0
+   Date:       16.10.26
+   Function:   Simple fixed size thread pool
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Description:
+   ============
+   A pool of POSIX threads which is started once and then given
+   batches of independent tasks. RunPool() hands out the indices of a
+   batch one at a time to whichever thread is free (the calling thread
+   joins in) and only returns when every task in the batch has
+   finished, so the caller sees exactly the same state as if the tasks
+   had been run in order.
+
+   The tasks must not depend on each other and must write to separate
+   memory; which thread runs which index varies from run to run.
+
+   A pool of one thread (or a NULL pool) starts no threads and just
+   runs the tasks in order.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "bioplib/SysDefs.h"
+#include "pool.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+struct threadpool
+{
+   int             nthreads,  /* Threads including the caller           */
+                   nworkers;  /* Threads actually started               */
+   pthread_t       *workers;
+   pthread_mutex_t lock;
+   pthread_cond_t  work,      /* Signalled when a batch is posted       */
+                   done;      /* Signalled when a batch has finished    */
+   POOLTASK        task;      /* Current batch                          */
+   void            *arg;
+   int             ntasks,
+                   next,      /* Next index to hand out                 */
+                   ndone,     /* Number of tasks finished               */
+                   batch;     /* Incremented for each new batch         */
+   BOOL            quit;
+};
+
+/************************************************************************/
+/* Prototypes
+*/
+static void *PoolWorker(void *arg);
+static void RunTasks(THREADPOOL *pool);
+
+
+/************************************************************************/
+/*>THREADPOOL *NewThreadPool(int nthreads)
+   ---------------------------------------
+   Input:   int        nthreads  Number of threads to run tasks on,
+                                 including the caller
+   Returns: THREADPOOL *         The pool (NULL if no memory or the
+                                 threads couldn't be started)
+
+   16.10.26 Original   By: ACRM
+*/
+THREADPOOL *NewThreadPool(int nthreads)
+{
+   THREADPOOL *pool;
+   int        i;
+
+   if(nthreads < 1)
+      nthreads = 1;
+
+   if((pool = (THREADPOOL *)malloc(sizeof(THREADPOOL)))==NULL)
+      return(NULL);
+
+   pool->nthreads = nthreads;
+   pool->nworkers = 0;
+   pool->workers  = NULL;
+   pool->task     = NULL;
+   pool->arg      = NULL;
+   pool->ntasks   = pool->next = pool->ndone = pool->batch = 0;
+   pool->quit     = FALSE;
+
+   if(nthreads == 1)
+      return(pool);
+
+   if((pool->workers = (pthread_t *)malloc((nthreads-1) *
+                                           sizeof(pthread_t)))==NULL)
+   {
+      free(pool);
+      return(NULL);
+   }
+
+   pthread_mutex_init(&(pool->lock), NULL);
+   pthread_cond_init(&(pool->work), NULL);
+   pthread_cond_init(&(pool->done), NULL);
+
+   for(i=0; i<nthreads-1; i++)
+   {
+      if(pthread_create(&(pool->workers[i]), NULL, PoolWorker, pool))
+      {
+         FreeThreadPool(pool);
+         return(NULL);
+      }
+      pool->nworkers++;
+   }
+
+   return(pool);
+}
+
+
+/************************************************************************/
+/*>void FreeThreadPool(THREADPOOL *pool)
+   -------------------------------------
+   I/O:     THREADPOOL *pool    Thread pool
+
+   Stops the threads and frees the pool. May be given NULL.
+
+   16.10.26 Original   By: ACRM
+*/
+void FreeThreadPool(THREADPOOL *pool)
+{
+   int i;
+
+   if(pool == NULL)
+      return;
+
+   if(pool->workers != NULL)
+   {
+      pthread_mutex_lock(&(pool->lock));
+      pool->quit = TRUE;
+      pthread_cond_broadcast(&(pool->work));
+      pthread_mutex_unlock(&(pool->lock));
+
+      for(i=0; i<pool->nworkers; i++)
+         pthread_join(pool->workers[i], NULL);
+
+      pthread_cond_destroy(&(pool->work));
+      pthread_cond_destroy(&(pool->done));
+      pthread_mutex_destroy(&(pool->lock));
+      free(pool->workers);
+   }
+
+   free(pool);
+}
+
+
+/************************************************************************/
+/*>void RunPool(THREADPOOL *pool, POOLTASK task, void *arg, int ntasks)
+   --------------------------------------------------------------------
+   Input:   THREADPOOL *pool    Thread pool (may be NULL)
+            POOLTASK   task     Function to run
+            void       *arg     Passed to every call of task
+            int        ntasks   Number of tasks
+
+   Calls task(arg, i) for i = 0..ntasks-1 spread across the threads and
+   waits for them all to finish
+
+   16.10.26 Original   By: ACRM
+*/
+void RunPool(THREADPOOL *pool, POOLTASK task, void *arg, int ntasks)
+{
+   int i;
+
+   if((pool == NULL) || (pool->workers == NULL) || (ntasks < 2))
+   {
+      for(i=0; i<ntasks; i++)
+         (*task)(arg, i);
+      return;
+   }
+
+   pthread_mutex_lock(&(pool->lock));
+   pool->task   = task;
+   pool->arg    = arg;
+   pool->ntasks = ntasks;
+   pool->next   = 0;
+   pool->ndone  = 0;
+   pool->batch++;
+   pthread_cond_broadcast(&(pool->work));
+
+   RunTasks(pool);
+
+   while(pool->ndone < pool->ntasks)
+      pthread_cond_wait(&(pool->done), &(pool->lock));
+   pthread_mutex_unlock(&(pool->lock));
+}
+
+
+/************************************************************************/
+/*>int PoolThreads(THREADPOOL *pool)
+   ---------------------------------
+   Input:   THREADPOOL *pool    Thread pool (may be NULL)
+   Returns: int                 Number of threads tasks are run on
+
+   16.10.26 Original   By: ACRM
+*/
+int PoolThreads(THREADPOOL *pool)
+{
+   return((pool == NULL) ? 1 : pool->nthreads);
+}
+
+
+/************************************************************************/
+/*>static void RunTasks(THREADPOOL *pool)
+   --------------------------------------
+   I/O:     THREADPOOL *pool    Thread pool
+
+   Takes tasks from the current batch until there are none left. Must
+   be called with the lock held; the lock is released while each task
+   runs.
+
+   16.10.26 Original   By: ACRM
+*/
+static void RunTasks(THREADPOOL *pool)
+{
+   int i;
+
+   while(pool->next < pool->ntasks)
+   {
+      i = pool->next++;
+      pthread_mutex_unlock(&(pool->lock));
+      (*pool->task)(pool->arg, i);
+      pthread_mutex_lock(&(pool->lock));
+      if(++(pool->ndone) == pool->ntasks)
+         pthread_cond_signal(&(pool->done));
+   }
+}
+
+
+/************************************************************************/
+/*>static void *PoolWorker(void *arg)
+   ----------------------------------
+   Input:   void       *arg     The thread pool
+
+   Thread function. Waits for a batch, helps run it and waits for the
+   next one until told to quit.
+
+   16.10.26 Original   By: ACRM
+*/
+static void *PoolWorker(void *arg)
+{
+   THREADPOOL *pool = (THREADPOOL *)arg;
+   int        batch = 0;
+
+   pthread_mutex_lock(&(pool->lock));
+   for(;;)
+   {
+      while(!pool->quit && (pool->batch == batch))
+         pthread_cond_wait(&(pool->work), &(pool->lock));
+      if(pool->quit)
+         break;
+
+      batch = pool->batch;
+      RunTasks(pool);
+   }
+   pthread_mutex_unlock(&(pool->lock));
+
+   return(NULL);
+}
@@ -0,0 +1,55 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       pool.h
+
+   Version:    V1.0
+   Date:       16.10.26
+   Function:   Simple fixed size thread pool
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+
+*************************************************************************/
+#ifndef _POOL_H
+#define _POOL_H
+
+/************************************************************************/
+/* Includes
+*/
+#include "bioplib/SysDefs.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+/* A task is called once for each index 0..ntasks-1 of a batch          */
+typedef void (*POOLTASK)(void *arg, int i);
+
+typedef struct threadpool THREADPOOL;
+
+/************************************************************************/
+/* Prototypes
+*/
+THREADPOOL *NewThreadPool(int nthreads);
+void FreeThreadPool(THREADPOOL *pool);
+void RunPool(THREADPOOL *pool, POOLTASK task, void *arg, int ntasks);
+int PoolThreads(THREADPOOL *pool);
+
+#endif
@@ -4,8 +4,8 @@
    Program:    profitcore
    \file       profitcore.c
    
-   \version    V1.0
-   \date       05.11.25   
+   \version    V1.2
+   \date       16.10.26   
    \brief      Identify protein core from ProFit iterative fit
    
    \copyright  (c) Prof Andrew C. R. Martin 2025
@@ -36,6 +36,9 @@
    Revision History:
    =================
 -  V1.0   05.11.25  Original   By: ACRM
+-  V1.1   16.10.26  Added -k to keep the C-alphas of the PDB files in a
+                    binary cache
+-  V1.2   16.10.26  The cache directory is passed to LoadPDBFiles()
 
 *************************************************************************/
 /* Includes
@@ -44,6 +47,7 @@
 #include <stdlib.h>
 #include "bioplib/macros.h"
 #include "bioplib/pdb.h"
+#include "pdbload.h"
 
 /************************************************************************/
 /* Defines and macros
@@ -62,6 +66,7 @@ typedef struct _zone
 /************************************************************************/
 /* Globals
 */
+char *gCacheDir = NULL;      /* C-alpha cache directory (-k)            */
 
 /************************************************************************/
 /* Prototypes
@@ -84,13 +89,16 @@ BOOL ParseCmdLine(int argc, char **argv, char *zoneFile,
    Main program for core finding
    
 -  05.11.25 Original   By: ACRM
+-  16.10.26 Reads the PDB files with ReadPDBFiles()
+-  16.10.26 Reads them with LoadPDBFiles()
 */
 int main(int argc, char **argv)
 {
    ZONE *zones = NULL;
-   FILE *fp, *fpP1, *fpP2;
-   int natoms;
-   PDB *pdb1, *pdb2;
+   FILE *fp;
+   int natoms[2];
+   PDB *pdb1, *pdb2, *pdbs[2];
+   char *pdbFiles[2];
    char zoneFile[MAXBUFF],
         pdbFile1[MAXBUFF],
         pdbFile2[MAXBUFF],
@@ -105,14 +113,20 @@ int main(int argc, char **argv)
       if((zones = ReadProFitZones(fp))==NULL)
          Die("Unable to read zones from the zones file", NULL, 1);
       
-      if((fpP1 = fopen(pdbFile1, "r"))==NULL)
+      /* Only the C-alphas are needed unless files are written        */
+      pdbFiles[0] = pdbFile1;
+      pdbFiles[1] = pdbFile2;
+      LoadPDBFiles(pdbFiles, 2, (outFile1[0] == '\0') &&
+                   (outFile2[0] == '\0'), gCacheDir, pdbs, natoms, NULL);
+      
+      if(natoms[0] == PDBLOAD_NOFILE)
          Die("Unable to open first PDB input file: ", pdbFile1, 1);
-      if((pdb1 = blReadPDB(fpP1, &natoms))==NULL)
+      if((pdb1 = pdbs[0])==NULL)
          Die("No atoms read from first PDB input file: ", pdbFile1, 1);
       
-      if((fpP2 = fopen(pdbFile2, "r"))==NULL)
+      if(natoms[1] == PDBLOAD_NOFILE)
          Die("Unable to open second PDB input file: ", pdbFile2, 1);
-      if((pdb2 = blReadPDB(fpP2, &natoms))==NULL)
+      if((pdb2 = pdbs[1])==NULL)
          Die("No atoms read from second PDB input file: ", pdbFile2, 1);
       
       if(!MapZones(zones, 0, pdb1))
@@ -385,14 +399,17 @@ void Die(char *msg, char *submsg, int status)
 */
 void Usage(void)
 {
-   printf("\nprofitcore V1.0 (c) 2025, Prof Andrew C.R. Martin, \
+   printf("\nprofitcore V1.2 (c) 2025-2026, Prof Andrew C.R. Martin, \
 abYinformatics\n");
-   printf("\nUsage: profitcore [-o1 file] [-o2 file] zoneFile \
-pdbfile1 pdbfile2\n");
+   printf("\nUsage: profitcore [-o1 file] [-o2 file] [-k cachedir] \
+zoneFile pdbfile1 pdbfile2\n");
    printf("\n");
 
    printf("       -o1 Specify first output PDB file\n");
    printf("       -o2 Specify second output PDB file\n");
+   printf("       -k  Keep the C-alphas of the PDB files in a binary \
+cache in this\n");
+   printf("           directory, so later runs needn't parse them\n");
    printf("\n");
 
    printf("profitcore converts the sequentially numbered zones output \
@@ -437,6 +454,7 @@ would\n");
    Parses the command line
 
 -  05.11.25 Original   By: ACRM
+-  16.10.26 Added -k
 */
 BOOL ParseCmdLine(int argc, char **argv, char *zoneFile,
                   char *pdbFile1, char *pdbFile2,
@@ -470,6 +488,12 @@ BOOL ParseCmdLine(int argc, char **argv, char *zoneFile,
                return(FALSE);
             }
             break;
+         case 'k':
+            argc--; argv++;
+            if(!argc)
+               return(FALSE);
+            gCacheDir = argv[0];
+            break;
          case 'h':
          default:
             return(FALSE);
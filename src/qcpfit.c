@@ -0,0 +1,288 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       qcpfit.c
+
+   Version:    V1.0
+   Date:       16.10.26
+   Function:   Quaternion characteristic polynomial (QCP) superposition
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Description:
+   ============
+   Works out the best rotation and the RMSD for a superposition
+   directly from the 3x3 correlation matrix of the centred coordinates
+   using the method of Theobald (2005) Acta Cryst A61:478-480 and Liu
+   et al. (2010) J. Comput. Chem. 31:1561-1563.
+
+   The best rotation is given by the eigenvector belonging to the
+   largest eigenvalue of Horn's 4x4 key matrix, built from the
+   correlation matrix. The characteristic polynomial of that matrix
+   has no cubic term, and its largest root lies just below E0 (half
+   the sum of the squared deviations of both sets from their centres).
+   So a few Newton steps from E0 find the eigenvalue, and the RMSD
+   follows from it. The rotation is only needed if asked for; it comes
+   from the adjugate of (key matrix - eigenvalue . I), every row of
+   which is a multiple of the eigenvector.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+
+*************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <math.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+#include "qcpfit.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define QCP_MAXNEWTON 50
+#define QCP_EVALPREC  ((REAL)1.0e-11)
+#define QCP_EVECPREC  ((REAL)1.0e-12)
+
+/************************************************************************/
+/* Prototypes
+*/
+static REAL Det3(REAL a, REAL b, REAL c,
+                 REAL d, REAL e, REAL f,
+                 REAL g, REAL h, REAL i);
+static REAL Cofactor4(REAL m[4][4], int row, int col);
+
+
+/************************************************************************/
+/*>BOOL QCPFit(REAL corr[3][3], REAL E0, int npairs, REAL rot[3][3],
+               REAL *rmsd)
+   -----------------------------------------------------------------
+   Input:   REAL  corr[3][3]  Correlation matrix of the centred
+                              coordinates: corr[i][j] = Sum ref[i]*mob[j]
+            REAL  E0          Half the sum of squared distances of both
+                              sets of coordinates from their centres
+            int   npairs      Number of coordinate pairs
+   Output:  REAL  rot[3][3]   Rotation taking the mobile coordinates
+                              onto the reference: x' = rot . x
+                              May be NULL if only the RMSD is wanted
+            REAL  *rmsd       RMSD after fitting. May be NULL
+   Returns: BOOL              Success. FALSE if there are no pairs or
+                              the rotation is not well defined (e.g.
+                              all the points are on a line)
+
+   16.10.26 Original   By: ACRM
+*/
+BOOL QCPFit(REAL corr[3][3], REAL E0, int npairs, REAL rot[3][3],
+            REAL *rmsd)
+{
+   REAL Sxx = corr[0][0], Sxy = corr[0][1], Sxz = corr[0][2],
+        Syx = corr[1][0], Syy = corr[1][1], Syz = corr[1][2],
+        Szx = corr[2][0], Szy = corr[2][1], Szz = corr[2][2],
+        K[4][4],
+        c0, c1, c2,
+        lambda, lambda2, a, b, delta,
+        q[4], qlen, qbest,
+        qw2, qx2, qy2, qz2,
+        qwx, qwy, qwz, qxy, qxz, qyz,
+        msd;
+   int  i, j, best;
+
+   if(npairs < 1)
+      return(FALSE);
+
+   /* Horn's key matrix                                                 */
+   K[0][0] =  Sxx + Syy + Szz;
+   K[0][1] =  Syz - Szy;
+   K[0][2] =  Szx - Sxz;
+   K[0][3] =  Sxy - Syx;
+   K[1][1] =  Sxx - Syy - Szz;
+   K[1][2] =  Sxy + Syx;
+   K[1][3] =  Szx + Sxz;
+   K[2][2] = -Sxx + Syy - Szz;
+   K[2][3] =  Syz + Szy;
+   K[3][3] = -Sxx - Syy + Szz;
+   for(i=1; i<4; i++)
+      for(j=0; j<i; j++)
+         K[i][j] = K[j][i];
+
+   /* Coefficients of the characteristic polynomial
+      lambda^4 + c2 lambda^2 + c1 lambda + c0
+   */
+   c2 = (REAL)0.0;
+   for(i=0; i<3; i++)
+      for(j=0; j<3; j++)
+         c2 += corr[i][j] * corr[i][j];
+   c2 *= (REAL)(-2.0);
+
+   c1 = (REAL)(-8.0) * Det3(Sxx, Sxy, Sxz,
+                            Syx, Syy, Syz,
+                            Szx, Szy, Szz);
+
+   c0 = (REAL)0.0;
+   for(j=0; j<4; j++)
+      c0 += K[0][j] * Cofactor4(K, 0, j);
+
+   /* Newton-Raphson for the largest root, starting from E0 which is an
+      upper bound
+   */
+   lambda = E0;
+   for(i=0; i<QCP_MAXNEWTON; i++)
+   {
+      lambda2 = lambda * lambda;
+      b       = (lambda2 + c2) * lambda;
+      a       = b + c1;
+      delta   = (a * lambda + c0) /
+                ((REAL)2.0 * lambda2 * lambda + b + a);
+      lambda -= delta;
+      if(fabs(delta) < fabs(QCP_EVALPREC * lambda))
+         break;
+   }
+
+   if(rmsd != NULL)
+   {
+      msd   = (REAL)2.0 * (E0 - lambda) / (REAL)npairs;
+      *rmsd = (msd > (REAL)0.0) ? (REAL)sqrt(msd) : (REAL)0.0;
+   }
+
+   if(rot == NULL)
+      return(TRUE);
+
+   /* The eigenvector is any non-zero row of the adjugate of
+      (K - lambda I). Take the longest for accuracy
+   */
+   for(i=0; i<4; i++)
+      K[i][i] -= lambda;
+
+   best  = (-1);
+   qbest = (REAL)0.0;
+   for(i=0; i<4; i++)
+   {
+      REAL row[4];
+
+      qlen = (REAL)0.0;
+      for(j=0; j<4; j++)
+      {
+         row[j] = Cofactor4(K, i, j);
+         qlen  += row[j] * row[j];
+      }
+      if(qlen > qbest)
+      {
+         qbest = qlen;
+         best  = i;
+         for(j=0; j<4; j++)
+            q[j] = row[j];
+      }
+   }
+
+   /* If every row is (nearly) zero the largest eigenvalue is repeated
+      and the rotation is not unique
+   */
+   qlen = (REAL)sqrt(qbest);
+   if((best < 0) || (qlen <= QCP_EVECPREC * E0 * E0 * E0))
+      return(FALSE);
+
+   for(j=0; j<4; j++)
+      q[j] /= qlen;
+
+   /* Rotation matrix from the unit quaternion (w, x, y, z). With the
+      key matrix built this way the quaternion takes the reference onto
+      the mobile set, so this is the transpose of the usual form
+   */
+   qw2 = q[0] * q[0];
+   qx2 = q[1] * q[1];
+   qy2 = q[2] * q[2];
+   qz2 = q[3] * q[3];
+   qwx = q[0] * q[1];
+   qwy = q[0] * q[2];
+   qwz = q[0] * q[3];
+   qxy = q[1] * q[2];
+   qxz = q[1] * q[3];
+   qyz = q[2] * q[3];
+
+   rot[0][0] = qw2 + qx2 - qy2 - qz2;
+   rot[0][1] = (REAL)2.0 * (qxy + qwz);
+   rot[0][2] = (REAL)2.0 * (qxz - qwy);
+   rot[1][0] = (REAL)2.0 * (qxy - qwz);
+   rot[1][1] = qw2 - qx2 + qy2 - qz2;
+   rot[1][2] = (REAL)2.0 * (qyz + qwx);
+   rot[2][0] = (REAL)2.0 * (qxz + qwy);
+   rot[2][1] = (REAL)2.0 * (qyz - qwx);
+   rot[2][2] = qw2 - qx2 - qy2 + qz2;
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static REAL Det3(REAL a, REAL b, REAL c, REAL d, REAL e, REAL f,
+                    REAL g, REAL h, REAL i)
+   ---------------------------------------------------------------
+   Determinant of the 3x3 matrix with rows (a b c), (d e f), (g h i)
+
+   16.10.26 Original   By: ACRM
+*/
+static REAL Det3(REAL a, REAL b, REAL c,
+                 REAL d, REAL e, REAL f,
+                 REAL g, REAL h, REAL i)
+{
+   return(a * (e*i - f*h) - b * (d*i - f*g) + c * (d*h - e*g));
+}
+
+
+/************************************************************************/
+/*>static REAL Cofactor4(REAL m[4][4], int row, int col)
+   -----------------------------------------------------
+   Input:   REAL  m[4][4]     Matrix
+            int   row, col    Element
+   Returns: REAL              Signed cofactor of m[row][col]
+
+   16.10.26 Original   By: ACRM
+*/
+static REAL Cofactor4(REAL m[4][4], int row, int col)
+{
+   REAL minor[3][3],
+        det;
+   int  i, j, mi, mj;
+
+   for(i=0, mi=0; i<4; i++)
+   {
+      if(i == row)
+         continue;
+      for(j=0, mj=0; j<4; j++)
+      {
+         if(j == col)
+            continue;
+         minor[mi][mj++] = m[i][j];
+      }
+      mi++;
+   }
+
+   det = Det3(minor[0][0], minor[0][1], minor[0][2],
+              minor[1][0], minor[1][1], minor[1][2],
+              minor[2][0], minor[2][1], minor[2][2]);
+
+   return(((row + col) % 2) ? -det : det);
+}
@@ -0,0 +1,46 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       qcpfit.h
+
+   Version:    V1.0
+   Date:       16.10.26
+   Function:   Quaternion characteristic polynomial (QCP) superposition
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+
+*************************************************************************/
+#ifndef _QCPFIT_H
+#define _QCPFIT_H
+
+/************************************************************************/
+/* Includes
+*/
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+
+/************************************************************************/
+/* Prototypes
+*/
+BOOL QCPFit(REAL corr[3][3], REAL E0, int npairs, REAL rot[3][3],
+            REAL *rmsd);
+
+#endif
@@ -0,0 +1,641 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       strcache.c
+
+   Version:    V1.1
+   Date:       16.10.26
+   Function:   In-memory cache of structures shared between jobs
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Description:
+   ============
+   When many jobs are run in one process the same structures turn up
+   again and again, and without a cache each job parses them afresh.
+   GetCachedStructure() instead keeps each structure it reads, under
+   the file's canonical path (from realpath()) together with its
+   modification time and size, so a file which has changed is read
+   again.
+
+   An entry holds either just the C-alphas, which is all that finding
+   a core needs, or every atom for jobs which write the structure out.
+   A full entry also serves requests for the C-alphas. Entries are
+   shared between jobs and must not be changed; a job which moves the
+   structure or sets its B-values works on a copy.
+
+   The entries are found through a hash table on the path and kept on
+   a list in the order they were last used. Once the memory they take
+   goes over the budget, entries which no job is using are freed from
+   the end of the list used longest ago. Hits, misses and evictions
+   are counted.
+
+   Every routine may be called from any thread. Files are read without
+   holding the lock, so two threads may read the same new file; the
+   second to finish uses the first one's entry.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original. Generalised from the structures kept by the
+                  findcore server
+   V1.1  16.10.26 A C-alpha entry is trimmed from the structure as read
+                  rather than copied from it
+
+*************************************************************************/
+/* Includes
+*/
+#define _XOPEN_SOURCE 700      /* realpath() and st_mtim                */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/pdb.h"
+#include "bioplib/macros.h"
+#include "pdbload.h"
+#include "strcache.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define STRCACHE_BUCKETS 4096     /* Hash table size (a power of 2)     */
+
+/* A structure in the cache. next and prev are the list in order of
+   use; hnext is the hash chain. A stale entry is for a file which has
+   since changed; it is out of the hash table and is freed as soon as
+   no job is using it.
+*/
+struct strentry
+{
+   char            *path;
+   struct timespec mtime;
+   off_t           size;
+   BOOL            full,      /* Every atom rather than the C-alphas    */
+                   stale;
+   PDB             *pdb;
+   int             natoms,
+                   users;     /* Jobs using it                          */
+   unsigned long   bytes;     /* Memory it takes                        */
+   unsigned int    hash;
+   struct strentry *hnext,
+                   *next,     /* Used less recently                     */
+                   *prev;     /* Used more recently                     */
+};
+
+struct strcache
+{
+   pthread_mutex_t lock;
+   char            *cachedir;
+   unsigned long   budget,
+                   bytes,
+                   hits,
+                   misses,
+                   evicted;
+   STRENTRY        *bucket[STRCACHE_BUCKETS],
+                   *first,    /* Most recently used                     */
+                   *last;     /* Least recently used                    */
+};
+
+/************************************************************************/
+/* Prototypes
+*/
+static unsigned int HashPath(char *path);
+static STRENTRY *FindEntry(STRCACHE *sc, char *path, unsigned int hash,
+                           struct stat *st, BOOL full);
+static void UnhashEntry(STRCACHE *sc, STRENTRY *e);
+static void UnlinkEntry(STRCACHE *sc, STRENTRY *e);
+static void MoveToFront(STRCACHE *sc, STRENTRY *e);
+static void FreeEntry(STRENTRY *e);
+static void DropOldVersions(STRCACHE *sc, char *path, unsigned int hash,
+                            struct stat *st);
+static void EvictEntries(STRCACHE *sc);
+static PDB *KeepCAs(PDB *pdb, int *natoms);
+
+
+/************************************************************************/
+/*>STRCACHE *NewStructCache(unsigned long budget, char *cachedir)
+   --------------------------------------------------------------
+   Input:   unsigned long budget    Bytes the structures may take
+            char          *cachedir C-alpha cache directory for reading
+                                    (NULL for none)
+   Returns: STRCACHE      *         The cache (NULL if no memory)
+
+   16.10.26 Original   By: ACRM
+*/
+STRCACHE *NewStructCache(unsigned long budget, char *cachedir)
+{
+   STRCACHE *sc;
+   int      i;
+
+   if((sc = (STRCACHE *)malloc(sizeof(STRCACHE)))==NULL)
+      return(NULL);
+
+   sc->cachedir = cachedir;
+   sc->budget   = budget;
+   sc->bytes    = sc->hits = sc->misses = sc->evicted = 0;
+   sc->first    = sc->last = NULL;
+   for(i=0; i<STRCACHE_BUCKETS; i++)
+      sc->bucket[i] = NULL;
+   pthread_mutex_init(&(sc->lock), NULL);
+
+   return(sc);
+}
+
+
+/************************************************************************/
+/*>void FreeStructCache(STRCACHE *sc)
+   ----------------------------------
+   I/O:     STRCACHE *sc        Cache to free. No structure may still
+                                be in use. May be NULL
+
+   16.10.26 Original   By: ACRM
+*/
+void FreeStructCache(STRCACHE *sc)
+{
+   STRENTRY *e,
+            *next;
+
+   if(sc == NULL)
+      return;
+
+   for(e=sc->first; e!=NULL; e=next)
+   {
+      next = e->next;
+      FreeEntry(e);
+   }
+   pthread_mutex_destroy(&(sc->lock));
+   free(sc);
+}
+
+
+/************************************************************************/
+/*>STRENTRY *GetCachedStructure(STRCACHE *sc, char *filename, BOOL full,
+                                PDB **pdb, int *natoms)
+   ---------------------------------------------------------------------
+   I/O:     STRCACHE *sc        The cache
+   Input:   char     *filename  PDB file
+            BOOL     full       Every atom is needed, not just the
+                                C-alphas
+   Output:  PDB      **pdb      The structure, which must not be
+                                changed (NULL if it couldn't be read)
+            int      *natoms    Atoms in it (PDBLOAD_NOFILE if the file
+                                couldn't be opened)
+   Returns: STRENTRY *          Entry to give back with
+                                ReleaseCachedStructure() (NULL if the
+                                structure couldn't be read or there was
+                                no memory)
+
+   Finds a structure in the cache, or reads it and adds it. Entries
+   may then be evicted to bring the cache back within its budget.
+
+   16.10.26 Original (from GetWarmStructure() in findcore)   By: ACRM
+   16.10.26 Trims the structure to its C-alphas in place
+*/
+STRENTRY *GetCachedStructure(STRCACHE *sc, char *filename, BOOL full,
+                             PDB **pdb, int *natoms)
+{
+   struct stat  st;
+   STRENTRY     *e,
+                *found;
+   char         *path;
+   unsigned int hash;
+
+   *pdb    = NULL;
+   *natoms = PDBLOAD_NOFILE;
+   if((path = realpath(filename, NULL))==NULL)
+      return(NULL);
+   if(stat(path, &st))
+   {
+      free(path);
+      return(NULL);
+   }
+   hash = HashPath(path);
+
+   pthread_mutex_lock(&(sc->lock));
+   if((e = FindEntry(sc, path, hash, &st, full)) != NULL)
+   {
+      sc->hits++;
+      e->users++;
+      MoveToFront(sc, e);
+   }
+   else
+   {
+      sc->misses++;
+   }
+   pthread_mutex_unlock(&(sc->lock));
+
+   if(e != NULL)
+   {
+      free(path);
+      *pdb    = e->pdb;
+      *natoms = e->natoms;
+      return(e);
+   }
+
+   /* Read the structure without holding the lock                      */
+   LoadPDBFiles(&filename, 1, !full, sc->cachedir, pdb, natoms, NULL);
+   if((*pdb != NULL) && !full)
+      *pdb = KeepCAs(*pdb, natoms);
+   if(*pdb == NULL)
+   {
+      free(path);
+      return(NULL);
+   }
+   if((e = (STRENTRY *)malloc(sizeof(STRENTRY)))==NULL)
+   {
+      FREELIST(*pdb, PDB);
+      free(path);
+      return(NULL);
+   }
+   e->path   = path;
+   e->mtime  = st.st_mtim;
+   e->size   = st.st_size;
+   e->full   = full;
+   e->stale  = FALSE;
+   e->pdb    = *pdb;
+   e->natoms = *natoms;
+   e->users  = 1;
+   e->hash   = hash;
+   e->bytes  = sizeof(STRENTRY) + strlen(path) + 1 +
+               (unsigned long)(*natoms) * sizeof(PDB);
+
+   pthread_mutex_lock(&(sc->lock));
+   if((found = FindEntry(sc, path, hash, &st, full)) != NULL)
+   {
+      /* Another thread read it first                                   */
+      found->users++;
+      MoveToFront(sc, found);
+      pthread_mutex_unlock(&(sc->lock));
+      FreeEntry(e);
+      *pdb    = found->pdb;
+      *natoms = found->natoms;
+      return(found);
+   }
+
+   DropOldVersions(sc, path, hash, &st);
+
+   e->hnext = sc->bucket[hash];
+   sc->bucket[hash] = e;
+   e->prev = NULL;
+   e->next = sc->first;
+   if(sc->first != NULL)
+      sc->first->prev = e;
+   else
+      sc->last = e;
+   sc->first  = e;
+   sc->bytes += e->bytes;
+
+   EvictEntries(sc);
+   pthread_mutex_unlock(&(sc->lock));
+
+   return(e);
+}
+
+
+/************************************************************************/
+/*>void ReleaseCachedStructure(STRCACHE *sc, STRENTRY *entry)
+   ----------------------------------------------------------
+   I/O:     STRCACHE *sc        The cache
+            STRENTRY *entry     Entry from GetCachedStructure()
+
+   16.10.26 Original (from ReleaseWarmStructure() in findcore)
+            By: ACRM
+*/
+void ReleaseCachedStructure(STRCACHE *sc, STRENTRY *entry)
+{
+   pthread_mutex_lock(&(sc->lock));
+   if(--(entry->users) == 0)
+   {
+      if(entry->stale)
+      {
+         UnlinkEntry(sc, entry);
+         FreeEntry(entry);
+      }
+      else
+      {
+         EvictEntries(sc);
+      }
+   }
+   pthread_mutex_unlock(&(sc->lock));
+}
+
+
+/************************************************************************/
+/*>void StructCacheStats(STRCACHE *sc, unsigned long *hits,
+                         unsigned long *misses, unsigned long *evicted,
+                         unsigned long *bytes)
+   ----------------------------------------------------------------------
+   Input:   STRCACHE      *sc       The cache
+   Output:  unsigned long *hits     Structures found in the cache
+            unsigned long *misses   Structures which had to be read
+            unsigned long *evicted  Entries freed to stay in budget
+            unsigned long *bytes    Memory the entries take now
+
+   16.10.26 Original   By: ACRM
+*/
+void StructCacheStats(STRCACHE *sc, unsigned long *hits,
+                      unsigned long *misses, unsigned long *evicted,
+                      unsigned long *bytes)
+{
+   pthread_mutex_lock(&(sc->lock));
+   *hits    = sc->hits;
+   *misses  = sc->misses;
+   *evicted = sc->evicted;
+   *bytes   = sc->bytes;
+   pthread_mutex_unlock(&(sc->lock));
+}
+
+
+/************************************************************************/
+/*>void ReportStructCache(FILE *fp, STRCACHE *sc)
+   ----------------------------------------------
+   Input:   FILE     *fp        Output file
+            STRCACHE *sc        The cache
+
+   Prints a line of the cache's statistics
+
+   16.10.26 Original   By: ACRM
+*/
+void ReportStructCache(FILE *fp, STRCACHE *sc)
+{
+   unsigned long hits, misses, evicted, bytes;
+
+   StructCacheStats(sc, &hits, &misses, &evicted, &bytes);
+   fprintf(fp,"Structure cache: %lu hits, %lu misses (%.1f%% hits), \
+%lu evicted, %.1f Mbytes held\n",
+           hits, misses,
+           (hits + misses) ? (100.0 * hits) / (hits + misses) : 0.0,
+           evicted, bytes / 1048576.0);
+}
+
+
+/************************************************************************/
+/*>static unsigned int HashPath(char *path)
+   ----------------------------------------
+   Input:   char         *path  Canonical path
+   Returns: unsigned int        Hash table bucket
+
+   16.10.26 Original   By: ACRM
+*/
+static unsigned int HashPath(char *path)
+{
+   unsigned int hash = 5381;
+
+   while(*path)
+      hash = (hash * 33) ^ (unsigned char)*(path++);
+   return(hash & (STRCACHE_BUCKETS - 1));
+}
+
+
+/************************************************************************/
+/*>static STRENTRY *FindEntry(STRCACHE *sc, char *path,
+                              unsigned int hash, struct stat *st,
+                              BOOL full)
+   ------------------------------------------------------
+   Input:   STRCACHE     *sc    The cache (locked)
+            char         *path  Canonical path
+            unsigned int hash   Its bucket
+            struct stat  *st    The file's status
+            BOOL         full   Every atom is needed
+   Returns: STRENTRY     *      Entry for this version of the file
+                                (NULL if there isn't one)
+
+   16.10.26 Original   By: ACRM
+*/
+static STRENTRY *FindEntry(STRCACHE *sc, char *path, unsigned int hash,
+                           struct stat *st, BOOL full)
+{
+   STRENTRY *e;
+
+   for(e=sc->bucket[hash]; e!=NULL; e=e->hnext)
+   {
+      if((e->mtime.tv_sec  == st->st_mtim.tv_sec)  &&
+         (e->mtime.tv_nsec == st->st_mtim.tv_nsec) &&
+         (e->size          == st->st_size)         &&
+         (e->full || !full)                        &&
+         !strcmp(e->path, path))
+         return(e);
+   }
+   return(NULL);
+}
+
+
+/************************************************************************/
+/*>static void DropOldVersions(STRCACHE *sc, char *path,
+                               unsigned int hash, struct stat *st)
+   ---------------------------------------------------------------
+   I/O:     STRCACHE     *sc    The cache (locked)
+   Input:   char         *path  Canonical path
+            unsigned int hash   Its bucket
+            struct stat  *st    The file's status now
+
+   Removes the entries for earlier versions of a file. Any still in use
+   are marked stale and freed when they are given back.
+
+   16.10.26 Original   By: ACRM
+*/
+static void DropOldVersions(STRCACHE *sc, char *path, unsigned int hash,
+                            struct stat *st)
+{
+   STRENTRY *e,
+            *next;
+
+   for(e=sc->bucket[hash]; e!=NULL; e=next)
+   {
+      next = e->hnext;
+      if(strcmp(e->path, path) ||
+         ((e->mtime.tv_sec  == st->st_mtim.tv_sec)  &&
+          (e->mtime.tv_nsec == st->st_mtim.tv_nsec) &&
+          (e->size          == st->st_size)))
+         continue;
+
+      UnhashEntry(sc, e);
+      if(e->users)
+      {
+         e->stale = TRUE;
+      }
+      else
+      {
+         UnlinkEntry(sc, e);
+         FreeEntry(e);
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>static void EvictEntries(STRCACHE *sc)
+   --------------------------------------
+   I/O:     STRCACHE *sc        The cache (locked)
+
+   Frees the unused entries used longest ago until the cache is within
+   its budget
+
+   16.10.26 Original   By: ACRM
+*/
+static void EvictEntries(STRCACHE *sc)
+{
+   STRENTRY *e,
+            *prev;
+
+   for(e=sc->last; (e!=NULL) && (sc->bytes > sc->budget); e=prev)
+   {
+      prev = e->prev;
+      if(e->users)
+         continue;
+
+      if(!e->stale)
+         UnhashEntry(sc, e);
+      UnlinkEntry(sc, e);
+      FreeEntry(e);
+      sc->evicted++;
+   }
+}
+
+
+/************************************************************************/
+/*>static void UnhashEntry(STRCACHE *sc, STRENTRY *e)
+   --------------------------------------------------
+   Takes an entry out of its hash chain
+
+   16.10.26 Original   By: ACRM
+*/
+static void UnhashEntry(STRCACHE *sc, STRENTRY *e)
+{
+   STRENTRY **pe;
+
+   for(pe=&(sc->bucket[e->hash]); *pe!=NULL; pe=&((*pe)->hnext))
+   {
+      if(*pe == e)
+      {
+         *pe = e->hnext;
+         break;
+      }
+   }
+}
+
+
+/************************************************************************/
+/*>static void UnlinkEntry(STRCACHE *sc, STRENTRY *e)
+   --------------------------------------------------
+   Takes an entry off the list in order of use and out of the memory
+   count
+
+   16.10.26 Original   By: ACRM
+*/
+static void UnlinkEntry(STRCACHE *sc, STRENTRY *e)
+{
+   if(e->prev != NULL)
+      e->prev->next = e->next;
+   else
+      sc->first = e->next;
+   if(e->next != NULL)
+      e->next->prev = e->prev;
+   else
+      sc->last = e->prev;
+   sc->bytes -= e->bytes;
+}
+
+
+/************************************************************************/
+/*>static void MoveToFront(STRCACHE *sc, STRENTRY *e)
+   --------------------------------------------------
+   Marks an entry as the one used most recently
+
+   16.10.26 Original   By: ACRM
+*/
+static void MoveToFront(STRCACHE *sc, STRENTRY *e)
+{
+   if(sc->first == e)
+      return;
+
+   UnlinkEntry(sc, e);
+   sc->bytes += e->bytes;
+   e->prev = NULL;
+   e->next = sc->first;
+   if(sc->first != NULL)
+      sc->first->prev = e;
+   else
+      sc->last = e;
+   sc->first = e;
+}
+
+
+/************************************************************************/
+/*>static void FreeEntry(STRENTRY *e)
+   ----------------------------------
+   16.10.26 Original   By: ACRM
+*/
+static void FreeEntry(STRENTRY *e)
+{
+   FREELIST(e->pdb, PDB);
+   free(e->path);
+   free(e);
+}
+
+
+/************************************************************************/
+/*>static PDB *KeepCAs(PDB *pdb, int *natoms)
+   ------------------------------------------
+   Input:   PDB    *pdb         Structure
+   Output:  int    *natoms      Number of C-alphas
+   Returns: PDB    *            Its C-alphas (NULL if none)
+
+   Cuts a structure down to its C-alphas, so that an entry takes as
+   little memory as it can. The other atoms are unlinked and freed,
+   so a structure which came from the C-alpha cache is left as it is.
+   The atoms are picked as BuildCAStore() picks them.
+
+   16.10.26 Original   By: ACRM
+   16.10.26 Trims the list in place rather than copying the C-alphas
+*/
+static PDB *KeepCAs(PDB *pdb, int *natoms)
+{
+   PDB *p,
+       *next,
+       *first = NULL,
+       *last  = NULL;
+
+   *natoms = 0;
+   for(p=pdb; p!=NULL; p=next)
+   {
+      next = p->next;
+      if(strncmp(p->atnam, "CA  ", 4))
+      {
+         free(p);
+         continue;
+      }
+
+      p->next = NULL;
+      if(last == NULL)
+         first = p;
+      else
+         last->next = p;
+      last = p;
+      (*natoms)++;
+   }
+   return(first);
+}
@@ -0,0 +1,62 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       strcache.h
+
+   Version:    V1.0
+   Date:       16.10.26
+   Function:   In-memory cache of structures shared between jobs
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+
+*************************************************************************/
+#ifndef _STRCACHE_H
+#define _STRCACHE_H
+
+/************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/pdb.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define STRCACHE_DEFAULTMB 512    /* Default memory budget (Mbytes)     */
+
+typedef struct strcache STRCACHE;
+typedef struct strentry STRENTRY;
+
+/************************************************************************/
+/* Prototypes
+*/
+STRCACHE *NewStructCache(unsigned long budget, char *cachedir);
+void FreeStructCache(STRCACHE *sc);
+STRENTRY *GetCachedStructure(STRCACHE *sc, char *filename, BOOL full,
+                             PDB **pdb, int *natoms);
+void ReleaseCachedStructure(STRCACHE *sc, STRENTRY *entry);
+void StructCacheStats(STRCACHE *sc, unsigned long *hits,
+                      unsigned long *misses, unsigned long *evicted,
+                      unsigned long *bytes);
+void ReportStructCache(FILE *fp, STRCACHE *sc);
+
+#endif
@@ -0,0 +1,32 @@
+#!/usr/bin/perl
+# Sends each job read from standard input to a findcore server and
+# writes each reply to standard output: the 'status nout nerr' line,
+# then the zones, then the error messages.
+#
+# Usage: client.pl socket <jobs
+use strict;
+use IO::Socket::UNIX;
+
+my $sock = IO::Socket::UNIX->new(Type => SOCK_STREAM, Peer => $ARGV[0])
+    or die "Unable to connect to $ARGV[0]: $!\n";
+
+while(my $job = <STDIN>)
+{
+    next if(($job =~ /^\s*$/) || ($job =~ /^\s*#/));
+    print $sock $job;
+    $sock->flush();
+
+    my $reply = <$sock>;
+    defined($reply) or die "No reply to: $job";
+    print $reply;
+    my ($status, $nout, $nerr) = split(' ', $reply);
+    my $data = '';
+    while(length($data) < $nout + $nerr)
+    {
+        my $n = read($sock, $data, $nout + $nerr - length($data),
+                     length($data));
+        die "Reply cut short\n" if(!$n);
+    }
+    print $data;
+}
+close($sock);
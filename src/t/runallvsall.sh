@@ -0,0 +1,39 @@
+# All-vs-all mode: the core of each pair of structures in
+# structures.lst, with its alignment found as ./fa_fb.ssap and so on,
+# must be the same as from a single run. So must the core of each job
+# in a manifest naming those structures
+fail=0
+check()
+{
+   if ! cmp -s $1 $2; then
+      echo "allvsall: $3"
+      fail=1
+   fi
+}
+
+../findcore -t 2 -a structures.lst . >allvsall.tmp
+status=$?
+(echo "Job 1: ./fa_fb.ssap fa.pdb fb.pdb"
+ ../findcore fa_fb.ssap fa.pdb fb.pdb
+ echo "Job 2: ./fa_fc.ssap fa.pdb fc.pdb"
+ ../findcore fa_fc.ssap fa.pdb fc.pdb
+ echo "Job 3: ./fb_fc.ssap fb.pdb fc.pdb"
+ ../findcore fb_fc.ssap fb.pdb fc.pdb) >single.tmp
+if [ $status -ne 0 ]; then
+   echo "allvsall: exit status $status, not 0"
+   fail=1
+fi
+check allvsall.tmp single.tmp "zones differ from single runs"
+
+printf 'fb_fc.ssap fb.pdb fc.pdb 2.0\nfa_fb.ssap fa.pdb fb.pdb\n' \
+   >jobs.tmp
+../findcore -a structures.lst -b jobs.tmp >allvsall.tmp
+(echo "Job 1: fb_fc.ssap fb.pdb fc.pdb"
+ ../findcore -d 2.0 fb_fc.ssap fb.pdb fc.pdb
+ echo "Job 2: fa_fb.ssap fa.pdb fb.pdb"
+ ../findcore fa_fb.ssap fa.pdb fb.pdb) >single.tmp
+check allvsall.tmp single.tmp "manifest zones differ from single runs"
+
+rm -f allvsall.tmp single.tmp jobs.tmp
+[ $fail -eq 0 ] && echo "allvsall: ok"
+exit $fail
@@ -0,0 +1,35 @@
+# Batch mode: the jobs in batch.lst must give the zones in batch.out,
+# each the same as from a single run, and the job with a missing
+# structure must be reported in batch.err under its job header, giving
+# an exit status of 1
+fail=0
+check()
+{
+   if ! cmp -s $1 $2; then
+      echo "batch: $3"
+      fail=1
+   fi
+}
+
+../findcore -t 2 -b batch.lst >batch.tmp 2>batcherr.tmp
+status=$?
+if [ $status -ne 1 ]; then
+   echo "batch: exit status $status, not 1"
+   fail=1
+fi
+check batch.tmp batch.out "zones differ from batch.out"
+check batcherr.tmp batch.err "errors differ from batch.err"
+
+(echo "Job 1: fa_fb.ssap fa.pdb fb.pdb"
+ ../findcore fa_fb.ssap fa.pdb fb.pdb
+ echo "Job 2: ga_gb.ssap ga.pdb gb.pdb"
+ ../findcore -d 2.5 ga_gb.ssap ga.pdb gb.pdb
+ echo "Job 4: ga_gb.ssap ga.pdb gb.pdb"
+ ../findcore ga_gb.ssap ga.pdb gb.pdb
+ echo "Job 5: fa_fb.ssap fa.pdb fb.pdb"
+ ../findcore -d 4.0 fa_fb.ssap fa.pdb fb.pdb) >single.tmp
+check batch.tmp single.tmp "zones differ from single runs"
+
+rm -f batch.tmp batcherr.tmp single.tmp
+[ $fail -eq 0 ] && echo "batch: ok"
+exit $fail
@@ -0,0 +1,35 @@
+# Structure caches: the jobs in batch.lst must give the zones in
+# batch.out whether the structures are kept within a small memory
+# budget (-l) or read from a C-alpha cache directory (-k), when that
+# cache is first filled and when it is then read, and findcora must
+# give the same core for fam.cora read through the cache directory
+fail=0
+check()
+{
+   if ! cmp -s $1 $2; then
+      echo "cache: $3"
+      fail=1
+   fi
+}
+
+rm -rf cache.tmp
+mkdir cache.tmp
+../findcore -t 2 -l 1 -b batch.lst >small.tmp 2>/dev/null
+../findcore -t 2 -k cache.tmp -b batch.lst >cold.tmp 2>/dev/null
+../findcore -t 2 -k cache.tmp -b batch.lst >warm.tmp 2>/dev/null
+check small.tmp batch.out "-l 1 differs from batch.out"
+check cold.tmp batch.out "-k differs from batch.out filling the cache"
+check warm.tmp batch.out "-k differs from batch.out reading the cache"
+if [ -z "`ls cache.tmp`" ]; then
+   echo "cache: nothing written to the cache directory"
+   fail=1
+fi
+
+../findcora -v -k cache.tmp fam.cora >cold.tmp
+../findcora -v -k cache.tmp fam.cora >warm.tmp
+check cold.tmp fitcora.out "findcora -k differs filling the cache"
+check warm.tmp fitcora.out "findcora -k differs reading the cache"
+
+rm -rf cache.tmp small.tmp cold.tmp warm.tmp
+[ $fail -eq 0 ] && echo "cache: ok"
+exit $fail
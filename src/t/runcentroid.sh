@@ -0,0 +1,28 @@
+# Deviation tests: with the 18 structures of big.cora, -m pairs bounds
+# the pairwise test by the centroid and must still give the zones found
+# by testing every pair, which are in bigpairs.out. -m centroid gives
+# those in bigcentroid.out. For the two structures of pair.cora every
+# C-alpha is half the pair's distance from the centroid, so -m centroid
+# at 1.5A must give what -m pairs gives at 3A
+fail=0
+check()
+{
+   if ! cmp -s $1 $2; then
+      echo "centroid: $3"
+      fail=1
+   fi
+}
+
+../findcora -v -d 4.0 -m pairs big.cora >pairs.tmp
+../findcora -v -d 4.0 -m centroid big.cora >centroid.tmp
+check pairs.tmp bigpairs.out "-m pairs differs from bigpairs.out"
+check centroid.tmp bigcentroid.out \
+      "-m centroid differs from bigcentroid.out"
+
+../findcora -v -d 3.0 -m pairs pair.cora >pairs.tmp
+../findcora -v -d 1.5 -m centroid pair.cora >centroid.tmp
+check centroid.tmp pairs.tmp "-m centroid at dcut/2 differs from -m pairs"
+
+rm -f pairs.tmp centroid.tmp
+[ $fail -eq 0 ] && echo "centroid: ok"
+exit $fail
@@ -0,0 +1,17 @@
+# Random coil zones: with -n, findcora also starts zones at runs of
+# positions where no structure is strand or helix. The starting zones
+# and core for fam.cora must be those in coil.out
+fail=0
+../findcora -v -n fam.cora >coil.tmp
+if ! cmp -s coil.tmp coil.out; then
+   echo "coil: -n differs from coil.out"
+   fail=1
+fi
+if cmp -s coil.tmp fitcora.out; then
+   echo "coil: -n makes no difference"
+   fail=1
+fi
+
+rm -f coil.tmp
+[ $fail -eq 0 ] && echo "coil: ok"
+exit $fail
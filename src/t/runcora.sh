@@ -0,0 +1,30 @@
+# CORA parser: famfmt.cora is fam.cora with comment lines, tabs and
+# zero-padded residue labels and must give the same core, which is in
+# fitcora.out. A file cut short must be rejected
+fail=0
+check()
+{
+   if ! cmp -s $1 $2; then
+      echo "cora: $3"
+      fail=1
+   fi
+}
+
+../findcora -v fam.cora >fam.tmp
+../findcora -v famfmt.cora >famfmt.tmp
+check fam.tmp fitcora.out "fam.cora differs from fitcora.out"
+check famfmt.tmp fam.tmp "famfmt.cora differs from fam.cora"
+
+head -50 fam.cora >short.tmp
+../findcora -v short.tmp >famshort.tmp 2>&1
+status=$?
+echo "No Zones read from short.tmp" >expect.tmp
+if [ $status -ne 1 ]; then
+   echo "cora: exit status $status for a short file, not 1"
+   fail=1
+fi
+check famshort.tmp expect.tmp "short file not reported"
+
+rm -f fam.tmp famfmt.tmp short.tmp famshort.tmp expect.tmp
+[ $fail -eq 0 ] && echo "cora: ok"
+exit $fail
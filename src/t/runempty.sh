@@ -0,0 +1,32 @@
+# Empty core: at 0.1A the initial cut removes every pair. There is then
+# no fit, so no RMSD may be given (the fitting sums would still be
+# those of the starting zones) and there are no final zones. findcore
+# -n and findcora -g don't keep running sums here, so they are the cases
+# which used to report the starting zones' RMSD
+fail=0
+check()
+{
+   if ! cmp -s $1 $2; then
+      echo "empty: $3"
+      fail=1
+   fi
+}
+
+echo "Core RMSD: none, the core is empty" >expect.tmp
+../findcore -v -i -n -d 0.1 fa_fb.ssap fa.pdb fb.pdb >out.tmp
+grep '^Core RMSD' out.tmp >rmsd.tmp
+check rmsd.tmp expect.tmp "findcore gives an RMSD"
+sed -n '/^Final Zones:/,$p' out.tmp >zones.tmp
+echo "Final Zones:" >expect.tmp
+check zones.tmp expect.tmp "findcore gives final zones"
+
+for s in 1 2 3 4 5; do
+   echo "fam$s : none, the core is empty"
+done >expect.tmp
+../findcora -v -i -g -d 0.1 fam.cora >out.tmp
+grep '^fam[1-5] :' out.tmp >rmsd.tmp
+check rmsd.tmp expect.tmp "findcora gives RMSDs"
+
+rm -f expect.tmp out.tmp rmsd.tmp zones.tmp
+[ $fail -eq 0 ] && echo "empty: ok"
+exit $fail
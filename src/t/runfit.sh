@@ -0,0 +1,30 @@
+# Fitting backends: -f qcp must give the zones and core RMSDs that
+# -f matfit gives, for findcore on fa/fb and ga/gb and for findcora on
+# the five structures of fam.cora, and those must be the ones in
+# fitcore.out and fitcora.out
+fail=0
+check()
+{
+   if ! cmp -s $1 $2; then
+      echo "fit: $3"
+      fail=1
+   fi
+}
+
+../findcore -v -f matfit fa_fb.ssap fa.pdb fb.pdb >matfit.tmp
+../findcore -v -f qcp fa_fb.ssap fa.pdb fb.pdb >qcp.tmp
+check matfit.tmp fitcore.out "findcore -f matfit differs from fitcore.out"
+check qcp.tmp matfit.tmp "findcore -f qcp differs from -f matfit on fa/fb"
+
+../findcore -v -f matfit ga_gb.ssap ga.pdb gb.pdb >matfit.tmp
+../findcore -v -f qcp ga_gb.ssap ga.pdb gb.pdb >qcp.tmp
+check qcp.tmp matfit.tmp "findcore -f qcp differs from -f matfit on ga/gb"
+
+../findcora -v -f matfit fam.cora >matfit.tmp
+../findcora -v -f qcp fam.cora >qcp.tmp
+check matfit.tmp fitcora.out "findcora -f matfit differs from fitcora.out"
+check qcp.tmp matfit.tmp "findcora -f qcp differs from -f matfit"
+
+rm -f matfit.tmp qcp.tmp
+[ $fail -eq 0 ] && echo "fit: ok"
+exit $fail
@@ -0,0 +1,19 @@
+# Mean structure fitting: -g on fam.cora must give the zones and RMSDs
+# from the mean in gpa.out, whatever the number of threads
+fail=0
+check()
+{
+   if ! cmp -s $1 $2; then
+      echo "gpa: $3"
+      fail=1
+   fi
+}
+
+../findcora -v -g -t 1 fam.cora >gpa1.tmp
+../findcora -v -g -t 3 fam.cora >gpa3.tmp
+check gpa1.tmp gpa.out "-g differs from gpa.out"
+check gpa3.tmp gpa1.tmp "-g -t 3 differs from -g -t 1"
+
+rm -f gpa1.tmp gpa3.tmp
+[ $fail -eq 0 ] && echo "gpa: ok"
+exit $fail
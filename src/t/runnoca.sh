@@ -0,0 +1,59 @@
+# Zone ends without C-alphas: a structure which has lost the C-alpha of
+# the first or last residue of a starting zone (11 and 19 of fb, 193 of
+# fam2) must be rejected with an error and an exit status of 1, by
+# findcore on its own and in a batch and by findcora, and no zones may
+# be written for it
+fail=0
+check()
+{
+   if ! cmp -s $1 $2; then
+      echo "noca: $3"
+      fail=1
+   fi
+}
+status()
+{
+   if [ $1 -ne 1 ]; then
+      echo "noca: $2 exit status $1"
+      fail=1
+   fi
+}
+
+noca()
+{
+   awk -v res=$2 '!(/^ATOM/ && substr($0,13,4)==" CA " &&
+                    substr($0,23,4)+0==res)' $1
+}
+
+noca fb.pdb 11 >fb11.tmp
+noca fb.pdb 19 >fb19.tmp
+noca fam2 193 >fam2.tmp
+sed '2s/fam2/fam2.tmp/' fam.cora >fam.tmp
+
+echo "SSAP zone starts or ends at a residue with no C-alpha" >msg.tmp
+for pdb in fb11.tmp fb19.tmp; do
+   ../findcore -i fa_fb.ssap fa.pdb $pdb >out.tmp 2>err.tmp
+   status $? "findcore on $pdb"
+   check out.tmp /dev/null "findcore wrote zones for $pdb"
+   check err.tmp msg.tmp "findcore error for $pdb"
+done
+
+(echo "Job 1: fa_fb.ssap fa.pdb fb19.tmp"; cat msg.tmp) >expect.tmp
+echo "fa_fb.ssap fa.pdb fb19.tmp" | ../findcore -b - >out.tmp 2>err.tmp
+status $? "batch"
+check out.tmp /dev/null "batch wrote zones"
+check err.tmp expect.tmp "batch error report"
+
+echo "CORA zone starts or ends at a residue with no C-alpha" >msg.tmp
+../findcora -v fam.tmp >out.tmp 2>err.tmp
+status $? "findcora"
+check err.tmp msg.tmp "findcora error"
+if grep -q "Final Zones" out.tmp; then
+   echo "noca: findcora wrote zones"
+   fail=1
+fi
+
+rm -f fb11.tmp fb19.tmp fam2.tmp fam.tmp msg.tmp expect.tmp out.tmp \
+      err.tmp
+[ $fail -eq 0 ] && echo "noca: ok"
+exit $fail
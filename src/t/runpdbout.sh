@@ -0,0 +1,34 @@
+# Core PDB files: findcora -p must write each structure of fam.cora to
+# a .core file with its atoms unchanged apart from B-values of 10 in
+# the final zones and 0 elsewhere
+fail=0
+../findcora -v -p -t 3 fam.cora | sed -n '/^Final/,$p' | grep : >zones.tmp
+for s in 1 2 3 4 5; do
+   awk -v s=$s 'NR == FNR {
+                   split($0, f, ":")
+                   split(f[s], r, "-")
+                   lo[NR] = r[1] + 0
+                   hi[NR] = r[2] + 0
+                   nz = NR
+                   next
+                }
+                /^ATOM/ {
+                   res = substr($0, 23, 4) + 0
+                   b = 0
+                   for(z=1; z<=nz; z++)
+                      if((res >= lo[z]) && (res <= hi[z]))
+                         b = 10
+                   printf("%s%6.2f\n", substr($0, 1, 60), b)
+                }' zones.tmp fam$s >expect.tmp
+   if [ ! -f fam$s.core ]; then
+      echo "pdbout: fam$s.core not written"
+      fail=1
+   elif ! grep '^ATOM' fam$s.core | cut -c1-66 | cmp -s - expect.tmp; then
+      echo "pdbout: fam$s.core is wrong"
+      fail=1
+   fi
+done
+
+rm -f zones.tmp expect.tmp fam[1-5].core
+[ $fail -eq 0 ] && echo "pdbout: ok"
+exit $fail
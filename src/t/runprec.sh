@@ -0,0 +1,50 @@
+# Single precision: -c must write the zones that -r writes and list on
+# stderr each zone found only in single or only in double precision.
+# The check is run on ga/gb as given, where the zones match at 3A, and
+# moved 9000A from the origin, where floats hold the coordinates to
+# about 0.001A and at 2.616A one zone differs here
+fail=0
+check()
+{
+   if ! cmp -s $1 $2; then
+      echo "prec: $3"
+      fail=1
+   fi
+}
+
+awk '/^ATOM/{printf("%s%8.3f%8.3f%8.3f%s\n", substr($0,1,30),
+     substr($0,31,8)+9000, substr($0,39,8)+9000, substr($0,47,8)+9000,
+     substr($0,55))}' ga.pdb >gafar.tmp
+awk '/^ATOM/{printf("%s%8.3f%8.3f%8.3f%s\n", substr($0,1,30),
+     substr($0,31,8)+9100, substr($0,39,8)+9050, substr($0,47,8)+8950,
+     substr($0,55))}' gb.pdb >gbfar.tmp
+
+for job in "3.0 ga.pdb gb.pdb" "2.616 gafar.tmp gbfar.tmp"; do
+   set -- $job
+   ../findcore -d $1 ga_gb.ssap $2 $3 >double.tmp
+   ../findcore -r -d $1 ga_gb.ssap $2 $3 >single.tmp
+   ../findcore -c -d $1 ga_gb.ssap $2 $3 >check.tmp 2>report.tmp
+   (grep -vxFf double.tmp single.tmp | sed 's/^/Single only: /'
+    grep -vxFf single.tmp double.tmp | sed 's/^/Double only: /') \
+      >diffs.tmp
+   if [ ! -s diffs.tmp ]; then
+      echo "Single precision zones match double precision" >diffs.tmp
+   fi
+   check check.tmp single.tmp "-c zones differ from -r at $1A"
+   check report.tmp diffs.tmp "-c report is wrong at $1A"
+done
+if [ "`head -1 report.tmp`" = \
+     "Single precision zones match double precision" ]; then
+   echo "prec: no single precision difference to report"
+fi
+
+../findcora -v -r fam.cora | sed -n '/^Final/,$p' >single.tmp
+../findcora -v -c fam.cora 2>report.tmp | sed -n '/^Final/,$p' >check.tmp
+check check.tmp single.tmp "findcora -c zones differ from -r"
+echo "Single precision zones match double precision" >diffs.tmp
+check report.tmp diffs.tmp "findcora -c report is wrong"
+
+rm -f gafar.tmp gbfar.tmp double.tmp single.tmp check.tmp report.tmp \
+      diffs.tmp
+[ $fail -eq 0 ] && echo "prec: ok"
+exit $fail
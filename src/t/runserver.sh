@@ -0,0 +1,24 @@
+# Server mode: the jobs in batch.lst are sent to a server through
+# client.pl and each reply (status line, zones and errors) must be the
+# one in server.out
+rm -f server.sock
+../findcore -t 2 -u server.sock &
+pid=$!
+n=0
+while [ ! -S server.sock ] && [ $n -lt 50 ]; do
+   sleep 1
+   n=`expr $n + 1`
+done
+
+fail=0
+perl client.pl server.sock <batch.lst >server.tmp || fail=1
+if ! cmp -s server.tmp server.out; then
+   echo "server: replies differ from server.out"
+   fail=1
+fi
+
+kill $pid
+wait $pid
+rm -f server.sock server.tmp
+[ $fail -eq 0 ] && echo "server: ok"
+exit $fail
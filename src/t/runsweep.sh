@@ -0,0 +1,33 @@
+# Cutoff sweep: a list and a range of cutoffs must give the zones in
+# sweep.out, which are those from a single run at each cutoff. With -w
+# (which gives the same zones here) 2A and 3A must seed the next cutoff
+# even with a thread for every cutoff
+fail=0
+check()
+{
+   if ! cmp -s $1 $2; then
+      echo "sweep: $3"
+      fail=1
+   fi
+}
+
+../findcore -t 2 -d 2.0,3.0,4.0 ga_gb.ssap ga.pdb gb.pdb >list.tmp
+../findcore -t 2 -d 2.0:4.0:1.0 ga_gb.ssap ga.pdb gb.pdb >range.tmp
+(for d in 2 3 4; do
+    echo "Cutoff $d:"
+    ../findcore -d $d ga_gb.ssap ga.pdb gb.pdb
+ done) >single.tmp
+check list.tmp sweep.out "list differs from sweep.out"
+check range.tmp sweep.out "range differs from sweep.out"
+check list.tmp single.tmp "zones differ from single runs"
+
+../findcore -w -t 3 -d 2.0,3.0,4.0 ga_gb.ssap ga.pdb gb.pdb >warm.tmp
+check warm.tmp sweep.out "-w differs from sweep.out"
+../findcore -v -w -t 3 -d 2.0,3.0,4.0 ga_gb.ssap ga.pdb gb.pdb | \
+   grep '^Zones from cutoff' >seeds.tmp
+(echo "Zones from cutoff 2:"; echo "Zones from cutoff 3:") >expect.tmp
+check seeds.tmp expect.tmp "-w -t 3 doesn't warm start"
+
+rm -f list.tmp range.tmp single.tmp warm.tmp seeds.tmp expect.tmp
+[ $fail -eq 0 ] && echo "sweep: ok"
+exit $fail
@@ -0,0 +1,604 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       zonelist.c
+
+   Version:    V1.2
+   Date:       16.10.26
+   Function:   Zones of equivalent residues held as a contiguous array
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Description:
+   ============
+   The zones used to be a doubly linked list with room for the maximum
+   number of structures in every node, and merging them restarted a
+   full pass every time a zone was removed. Here they are held as one
+   array of starts and one of ends with just nstruc entries per zone,
+   in alignment order.
+
+   MergeZones() is shared by findcore and findcora. For two structures
+   it gives the same zones as the old findcore version.
+
+**************************************************************************
+
+   Usage:
+   ======
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 Added DupZoneList() and ReportZoneDiffs()
+   V1.2  16.10.26 Added SetBValByZone() from findcore
+
+*************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/MathType.h"
+#include "bioplib/pdb.h"
+#include "bioplib/macros.h"
+#include "zonelist.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define ZONECHUNK 16
+
+/* Struct 0 range of a zone with its position in the list               */
+typedef struct
+{
+   int start,
+       end,
+       pos;
+}  ZONERANGE;
+
+/************************************************************************/
+/* Prototypes
+*/
+static void CopyZone(ZONELIST *zl, int from, int to);
+static int CompareRanges(const void *r1, const void *r2);
+static BOOL RemoveSubsetZones(ZONELIST *zl);
+static BOOL ZoneInList(ZONELIST *zl, ZONELIST *from, int z);
+static void PrintZone(FILE *fp, ZONELIST *zl, int z);
+
+
+/************************************************************************/
+/*>ZONELIST *NewZoneList(int nstruc)
+   ---------------------------------
+   Input:   int       nstruc    Number of structures
+   Returns: ZONELIST  *         New empty zone list (NULL if no memory)
+
+   16.10.26 Original   By: ACRM
+*/
+ZONELIST *NewZoneList(int nstruc)
+{
+   ZONELIST *zl;
+
+   if((zl = (ZONELIST *)malloc(sizeof(ZONELIST)))==NULL)
+      return(NULL);
+
+   zl->nzones   = 0;
+   zl->maxzones = 0;
+   zl->nstruc   = nstruc;
+   zl->start    = NULL;
+   zl->end      = NULL;
+
+   return(zl);
+}
+
+
+/************************************************************************/
+/*>void FreeZoneList(ZONELIST *zl)
+   -------------------------------
+   I/O:     ZONELIST  *zl       Zone list
+
+   Frees a zone list. May be given NULL.
+
+   16.10.26 Original   By: ACRM
+*/
+void FreeZoneList(ZONELIST *zl)
+{
+   if(zl == NULL)
+      return;
+
+   FREE(zl->start);
+   FREE(zl->end);
+   free(zl);
+}
+
+
+/************************************************************************/
+/*>ZONELIST *DupZoneList(ZONELIST *zl)
+   -----------------------------------
+   Input:   ZONELIST  *zl       Zone list
+   Returns: ZONELIST  *         Copy of the zone list (NULL if no
+                                memory)
+
+   16.10.26 Original   By: ACRM
+*/
+ZONELIST *DupZoneList(ZONELIST *zl)
+{
+   ZONELIST *dup;
+   int      n = zl->nzones * zl->nstruc;
+
+   if((dup = NewZoneList(zl->nstruc))==NULL)
+      return(NULL);
+
+   if(zl->nzones)
+   {
+      dup->start = (int *)malloc(n * sizeof(int));
+      dup->end   = (int *)malloc(n * sizeof(int));
+      if((dup->start == NULL) || (dup->end == NULL))
+      {
+         FreeZoneList(dup);
+         return(NULL);
+      }
+      memcpy(dup->start, zl->start, n * sizeof(int));
+      memcpy(dup->end,   zl->end,   n * sizeof(int));
+      dup->nzones = dup->maxzones = zl->nzones;
+   }
+
+   return(dup);
+}
+
+
+/************************************************************************/
+/*>BOOL InsertZone(ZONELIST *zl, int pos)
+   --------------------------------------
+   I/O:     ZONELIST  *zl       Zone list
+   Input:   int       pos       Position for the new zone
+   Returns: BOOL                Success
+
+   Opens up a new zone at position pos, moving the zones from there on
+   up by one. pos may be zl->nzones to add a zone at the end. The new
+   zone is set to -1 for each structure.
+
+   16.10.26 Original   By: ACRM
+*/
+BOOL InsertZone(ZONELIST *zl, int pos)
+{
+   int s;
+
+   if(zl->nzones == zl->maxzones)
+   {
+      int maxzones = (zl->maxzones ? 2*zl->maxzones : ZONECHUNK),
+          *start,
+          *end;
+
+      if((start = (int *)realloc(zl->start,
+                                 maxzones * zl->nstruc * sizeof(int)))
+         == NULL)
+         return(FALSE);
+      zl->start = start;
+      if((end = (int *)realloc(zl->end,
+                               maxzones * zl->nstruc * sizeof(int)))
+         == NULL)
+         return(FALSE);
+      zl->end      = end;
+      zl->maxzones = maxzones;
+   }
+
+   if(pos < zl->nzones)
+   {
+      memmove(&ZSTART(zl, pos+1, 0), &ZSTART(zl, pos, 0),
+              (zl->nzones - pos) * zl->nstruc * sizeof(int));
+      memmove(&ZEND(zl, pos+1, 0), &ZEND(zl, pos, 0),
+              (zl->nzones - pos) * zl->nstruc * sizeof(int));
+   }
+   (zl->nzones)++;
+
+   for(s=0; s<zl->nstruc; s++)
+      ZSTART(zl, pos, s) = ZEND(zl, pos, s) = (-1);
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>void DeleteZone(ZONELIST *zl, int z)
+   ------------------------------------
+   I/O:     ZONELIST  *zl       Zone list
+   Input:   int       z         Zone to delete
+
+   Marks a zone for deletion. It stays in the list, but is skipped by
+   everything else, until MergeZones() is called.
+
+   16.10.26 Original   By: ACRM
+*/
+void DeleteZone(ZONELIST *zl, int z)
+{
+   int s;
+
+   for(s=0; s<zl->nstruc; s++)
+      ZSTART(zl, z, s) = ZEND(zl, z, s) = ZONE_DELETED;
+}
+
+
+/************************************************************************/
+/*>BOOL MergeZones(ZONELIST *zl)
+   -----------------------------
+   I/O:     ZONELIST  *zl       Zone list
+   Returns: BOOL                Success (FALSE if no memory)
+
+   Merges zones in the zone list if they overlap and removes zones
+   which are subsets of other zones
+
+   14.11.96 Original   By: ACRM
+   06.12.96 Removes zones marked for deletion
+   13.03.97 Added merging of abutting zones (required since change to
+            zone creation where residues not added to a zone if they
+            are already in another zone stops them from being subsets)
+   26.06.02 Generalized for multiple structures
+            Fixed bug in deleting zones
+   16.10.26 Rewritten for zone arrays. Each stage other than the
+            overlap merge is now a single pass. Copes with the first
+            zone being merged and with all zones having been deleted.
+*/
+BOOL MergeZones(ZONELIST *zl)
+{
+   int  nstruc = zl->nstruc,
+        i, j, s;
+   BOOL finished = FALSE,
+        doit;
+
+   /* Remove null zones                                                 */
+   for(i=0, j=0; i<zl->nzones; i++)
+   {
+      if(!ZONEDELETED(zl, i))
+         CopyZone(zl, i, j++);
+   }
+   zl->nzones = j;
+
+   /* First merge overlapping zones. A zone which overlaps the next one
+      in any structure takes on the end of the next zone. The result of
+      this depends on the order in which zones are updated so we keep
+      to repeated passes; each is linear and there are rarely more than
+      one or two.
+   */
+   while(!finished)
+   {
+      finished = TRUE;
+      for(i=0; i<zl->nzones-1; i++)
+      {
+         for(s=0, doit=FALSE; s<nstruc; s++)
+         {
+            if(ZEND(zl, i, s) >= ZSTART(zl, i+1, s))
+            {
+               doit = TRUE;
+               break;
+            }
+         }
+
+         if(doit)  /* There was a zone overlap                          */
+         {
+            /* Only merge if the zone doesn't already end with the
+               following zone in any structure
+            */
+            for(s=0; s<nstruc; s++)
+            {
+               if(ZEND(zl, i, s) == ZEND(zl, i+1, s))
+               {
+                  doit = FALSE;
+                  break;
+               }
+            }
+
+            if(doit)
+            {
+               finished = FALSE;
+               for(s=0; s<nstruc; s++)
+                  ZEND(zl, i, s) = ZEND(zl, i+1, s);
+            }
+         }
+      }
+   }
+
+   /* Now remove redundant zones                                        */
+   if(!RemoveSubsetZones(zl))
+      return(FALSE);
+
+   /* Now merge abutting zones. A zone which abuts the previous one in
+      every structure absorbs it.
+   */
+   for(i=0, j=0; i<zl->nzones; i++)
+   {
+      if(j)
+      {
+         for(s=0, doit=TRUE; s<nstruc; s++)
+         {
+            if(ZEND(zl, j-1, s)+1 != ZSTART(zl, i, s))
+            {
+               doit = FALSE;
+               break;
+            }
+         }
+
+         if(doit)
+         {
+            for(s=0; s<nstruc; s++)
+               ZSTART(zl, i, s) = ZSTART(zl, j-1, s);
+            j--;
+         }
+      }
+      CopyZone(zl, i, j++);
+   }
+   zl->nzones = j;
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static BOOL RemoveSubsetZones(ZONELIST *zl)
+   -------------------------------------------
+   I/O:     ZONELIST  *zl       Zone list
+   Returns: BOOL                Success (FALSE if no memory)
+
+   Removes zones which, in the first structure, lie within another
+   zone. Where several zones cover exactly the same residues, only the
+   last of them is kept.
+
+   Sorting the zones by start and then by decreasing end means any
+   zone which could contain a zone comes before it. A zone is therefore
+   a subset if an earlier zone with a different range reaches as far.
+
+   16.10.26 Original based on SubsetZone()   By: ACRM
+*/
+static BOOL RemoveSubsetZones(ZONELIST *zl)
+{
+   ZONERANGE *range;
+   BOOL      *keep;
+   int       i, j, k,
+             maxEnd = 0;
+
+   if(zl->nzones < 2)
+      return(TRUE);
+
+   range = (ZONERANGE *)malloc(zl->nzones * sizeof(ZONERANGE));
+   keep  = (BOOL *)malloc(zl->nzones * sizeof(BOOL));
+   if((range == NULL) || (keep == NULL))
+   {
+      FREE(range);
+      FREE(keep);
+      return(FALSE);
+   }
+
+   for(i=0; i<zl->nzones; i++)
+   {
+      range[i].start = ZSTART(zl, i, 0);
+      range[i].end   = ZEND(zl, i, 0);
+      range[i].pos   = i;
+      keep[i]        = TRUE;
+   }
+   qsort(range, zl->nzones, sizeof(ZONERANGE), CompareRanges);
+
+   /* Step through groups of zones with the same range                  */
+   for(i=0; i<zl->nzones; i=j)
+   {
+      for(j=i+1; j<zl->nzones; j++)
+      {
+         if((range[j].start != range[i].start) ||
+            (range[j].end   != range[i].end))
+            break;
+      }
+
+      /* Drop the whole group if an earlier zone covers it; otherwise
+         keep just the last in the list. The group is sorted by
+         position
+      */
+      for(k=i; k<j; k++)
+      {
+         if(((i > 0) && (maxEnd >= range[i].end)) || (k < j-1))
+            keep[range[k].pos] = FALSE;
+      }
+
+      if((i == 0) || (range[i].end > maxEnd))
+         maxEnd = range[i].end;
+   }
+
+   for(i=0, j=0; i<zl->nzones; i++)
+   {
+      if(keep[i])
+         CopyZone(zl, i, j++);
+   }
+   zl->nzones = j;
+
+   free(range);
+   free(keep);
+
+   return(TRUE);
+}
+
+
+/************************************************************************/
+/*>static int CompareRanges(const void *r1, const void *r2)
+   --------------------------------------------------------
+   qsort() comparison for ZONERANGEs. Sorts on start, then on
+   decreasing end, then on position in the list.
+
+   16.10.26 Original   By: ACRM
+*/
+static int CompareRanges(const void *r1, const void *r2)
+{
+   const ZONERANGE *a = (const ZONERANGE *)r1,
+                   *b = (const ZONERANGE *)r2;
+
+   if(a->start != b->start)
+      return((a->start < b->start) ? -1 : 1);
+   if(a->end != b->end)
+      return((a->end > b->end) ? -1 : 1);
+   return((a->pos < b->pos) ? -1 : ((a->pos > b->pos) ? 1 : 0));
+}
+
+
+/************************************************************************/
+/*>static void CopyZone(ZONELIST *zl, int from, int to)
+   ----------------------------------------------------
+   I/O:     ZONELIST  *zl       Zone list
+   Input:   int       from      Zone to copy
+            int       to        Zone to overwrite
+
+   16.10.26 Original   By: ACRM
+*/
+static void CopyZone(ZONELIST *zl, int from, int to)
+{
+   int s;
+
+   if(from == to)
+      return;
+
+   for(s=0; s<zl->nstruc; s++)
+   {
+      ZSTART(zl, to, s) = ZSTART(zl, from, s);
+      ZEND(zl, to, s)   = ZEND(zl, from, s);
+   }
+}
+
+
+/************************************************************************/
+/*>int ReportZoneDiffs(FILE *fp, ZONELIST *zl1, char *label1,
+                       ZONELIST *zl2, char *label2)
+   ----------------------------------------------------------
+   Input:   FILE      *fp       Output file
+            ZONELIST  *zl1      First zone list
+            char      *label1   What to call it
+            ZONELIST  *zl2      Second zone list
+            char      *label2   What to call it
+   Returns: int                 Number of zones found in only one of
+                                the lists
+
+   Lists the zones which are in one list but not the other. Deleted
+   zones are ignored.
+
+   16.10.26 Original   By: ACRM
+*/
+int ReportZoneDiffs(FILE *fp, ZONELIST *zl1, char *label1,
+                    ZONELIST *zl2, char *label2)
+{
+   int z,
+       ndiff = 0;
+
+   for(z=0; z<zl1->nzones; z++)
+   {
+      if(!ZONEDELETED(zl1, z) && !ZoneInList(zl2, zl1, z))
+      {
+         fprintf(fp, "%s only: ", label1);
+         PrintZone(fp, zl1, z);
+         ndiff++;
+      }
+   }
+
+   for(z=0; z<zl2->nzones; z++)
+   {
+      if(!ZONEDELETED(zl2, z) && !ZoneInList(zl1, zl2, z))
+      {
+         fprintf(fp, "%s only: ", label2);
+         PrintZone(fp, zl2, z);
+         ndiff++;
+      }
+   }
+
+   return(ndiff);
+}
+
+
+/************************************************************************/
+/*>static BOOL ZoneInList(ZONELIST *zl, ZONELIST *from, int z)
+   -----------------------------------------------------------
+   Input:   ZONELIST  *zl       Zone list to search
+            ZONELIST  *from     Zone list containing the zone
+            int       z         The zone
+   Returns: BOOL                zl has a zone with exactly the same
+                                starts and ends
+
+   16.10.26 Original   By: ACRM
+*/
+static BOOL ZoneInList(ZONELIST *zl, ZONELIST *from, int z)
+{
+   int i, s;
+
+   for(i=0; i<zl->nzones; i++)
+   {
+      for(s=0; s<zl->nstruc; s++)
+      {
+         if((ZSTART(zl, i, s) != ZSTART(from, z, s)) ||
+            (ZEND(zl, i, s)   != ZEND(from, z, s)))
+            break;
+      }
+      if(s == zl->nstruc)
+         return(TRUE);
+   }
+
+   return(FALSE);
+}
+
+
+/************************************************************************/
+/*>static void PrintZone(FILE *fp, ZONELIST *zl, int z)
+   ----------------------------------------------------
+   Input:   FILE      *fp       Output file
+            ZONELIST  *zl       Zone list
+            int       z         Zone to print
+
+   Prints a zone as start-end for each structure, in the same form as
+   the zones are written out
+
+   16.10.26 Original   By: ACRM
+*/
+static void PrintZone(FILE *fp, ZONELIST *zl, int z)
+{
+   int s;
+
+   for(s=0; s<zl->nstruc; s++)
+      fprintf(fp, "%s%d-%d", (s ? " : " : ""),
+              ZSTART(zl, z, s), ZEND(zl, z, s));
+   fprintf(fp, "\n");
+}
+
+
+/************************************************************************/
+/*>void SetBValByZone(PDB *pdb, ZONELIST *zones, int which)
+   --------------------------------------------------------
+   Set B-values to 10 if in the zones, otherwise to 0.0
+
+   14.11.96 Original   By: ACRM
+   16.10.26 Moved from findcore.c to be shared with findcora
+*/
+void SetBValByZone(PDB *pdb, ZONELIST *zones, int which)
+{
+   PDB  *p;
+   int  z;
+
+   for(p=pdb; p!=NULL; NEXT(p))
+      p->bval = (REAL)0.0;
+
+   for(p=pdb; p!=NULL; NEXT(p))
+   {
+      for(z=0; z<zones->nzones; z++)
+      {
+         if((p->resnum >= ZSTART(zones, z, which)) &&
+            (p->resnum <= ZEND(zones, z, which)))
+            p->bval = (REAL)10.0;
+      }
+   }
+}
@@ -0,0 +1,81 @@
+/*************************************************************************
+
+   Program:    findcore
+   File:       zonelist.h
+
+   Version:    V1.2
+   Date:       16.10.26
+   Function:   Zones of equivalent residues held as a contiguous array
+
+   Copyright:  (c) Prof. Andrew C. R. Martin, UCL 1996-2026
+   Author:     Prof. Andrew C. R. Martin
+   Address:    Biomolecular Structure & Modelling Unit,
+               Department of Biochemistry & Molecular Biology,
+               University College,
+               Gower Street,
+               London.
+               WC1E 6BT.
+   EMail:      andrew@bioinf.org.uk
+
+**************************************************************************
+
+   This program is licensed under the GPL.
+
+**************************************************************************
+
+   Revision History:
+   =================
+   V1.0  16.10.26 Original
+   V1.1  16.10.26 Added DupZoneList() and ReportZoneDiffs()
+   V1.2  16.10.26 Added SetBValByZone() from findcore
+
+*************************************************************************/
+#ifndef _ZONELIST_H
+#define _ZONELIST_H
+
+/************************************************************************/
+/* Includes
+*/
+#include <stdio.h>
+#include "bioplib/SysDefs.h"
+#include "bioplib/pdb.h"
+
+/************************************************************************/
+/* Defines and macros
+*/
+#define ZONE_DELETED (-9999)
+
+/* A list of zones in alignment order. Each zone has a start and end
+   residue number in each of nstruc structures; these are stored
+   nstruc at a time in start[] and end[]
+*/
+typedef struct
+{
+   int nzones,               /* Number of zones                         */
+       maxzones,             /* Number of zones allocated               */
+       nstruc,               /* Number of structures                    */
+       *start,               /* Zone start residue numbers              */
+       *end;                 /* Zone end residue numbers                */
+}  ZONELIST;
+
+/* Start and end of zone z in structure s                               */
+#define ZSTART(zl, z, s) ((zl)->start[(z) * (zl)->nstruc + (s)])
+#define ZEND(zl, z, s)   ((zl)->end[(z) * (zl)->nstruc + (s)])
+
+/* Zones are deleted by setting them to ZONE_DELETED                    */
+#define ZONEDELETED(zl, z) (ZSTART(zl, z, 0) < -9998)
+
+/************************************************************************/
+/* Prototypes
+*/
+ZONELIST *NewZoneList(int nstruc);
+void FreeZoneList(ZONELIST *zl);
+ZONELIST *DupZoneList(ZONELIST *zl);
+BOOL InsertZone(ZONELIST *zl, int pos);
+void DeleteZone(ZONELIST *zl, int z);
+BOOL MergeZones(ZONELIST *zl);
+int ReportZoneDiffs(FILE *fp, ZONELIST *zl1, char *label1,
+                    ZONELIST *zl2, char *label2);
+void SetBValByZone(PDB *pdb, ZONELIST *zones, int which);
+
+#endif